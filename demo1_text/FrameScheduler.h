@@ -0,0 +1,68 @@
+#pragma once
+
+// Decides when the render loop has something new to draw, so a demo
+// whose scene is standing still stops re-rendering identical frames and
+// sleeps until the OS has something for it.
+//
+// The demo calls FrameScheduler_Invalidate whenever something on screen
+// may change: a window message, an animation still in motion, an ImGui
+// widget being dragged, an asset arriving.  Each invalidation asks for a
+// few more frames, which also gives ImGui the frames it needs to settle
+// hover and layout after an input event.  With nothing requested the
+// loop blocks in FrameScheduler_Wait, which returns on the next window
+// message or once max_idle_ms have passed since the last frame.  That
+// idle frame is where state that is only polled (file changes, DirectInput
+// devices, ...) gets picked up.
+//
+// A frame that is drawn isn't necessarily presented.  Only the scene and
+// the UI decide what ends up on screen: FrameScheduler_MarkDirty says the
+// scene (or the window) changed, and ImDrawData::ContentHash tells
+// whether the UI did.  If neither did, FrameScheduler_ShouldPresent
+// returns false and the image already on screen stays.
+
+#include <stdint.h>
+
+// Frames to draw after an input event before going idle again.
+#define FRAME_SCHEDULER_SETTLE_FRAMES   3
+
+struct FrameSchedulerStats {
+    uint32_t    frames;             // drawn during the last full second
+    uint32_t    idle_frames;        // of those, drawn only because max_idle_ms ran out
+    uint32_t    presents;           // of those, presented
+    float       frame_ms;           // average time per frame, waits excluded
+    float       idle_percent;       // time spent blocked in FrameScheduler_Wait
+};
+
+struct FrameScheduler;
+
+// max_idle_ms 0 never redraws an idle scene.
+FrameScheduler *
+FrameScheduler_Create (uint32_t max_idle_ms);
+void
+FrameScheduler_Destroy (FrameScheduler * sched);
+// Draw at least 'frames' more frames.
+void
+FrameScheduler_Invalidate (FrameScheduler * sched, uint32_t frames);
+// What is on screen is out of date (the scene moved, the device was
+// reset, ...): draw and present the next frame.
+void
+FrameScheduler_MarkDirty (FrameScheduler * sched);
+// For the window procedure: invalidates on messages that can change what
+// is on screen (input, paint, size, focus), and marks the window dirty on
+// those that need it repainted.  Others, like the WM_SETTEXT the demo
+// itself causes every frame, don't keep the loop awake.
+void
+FrameScheduler_OnMessage (FrameScheduler * sched, uint32_t msg);
+// Call when the message queue is empty.  True if a frame should be drawn
+// now, in which case it counts as drawn.
+bool
+FrameScheduler_ShouldDraw (FrameScheduler * sched);
+// Call once a drawn frame's UI is built, with its ImDrawData::ContentHash
+// (0 without a UI).  True if the frame has to be rendered and presented.
+bool
+FrameScheduler_ShouldPresent (FrameScheduler * sched, uint64_t ui_hash);
+// Blocks until a window message arrives or the idle interval runs out.
+void
+FrameScheduler_Wait (FrameScheduler * sched);
+FrameSchedulerStats
+FrameScheduler_Stats (FrameScheduler const * sched);
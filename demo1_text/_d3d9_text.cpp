@@ -22,6 +22,9 @@
 
 #include <stdbool.h>
 
+#include "FrameScheduler.h"
+#include "DeviceResources.h"
+
 typedef struct {
     IDirect3DDevice9 *      device;
 
@@ -42,6 +45,12 @@ typedef struct {
 } D3D9RenderContext;
 
 D3D9RenderContext * g_render_ctx = NULL;
+FrameScheduler * g_frame_scheduler = NULL;
+DeviceResources * g_device_resources = NULL;
+
+// The text never changes, so past the frames that input asks for it is
+// only looked at this often.
+#define IDLE_REDRAW_MS  500
 
 static void
 update_scene (float dt) {
@@ -70,12 +79,22 @@ check_device_caps () {
     return true;
 }
 static void
-d3d9_lost_device (D3D9RenderContext * render_ctx) {
-    render_ctx->font->OnLostDevice();
+font_lost (void * user) {
+    ((D3D9RenderContext *)user)->font->OnLostDevice();
+}
+static void
+font_restore (IDirect3DDevice9 * device, void * user) {
+    ((D3D9RenderContext *)user)->font->OnResetDevice();
+}
+static void
+register_device_resources (D3D9RenderContext * render_ctx) {
+    DeviceResourceDesc const desc = {"font", font_lost, font_restore, render_ctx};
+    DeviceResources_Add(g_device_resources, &desc);
 }
 static void
 d3d9_reset_device (D3D9RenderContext * render_ctx) {
-    render_ctx->font->OnResetDevice();
+    DeviceResources_Reset(g_device_resources, &render_ctx->present_params);
+    FrameScheduler_MarkDirty(g_frame_scheduler);
 }
 static bool is_device_lost (D3D9RenderContext * render_ctx) {
     // Get the state of the graphics device.
@@ -92,8 +111,6 @@ static bool is_device_lost (D3D9RenderContext * render_ctx) {
         return true;
     } else if (hr == D3DERR_DEVICENOTRESET) {
         // The device is lost but we can reset and restore it.
-        d3d9_lost_device(render_ctx);
-        render_ctx->device->Reset(&render_ctx->present_params);
         d3d9_reset_device(render_ctx);
         return false;
     } else
@@ -144,8 +161,6 @@ d3d9_enable_fullscreen_mode (D3D9RenderContext * render_ctx, bool enable) {
     }
 
     // Reset the device with the changes.
-    d3d9_lost_device(render_ctx);
-    (render_ctx->device->Reset(&render_ctx->present_params));
     d3d9_reset_device(render_ctx);
 }
 LRESULT
@@ -180,8 +195,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
             } else if (wparam == SIZE_MAXIMIZED) {
                 render_ctx->paused = false;
                 min_maxed = true;
-                d3d9_lost_device(render_ctx);
-                (render_ctx->device->Reset(&render_ctx->present_params));
                 d3d9_reset_device(render_ctx);
             }
             // Restored is any resize that is not a minimize or maximize.
@@ -195,8 +208,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
                 // and are in windowed mode?  Do not execute this code if 
                 // we are restoring to full screen mode.
                 if (min_maxed && render_ctx->present_params.Windowed) {
-                    d3d9_lost_device(render_ctx);
-                    (render_ctx->device->Reset(&render_ctx->present_params));
                     d3d9_reset_device(render_ctx);
                 } else {
                     // No, which implies the user is resizing by dragging
@@ -221,8 +232,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
         GetClientRect(render_ctx->wnd, &client_rect);
         render_ctx->present_params.BackBufferWidth  = client_rect.right;
         render_ctx->present_params.BackBufferHeight = client_rect.bottom;
-        d3d9_lost_device(render_ctx);
-        (render_ctx->device->Reset(&render_ctx->present_params));
         d3d9_reset_device(render_ctx);
 
         return 0;
@@ -250,6 +259,7 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
 
 LRESULT CALLBACK
 wnd_proc (HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
+    FrameScheduler_OnMessage(g_frame_scheduler, msg);
     // Don't start processing messages until the application has been created.
     if (g_render_ctx->initialized)
         return msg_proc(g_render_ctx, msg, wparam, lparam);
@@ -372,6 +382,9 @@ WinMain (
 
 #pragma region Initialize
 
+    // First, as the window procedure reports to it from the start.
+    g_frame_scheduler = FrameScheduler_Create(IDLE_REDRAW_MS);
+
     g_render_ctx = (D3D9RenderContext *)::malloc(sizeof(D3D9RenderContext));
     init_render_ctx(
         g_render_ctx,
@@ -397,6 +410,9 @@ WinMain (
     _tcscpy_s(font_desc.FaceName, _T("Times New Roman"));
 
     D3DXCreateFontIndirect(g_render_ctx->device, &font_desc, &g_render_ctx->font);
+
+    g_device_resources = DeviceResources_Create(g_render_ctx->device);
+    register_device_resources(g_render_ctx);
 #pragma endregion
 #pragma region Main Loop
     MSG  msg;
@@ -416,16 +432,30 @@ WinMain (
                 Sleep(20);
                 continue;
             }
-            if (false == is_device_lost(g_render_ctx)) {
+            // Nothing changed since the last frame: block until something
+            // does or the idle redraw is due.
+            if (false == FrameScheduler_ShouldDraw(g_frame_scheduler)) {
+                FrameScheduler_Wait(g_frame_scheduler);
+                continue;
+            }
+            if (is_device_lost(g_render_ctx)) {
+                // Keep checking until the device can be reset.
+                FrameScheduler_Invalidate(g_frame_scheduler, 1);
+            } else {
                 update_scene(0.0f);
-                draw_scene(g_render_ctx);
+                // The text only has to be presented again after the window
+                // or the device changed.
+                if (FrameScheduler_ShouldPresent(g_frame_scheduler, 0))
+                    draw_scene(g_render_ctx);
             }
         }
     }
 #pragma endregion
 #pragma region Cleanup
 
+    DeviceResources_Destroy(g_device_resources);
     ::free(g_render_ctx);
+    FrameScheduler_Destroy(g_frame_scheduler);
 #pragma endregion
 }
 
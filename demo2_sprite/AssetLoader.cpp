@@ -0,0 +1,102 @@
+#include "AssetLoader.h"
+
+#include <atomic>
+#include <thread>
+
+#include <stdlib.h>
+#include <string.h>
+
+struct AssetLoader {
+    ThreadPool *            pool;
+
+    // Intrusive LIFO of decoded assets.  Workers push with a CAS, the
+    // device thread takes the whole list with one exchange, so neither
+    // side ever waits on the other.
+    std::atomic<Asset *>    done;
+
+    // Only touched by the device thread.
+    uint32_t                submitted;
+    uint32_t                completed;
+};
+
+static void
+decode_task (void * arg) {
+    Asset * asset = (Asset *)arg;
+    AssetLoader * loader = asset->loader;
+
+    // A null path is CPU work with no file behind it, e.g. combining
+    // assets that have already been loaded.
+    asset->ok = (0 == asset->path || MappedFile_Open(&asset->file, asset->path)) && asset->decode(asset);
+
+    Asset * head = loader->done.load(std::memory_order_relaxed);
+    do {
+        asset->next = head;
+    } while (!loader->done.compare_exchange_weak(head, asset, std::memory_order_release, std::memory_order_relaxed));
+}
+
+AssetLoader *
+AssetLoader_Create (ThreadPool * pool) {
+    AssetLoader * loader = new AssetLoader;
+    loader->pool = pool;
+    loader->done.store(0);
+    loader->submitted = 0;
+    loader->completed = 0;
+    return loader;
+}
+void
+AssetLoader_Destroy (AssetLoader * loader) {
+    if (0 == loader)
+        return;
+    // Assets still decoding reference the loader, so wait them out.
+    while (AssetLoader_Pending(loader) > 0) {
+        if (0 == AssetLoader_Pump(loader))
+            std::this_thread::yield();
+    }
+    delete loader;
+}
+void
+AssetLoader_Submit (
+    AssetLoader * loader, char const * path,
+    AssetDecodeFn decode, AssetCompleteFn complete, void * user
+) {
+    Asset * asset = (Asset *)::calloc(1, sizeof(Asset));
+    asset->path     = path;
+    asset->decode   = decode;
+    asset->complete = complete;
+    asset->user     = user;
+    asset->loader   = loader;
+
+    ++loader->submitted;
+    ThreadPool_Submit(loader->pool, decode_task, asset);
+}
+uint32_t
+AssetLoader_Pump (AssetLoader * loader) {
+    Asset * list = loader->done.exchange(0, std::memory_order_acquire);
+    if (0 == list)
+        return 0;
+
+    // Reverse so assets complete in the order they finished decoding.
+    Asset * ordered = 0;
+    while (list) {
+        Asset * next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+
+    uint32_t count = 0;
+    while (ordered) {
+        Asset * next = ordered->next;
+        ordered->complete(ordered);
+        MappedFile_Close(&ordered->file);
+        ::free(ordered);
+        ordered = next;
+        ++count;
+    }
+    loader->completed += count;
+    return count;
+}
+uint32_t
+AssetLoader_Pending (AssetLoader const * loader) {
+    return loader->submitted - loader->completed;
+}
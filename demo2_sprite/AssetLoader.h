@@ -0,0 +1,67 @@
+#pragma once
+
+// Background asset loading.
+//
+// Each asset goes through two stages:
+//   decode   - on a worker thread: the file is memory-mapped and the
+//              decode callback turns it into a CPU-side payload.  No
+//              device calls are allowed here.
+//   complete - on the device thread, from AssetLoader_Pump: the
+//              complete callback creates the D3D resource from the
+//              payload and releases it.
+// Finished assets are handed from the workers to the device thread
+// through a lock-free list, so the render loop never blocks on a load.
+
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct Asset;
+struct AssetLoader;
+
+typedef bool (*AssetDecodeFn) (Asset * asset);
+typedef void (*AssetCompleteFn) (Asset * asset);
+
+struct Asset {
+    char const *        path;
+    AssetDecodeFn       decode;
+    AssetCompleteFn     complete;
+    void *              user;
+
+    // Mapped by the loader before decode, closed after complete.
+    MappedFile          file;
+
+    // Filled in by decode, owned by complete (which is also called when
+    // loading failed, with ok == false, so it can clean up).
+    void *              payload;
+    size_t              payload_size;
+    uint32_t            width;
+    uint32_t            height;
+    bool                ok;
+
+    AssetLoader *       loader;
+    Asset *             next;
+};
+
+// Workers come from the given pool; the loader doesn't own it.
+AssetLoader *
+AssetLoader_Create (ThreadPool * pool);
+// Waits for in-flight decodes and completes them before returning.
+void
+AssetLoader_Destroy (AssetLoader * loader);
+// path must stay valid until the asset completes.  With a null path
+// nothing is mapped and decode just runs on a worker.
+void
+AssetLoader_Submit (
+    AssetLoader * loader, char const * path,
+    AssetDecodeFn decode, AssetCompleteFn complete, void * user
+);
+// Device thread: runs complete for every asset decoded since the last
+// call.  Returns how many completed.
+uint32_t
+AssetLoader_Pump (AssetLoader * loader);
+// Number of submitted assets that haven't completed yet.
+uint32_t
+AssetLoader_Pending (AssetLoader const * loader);
@@ -0,0 +1,131 @@
+#include "Atlas.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <DearImGui/imstb_rectpack.h>
+
+static uint32_t
+round_up (uint32_t v, uint32_t align) {
+    return (v + align - 1) / align * align;
+}
+static void
+fill_cell (uint32_t * page, uint32_t page_size, AtlasImage const * image, uint32_t cx, uint32_t cy, uint32_t cw, uint32_t ch, uint32_t padding) {
+    // The image goes at (padding, padding) in the cell; the rest of the
+    // cell repeats the nearest edge texel.
+    for (uint32_t y = 0; y < ch; ++y) {
+        uint32_t sy = y < padding ? 0 : y - padding;
+        sy = sy < image->height ? sy : image->height - 1;
+        uint32_t const * src = image->pixels + (size_t)sy * image->width;
+        uint32_t * dst = page + (size_t)(cy + y) * page_size + cx;
+        for (uint32_t x = 0; x < padding; ++x)
+            dst[x] = src[0];
+        memcpy(dst + padding, src, image->width * 4);
+        for (uint32_t x = padding + image->width; x < cw; ++x)
+            dst[x] = src[image->width - 1];
+    }
+}
+
+bool
+Atlas_Build (
+    Atlas * atlas,
+    AtlasImage const * images, uint32_t image_count,
+    uint32_t page_size, uint32_t padding, uint32_t mip_levels,
+    AtlasRect * rects
+) {
+    memset(atlas, 0, sizeof(*atlas));
+    if (0 == mip_levels)
+        mip_levels = 1;
+
+    // Pack in units of the smallest level's texel footprint, which keeps
+    // every cell aligned without the packer knowing about it.
+    uint32_t align = 1u << (mip_levels - 1);
+    if (padding < align / 2)
+        padding = align / 2;
+    if (page_size % align || page_size / align > 0xFFFF)
+        return false;
+    int units = (int)(page_size / align);
+
+    stbrp_rect * cells = (stbrp_rect *)::malloc(sizeof(stbrp_rect) * image_count);
+    stbrp_rect * todo = (stbrp_rect *)::malloc(sizeof(stbrp_rect) * image_count);
+    stbrp_node * nodes = (stbrp_node *)::malloc(sizeof(stbrp_node) * units);
+    for (uint32_t i = 0; i < image_count; ++i) {
+        cells[i].id = (int)i;
+        cells[i].w = (stbrp_coord)(round_up(images[i].width + 2 * padding, align) / align);
+        cells[i].h = (stbrp_coord)(round_up(images[i].height + 2 * padding, align) / align);
+        cells[i].was_packed = 0;
+    }
+
+    // Fill pages one after the other with whatever is still unpacked.
+    bool ok = true;
+    uint32_t remaining = image_count;
+    while (remaining > 0) {
+        if (atlas->page_count == ATLAS_MAX_PAGES) {
+            ok = false;
+            break;
+        }
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < image_count; ++i)
+            if (!cells[i].was_packed)
+                todo[n++] = cells[i];
+
+        stbrp_context ctx;
+        stbrp_init_target(&ctx, units, units, nodes, units);
+        stbrp_pack_rects(&ctx, todo, (int)n);
+
+        uint32_t page = atlas->page_count;
+        uint32_t packed = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (!todo[i].was_packed)
+                continue;
+            cells[todo[i].id] = todo[i];
+            rects[todo[i].id].page = page;
+            ++packed;
+        }
+        if (0 == packed) {
+            ok = false;     // too big for an empty page
+            break;
+        }
+        atlas->pages[page].pixels = (uint32_t *)::calloc((size_t)page_size * page_size, 4);
+        ++atlas->page_count;
+        remaining -= packed;
+    }
+
+    if (ok) {
+        atlas->size = page_size;
+        atlas->mip_levels = mip_levels;
+        float inv_size = 1.0f / (float)page_size;
+        for (uint32_t i = 0; i < image_count; ++i) {
+            uint32_t cx = cells[i].x * align, cy = cells[i].y * align;
+            fill_cell(
+                atlas->pages[rects[i].page].pixels, page_size, &images[i],
+                cx, cy, cells[i].w * align, cells[i].h * align, padding
+            );
+
+            AtlasRect * r = &rects[i];
+            r->x        = cx + padding;
+            r->y        = cy + padding;
+            r->width    = images[i].width;
+            r->height   = images[i].height;
+            r->u0       = (float)r->x * inv_size;
+            r->v0       = (float)r->y * inv_size;
+            r->u1       = (float)(r->x + r->width) * inv_size;
+            r->v1       = (float)(r->y + r->height) * inv_size;
+        }
+    } else {
+        Atlas_Release(atlas);
+    }
+
+    ::free(nodes);
+    ::free(todo);
+    ::free(cells);
+    return ok;
+}
+void
+Atlas_Release (Atlas * atlas) {
+    for (uint32_t i = 0; i < atlas->page_count; ++i)
+        ::free(atlas->pages[i].pixels);
+    memset(atlas, 0, sizeof(*atlas));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Packs A8R8G8B8 sprite images into one or a few square atlas pages so
+// sprites sharing a page can be drawn in a single batch.
+//
+// Each image sits in a cell surrounded by a gutter of repeated edge
+// texels.  Cells are aligned to, and sized in multiples of, the block a
+// texel of the smallest mip level covers, so building mips of the page
+// never mixes texels of neighbouring sprites.  Bilinear filtering stays
+// inside the gutter down to that level as long as the padding is at
+// least half a block, which Atlas_Build enforces.
+
+#include <stdint.h>
+
+#define ATLAS_MAX_PAGES 4
+
+struct AtlasImage {
+    uint32_t const *    pixels;     // tightly packed
+    uint32_t            width;
+    uint32_t            height;
+};
+
+struct AtlasRect {
+    uint32_t            page;
+    // Texels of the image itself on the page, gutter excluded.
+    uint32_t            x, y;
+    uint32_t            width, height;
+    float               u0, v0, u1, v1;
+};
+
+struct AtlasPage {
+    uint32_t *          pixels;     // size x size, tightly packed
+};
+
+struct Atlas {
+    uint32_t            size;
+    uint32_t            mip_levels;
+    uint32_t            page_count;
+    AtlasPage           pages[ATLAS_MAX_PAGES];
+};
+
+// Fills rects[i] for images[i].  mip_levels is how many levels the pages
+// will get (1 for none).  Fails if an image can't fit on an empty page or
+// everything doesn't fit on ATLAS_MAX_PAGES pages.
+bool
+Atlas_Build (
+    Atlas * atlas,
+    AtlasImage const * images, uint32_t image_count,
+    uint32_t page_size, uint32_t padding, uint32_t mip_levels,
+    AtlasRect * rects
+);
+void
+Atlas_Release (Atlas * atlas);
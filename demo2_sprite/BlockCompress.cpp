@@ -0,0 +1,554 @@
+#include "BlockCompress.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define BC_SSE
+#include <emmintrin.h>
+#endif
+
+// A 4x4 block split into channels, in A8R8G8B8 memory order (b, g, r, a),
+// values 0..255.  Texels are numbered row by row, as in the index bits.
+struct alignas(16) Block {
+    float   ch[4][16];
+};
+
+enum { CH_B, CH_G, CH_R, CH_A };
+
+static void
+gather_block (uint32_t const * pixels, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, Block * block) {
+    for (uint32_t y = 0; y < 4; ++y) {
+        uint32_t sy = by * 4 + y < height ? by * 4 + y : height - 1;
+        for (uint32_t x = 0; x < 4; ++x) {
+            uint32_t sx = bx * 4 + x < width ? bx * 4 + x : width - 1;
+            uint32_t c = pixels[(size_t)sy * width + sx];
+            for (int k = 0; k < 4; ++k)
+                block->ch[k][y * 4 + x] = (float)((c >> (k * 8)) & 0xFF);
+        }
+    }
+}
+
+//
+// Color (the BC1 block, also the second half of a BC3 block)
+//
+
+static uint16_t
+pack_565 (float const * bgr) {
+    int b = (int)(bgr[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(bgr[1] * 63.0f / 255.0f + 0.5f);
+    int r = (int)(bgr[2] * 31.0f / 255.0f + 0.5f);
+    b = b < 0 ? 0 : (b > 31 ? 31 : b);
+    g = g < 0 ? 0 : (g > 63 ? 63 : g);
+    r = r < 0 ? 0 : (r > 31 ? 31 : r);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+static void
+unpack_565 (uint16_t c, int * bgr) {
+    int b = c & 31, g = (c >> 5) & 63, r = c >> 11;
+    bgr[0] = (b << 3) | (b >> 2);
+    bgr[1] = (g << 2) | (g >> 4);
+    bgr[2] = (r << 3) | (r >> 2);
+}
+// The four-color palette used when c0 > c1 (always, for BC3).
+static void
+color_palette (uint16_t c0, uint16_t c1, float palette[4][3]) {
+    int e0[3], e1[3];
+    unpack_565(c0, e0);
+    unpack_565(c1, e1);
+    for (int k = 0; k < 3; ++k) {
+        palette[0][k] = (float)e0[k];
+        palette[1][k] = (float)e1[k];
+        palette[2][k] = (float)((2 * e0[k] + e1[k]) / 3);
+        palette[3][k] = (float)((e0[k] + 2 * e1[k]) / 3);
+    }
+}
+// Picks the nearest palette entry for every texel; returns the squared
+// error and the packed 2-bit indices.
+static float
+select_color_indices (Block const * block, float const palette[4][3], uint32_t * out_indices) {
+    uint32_t indices = 0;
+    float error = 0.0f;
+#ifdef BC_SSE
+    for (int g = 0; g < 16; g += 4) {
+        __m128 b = _mm_load_ps(&block->ch[CH_B][g]);
+        __m128 gr = _mm_load_ps(&block->ch[CH_G][g]);
+        __m128 r = _mm_load_ps(&block->ch[CH_R][g]);
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i best_index = _mm_setzero_si128();
+        for (int i = 0; i < 4; ++i) {
+            __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[i][0]));
+            __m128 dg = _mm_sub_ps(gr, _mm_set1_ps(palette[i][1]));
+            __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[i][2]));
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(dg, dg)), _mm_mul_ps(dr, dr));
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best = _mm_min_ps(d, best);
+            best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(i)), _mm_andnot_si128(closer, best_index));
+        }
+        alignas(16) int32_t idx[4];
+        alignas(16) float err[4];
+        _mm_store_si128((__m128i *)idx, best_index);
+        _mm_store_ps(err, best);
+        for (int j = 0; j < 4; ++j) {
+            indices |= (uint32_t)idx[j] << (2 * (g + j));
+            error += err[j];
+        }
+    }
+#else
+    for (int t = 0; t < 16; ++t) {
+        float best = FLT_MAX;
+        uint32_t best_index = 0;
+        for (uint32_t i = 0; i < 4; ++i) {
+            float d = 0.0f;
+            for (int k = 0; k < 3; ++k) {
+                float diff = block->ch[k][t] - palette[i][k];
+                d += diff * diff;
+            }
+            if (d < best) {
+                best = d;
+                best_index = i;
+            }
+        }
+        indices |= best_index << (2 * t);
+        error += best;
+    }
+#endif
+    *out_indices = indices;
+    return error;
+}
+
+struct ColorBlock {
+    uint16_t    c0, c1;
+    uint32_t    indices;
+    float       error;
+};
+
+static void
+encode_color_endpoints (Block const * block, float const * e0, float const * e1, ColorBlock * out) {
+    uint16_t c0 = pack_565(e0);
+    uint16_t c1 = pack_565(e1);
+
+    // Four-color mode needs c0 > c1.  Swapping the endpoints swaps
+    // palette entries 0<->1 and 2<->3, i.e. flips each index's low bit.
+    bool swapped = c0 < c1;
+    if (swapped) {
+        uint16_t t = c0;
+        c0 = c1;
+        c1 = t;
+    }
+    float palette[4][3];
+    color_palette(c0, c1, palette);
+
+    out->c0 = c0;
+    out->c1 = c1;
+    out->error = select_color_indices(block, palette, &out->indices);
+    if (c0 == c1)
+        out->indices = 0;   // every entry is the same color
+}
+static void
+color_bounds (Block const * block, float * lo, float * hi) {
+    for (int k = 0; k < 3; ++k) {
+#ifdef BC_SSE
+        __m128 mn = _mm_load_ps(&block->ch[k][0]);
+        __m128 mx = mn;
+        for (int g = 4; g < 16; g += 4) {
+            __m128 v = _mm_load_ps(&block->ch[k][g]);
+            mn = _mm_min_ps(mn, v);
+            mx = _mm_max_ps(mx, v);
+        }
+        mn = _mm_min_ps(mn, _mm_shuffle_ps(mn, mn, _MM_SHUFFLE(1, 0, 3, 2)));
+        mn = _mm_min_ps(mn, _mm_shuffle_ps(mn, mn, _MM_SHUFFLE(2, 3, 0, 1)));
+        mx = _mm_max_ps(mx, _mm_shuffle_ps(mx, mx, _MM_SHUFFLE(1, 0, 3, 2)));
+        mx = _mm_max_ps(mx, _mm_shuffle_ps(mx, mx, _MM_SHUFFLE(2, 3, 0, 1)));
+        lo[k] = _mm_cvtss_f32(mn);
+        hi[k] = _mm_cvtss_f32(mx);
+#else
+        lo[k] = hi[k] = block->ch[k][0];
+        for (int t = 1; t < 16; ++t) {
+            lo[k] = block->ch[k][t] < lo[k] ? block->ch[k][t] : lo[k];
+            hi[k] = block->ch[k][t] > hi[k] ? block->ch[k][t] : hi[k];
+        }
+#endif
+    }
+}
+static void
+compress_color_fast (Block const * block, ColorBlock * out) {
+    float lo[3], hi[3];
+    color_bounds(block, lo, hi);
+
+    // The box diagonal from lo to hi assumes all channels rise together;
+    // flip blue and red when they run against green.
+    float mean[3] = {0, 0, 0};
+    for (int k = 0; k < 3; ++k) {
+        for (int t = 0; t < 16; ++t)
+            mean[k] += block->ch[k][t];
+        mean[k] /= 16.0f;
+    }
+    float cov_bg = 0.0f, cov_rg = 0.0f;
+    for (int t = 0; t < 16; ++t) {
+        float g = block->ch[CH_G][t] - mean[CH_G];
+        cov_bg += (block->ch[CH_B][t] - mean[CH_B]) * g;
+        cov_rg += (block->ch[CH_R][t] - mean[CH_R]) * g;
+    }
+    if (cov_bg < 0.0f) { float t = lo[CH_B]; lo[CH_B] = hi[CH_B]; hi[CH_B] = t; }
+    if (cov_rg < 0.0f) { float t = lo[CH_R]; lo[CH_R] = hi[CH_R]; hi[CH_R] = t; }
+
+    // Inset by 1/16 of the range; the extremes are rarely hit exactly
+    // and the interpolated entries land closer to the bulk of the texels.
+    for (int k = 0; k < 3; ++k) {
+        float inset = (hi[k] - lo[k]) / 16.0f;
+        hi[k] -= inset;
+        lo[k] += inset;
+    }
+    encode_color_endpoints(block, hi, lo, out);
+}
+static void
+compress_color_high (Block const * block, ColorBlock * out) {
+    // Principal axis of the colors by power iteration on the covariance.
+    float mean[3] = {0, 0, 0};
+    for (int k = 0; k < 3; ++k) {
+        for (int t = 0; t < 16; ++t)
+            mean[k] += block->ch[k][t];
+        mean[k] /= 16.0f;
+    }
+    float cov[3][3] = {};
+    for (int t = 0; t < 16; ++t) {
+        float d[3];
+        for (int k = 0; k < 3; ++k)
+            d[k] = block->ch[k][t] - mean[k];
+        for (int i = 0; i < 3; ++i)
+            for (int j = 0; j < 3; ++j)
+                cov[i][j] += d[i] * d[j];
+    }
+    float lo[3], hi[3];
+    color_bounds(block, lo, hi);
+    float axis[3] = {hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]};
+    for (int it = 0; it < 8; ++it) {
+        float n[3];
+        for (int i = 0; i < 3; ++i)
+            n[i] = cov[i][0] * axis[0] + cov[i][1] * axis[1] + cov[i][2] * axis[2];
+        float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len < 1e-6f)
+            break;
+        for (int i = 0; i < 3; ++i)
+            axis[i] = n[i] / len;
+    }
+    float len = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    if (len < 1e-6f) {
+        // Flat block: a single color.
+        encode_color_endpoints(block, mean, mean, out);
+        return;
+    }
+    for (int i = 0; i < 3; ++i)
+        axis[i] /= len;
+
+    float tmin = FLT_MAX, tmax = -FLT_MAX;
+    for (int t = 0; t < 16; ++t) {
+        float p = 0.0f;
+        for (int k = 0; k < 3; ++k)
+            p += (block->ch[k][t] - mean[k]) * axis[k];
+        tmin = p < tmin ? p : tmin;
+        tmax = p > tmax ? p : tmax;
+    }
+    float e0[3], e1[3];
+    for (int k = 0; k < 3; ++k) {
+        e0[k] = mean[k] + axis[k] * tmax;
+        e1[k] = mean[k] + axis[k] * tmin;
+    }
+    encode_color_endpoints(block, e0, e1, out);
+
+    // Least-squares refit of the endpoints to the chosen indices; keep
+    // whichever result has the lower error.
+    static float const w0_of_index[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+    for (int it = 0; it < 2 && out->error > 0.0f; ++it) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[3] = {0, 0, 0}, bp[3] = {0, 0, 0};
+        for (int t = 0; t < 16; ++t) {
+            float w0 = w0_of_index[(out->indices >> (2 * t)) & 3];
+            float w1 = 1.0f - w0;
+            aa += w0 * w0;
+            ab += w0 * w1;
+            bb += w1 * w1;
+            for (int k = 0; k < 3; ++k) {
+                ap[k] += w0 * block->ch[k][t];
+                bp[k] += w1 * block->ch[k][t];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            break;
+        for (int k = 0; k < 3; ++k) {
+            e0[k] = (ap[k] * bb - bp[k] * ab) / det;
+            e1[k] = (bp[k] * aa - ap[k] * ab) / det;
+        }
+        ColorBlock refined;
+        encode_color_endpoints(block, e0, e1, &refined);
+        if (refined.error >= out->error)
+            break;
+        *out = refined;
+    }
+}
+static void
+write_color_block (ColorBlock const * cb, uint8_t * dst) {
+    dst[0] = (uint8_t)cb->c0;
+    dst[1] = (uint8_t)(cb->c0 >> 8);
+    dst[2] = (uint8_t)cb->c1;
+    dst[3] = (uint8_t)(cb->c1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        dst[4 + i] = (uint8_t)(cb->indices >> (8 * i));
+}
+
+//
+// Alpha (first half of a BC3 block)
+//
+
+// Entries 0 and 1 are the endpoints.  With a0 > a1 the other six are
+// interpolated; otherwise four are, followed by 0 and 255.
+static void
+alpha_palette (int a0, int a1, float palette[8]) {
+    palette[0] = (float)a0;
+    palette[1] = (float)a1;
+    if (a0 > a1) {
+        for (int i = 1; i <= 6; ++i)
+            palette[1 + i] = (float)(((7 - i) * a0 + i * a1) / 7);
+    } else {
+        for (int i = 1; i <= 4; ++i)
+            palette[1 + i] = (float)(((5 - i) * a0 + i * a1) / 5);
+        palette[6] = 0.0f;
+        palette[7] = 255.0f;
+    }
+}
+static float
+select_alpha_indices (Block const * block, float const palette[8], uint64_t * out_indices) {
+    uint64_t indices = 0;
+    float error = 0.0f;
+#ifdef BC_SSE
+    for (int g = 0; g < 16; g += 4) {
+        __m128 a = _mm_load_ps(&block->ch[CH_A][g]);
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i best_index = _mm_setzero_si128();
+        for (int i = 0; i < 8; ++i) {
+            __m128 d = _mm_sub_ps(a, _mm_set1_ps(palette[i]));
+            d = _mm_mul_ps(d, d);
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best = _mm_min_ps(d, best);
+            best_index = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(i)), _mm_andnot_si128(closer, best_index));
+        }
+        alignas(16) int32_t idx[4];
+        alignas(16) float err[4];
+        _mm_store_si128((__m128i *)idx, best_index);
+        _mm_store_ps(err, best);
+        for (int j = 0; j < 4; ++j) {
+            indices |= (uint64_t)idx[j] << (3 * (g + j));
+            error += err[j];
+        }
+    }
+#else
+    for (int t = 0; t < 16; ++t) {
+        float best = FLT_MAX;
+        uint64_t best_index = 0;
+        for (int i = 0; i < 8; ++i) {
+            float d = (block->ch[CH_A][t] - palette[i]) * (block->ch[CH_A][t] - palette[i]);
+            if (d < best) {
+                best = d;
+                best_index = (uint64_t)i;
+            }
+        }
+        indices |= best_index << (3 * t);
+        error += best;
+    }
+#endif
+    *out_indices = indices;
+    return error;
+}
+
+struct AlphaBlock {
+    uint8_t     a0, a1;
+    uint64_t    indices;
+    float       error;
+};
+
+static void
+encode_alpha_endpoints (Block const * block, int a0, int a1, AlphaBlock * out) {
+    float palette[8];
+    alpha_palette(a0, a1, palette);
+    out->a0 = (uint8_t)a0;
+    out->a1 = (uint8_t)a1;
+    out->error = select_alpha_indices(block, palette, &out->indices);
+}
+static void
+compress_alpha (Block const * block, BcQuality quality, AlphaBlock * out) {
+    float lo = 255.0f, hi = 0.0f;
+    float inner_lo = 255.0f, inner_hi = 0.0f;
+    for (int t = 0; t < 16; ++t) {
+        float a = block->ch[CH_A][t];
+        lo = a < lo ? a : lo;
+        hi = a > hi ? a : hi;
+        if (a > 0.0f && a < 255.0f) {
+            inner_lo = a < inner_lo ? a : inner_lo;
+            inner_hi = a > inner_hi ? a : inner_hi;
+        }
+    }
+
+    // Eight-entry mode spanning the full range.  Equal endpoints would
+    // select the other mode, so keep them apart by at least one.
+    int a0 = (int)hi, a1 = (int)lo;
+    if (a0 == a1) {
+        if (a0 < 255) ++a0; else --a1;
+    }
+    encode_alpha_endpoints(block, a0, a1, out);
+    if (quality == BC_QUALITY_FAST || 0.0f == out->error)
+        return;
+
+    // Six-entry mode: interpolate the values strictly between 0 and 255
+    // and let the explicit 0/255 entries pick up the rest.  Usually the
+    // better choice for cut-out sprites.
+    if (inner_lo > inner_hi)
+        inner_lo = inner_hi = 0.0f;
+    AlphaBlock six;
+    encode_alpha_endpoints(block, (int)inner_lo, (int)inner_hi, &six);
+    if (six.error < out->error)
+        *out = six;
+}
+static void
+write_alpha_block (AlphaBlock const * ab, uint8_t * dst) {
+    dst[0] = ab->a0;
+    dst[1] = ab->a1;
+    for (int i = 0; i < 6; ++i)
+        dst[2 + i] = (uint8_t)(ab->indices >> (8 * i));
+}
+
+//
+// Images
+//
+
+struct EncodeJob {
+    BcFormat            format;
+    BcQuality           quality;
+    uint32_t const *    pixels;
+    uint32_t            width, height;
+    uint8_t *           dst;
+    size_t              dst_pitch;
+};
+
+static void
+encode_block_rows (void * ctx, uint32_t begin, uint32_t end) {
+    EncodeJob const * job = (EncodeJob const *)ctx;
+    uint32_t blocks_x = (job->width + 3) / 4;
+    size_t block_size = job->format == BC_FORMAT_BC1 ? 8 : 16;
+    for (uint32_t by = begin; by < end; ++by) {
+        uint8_t * dst = job->dst + by * job->dst_pitch;
+        for (uint32_t bx = 0; bx < blocks_x; ++bx, dst += block_size) {
+            Block block;
+            gather_block(job->pixels, job->width, job->height, bx, by, &block);
+
+            uint8_t * color_dst = dst;
+            if (job->format == BC_FORMAT_BC3) {
+                AlphaBlock ab;
+                compress_alpha(&block, job->quality, &ab);
+                write_alpha_block(&ab, dst);
+                color_dst = dst + 8;
+            }
+            ColorBlock cb;
+            if (job->quality == BC_QUALITY_HIGH)
+                compress_color_high(&block, &cb);
+            else
+                compress_color_fast(&block, &cb);
+            write_color_block(&cb, color_dst);
+        }
+    }
+}
+
+uint32_t
+BlockCompress_Pitch (BcFormat format, uint32_t width) {
+    return ((width + 3) / 4) * (format == BC_FORMAT_BC1 ? 8 : 16);
+}
+size_t
+BlockCompress_Size (BcFormat format, uint32_t width, uint32_t height) {
+    return (size_t)BlockCompress_Pitch(format, width) * ((height + 3) / 4);
+}
+void
+BlockCompress_Encode (
+    BcFormat format, BcQuality quality,
+    uint32_t const * pixels, uint32_t width, uint32_t height,
+    void * dst, size_t dst_pitch,
+    ThreadPool * pool
+) {
+    EncodeJob job;
+    job.format      = format;
+    job.quality     = quality;
+    job.pixels      = pixels;
+    job.width       = width;
+    job.height      = height;
+    job.dst         = (uint8_t *)dst;
+    job.dst_pitch   = dst_pitch;
+
+    uint32_t block_rows = (height + 3) / 4;
+    if (pool)
+        ThreadPool_ParallelFor(pool, block_rows, 1, encode_block_rows, &job);
+    else
+        encode_block_rows(&job, 0, block_rows);
+}
+void
+BlockCompress_Decode (
+    BcFormat format,
+    void const * src, size_t src_pitch, uint32_t width, uint32_t height,
+    uint32_t * pixels
+) {
+    size_t block_size = format == BC_FORMAT_BC1 ? 8 : 16;
+    for (uint32_t by = 0; by < (height + 3) / 4; ++by) {
+        uint8_t const * block = (uint8_t const *)src + by * src_pitch;
+        for (uint32_t bx = 0; bx < (width + 3) / 4; ++bx, block += block_size) {
+            uint32_t alpha[16];
+            uint8_t const * color = block;
+            if (format == BC_FORMAT_BC3) {
+                float palette[8];
+                alpha_palette(block[0], block[1], palette);
+                uint64_t bits = 0;
+                for (int i = 0; i < 6; ++i)
+                    bits |= (uint64_t)block[2 + i] << (8 * i);
+                for (int t = 0; t < 16; ++t)
+                    alpha[t] = (uint32_t)palette[(bits >> (3 * t)) & 7];
+                color = block + 8;
+            } else {
+                for (int t = 0; t < 16; ++t)
+                    alpha[t] = 255;
+            }
+
+            uint16_t c0 = (uint16_t)(color[0] | (color[1] << 8));
+            uint16_t c1 = (uint16_t)(color[2] | (color[3] << 8));
+            uint32_t bits = color[4] | (color[5] << 8) | (color[6] << 16) | ((uint32_t)color[7] << 24);
+            uint32_t palette[4];
+            int e0[3], e1[3];
+            unpack_565(c0, e0);
+            unpack_565(c1, e1);
+            bool four = format == BC_FORMAT_BC3 || c0 > c1;
+            for (int i = 0; i < 4; ++i) {
+                uint32_t c = 0xFF000000;
+                for (int k = 0; k < 3; ++k) {
+                    int v;
+                    if (i == 0)         v = e0[k];
+                    else if (i == 1)    v = e1[k];
+                    else if (four)      v = i == 2 ? (2 * e0[k] + e1[k]) / 3 : (e0[k] + 2 * e1[k]) / 3;
+                    else                v = i == 2 ? (e0[k] + e1[k]) / 2 : 0;
+                    c |= (uint32_t)v << (k * 8);
+                }
+                // Three-color BC1 blocks use the last entry for transparent black.
+                if (!four && i == 3)
+                    c = 0;
+                palette[i] = c;
+            }
+
+            for (uint32_t y = 0; y < 4 && by * 4 + y < height; ++y) {
+                for (uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                    int t = y * 4 + x;
+                    uint32_t c = palette[(bits >> (2 * t)) & 3];
+                    if (format == BC_FORMAT_BC3)
+                        c = (c & 0x00FFFFFF) | (alpha[t] << 24);
+                    pixels[(size_t)(by * 4 + y) * width + bx * 4 + x] = c;
+                }
+            }
+        }
+    }
+}
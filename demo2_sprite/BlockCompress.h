@@ -0,0 +1,50 @@
+#pragma once
+
+// BC1 (DXT1) and BC3 (DXT5) block compression for A8R8G8B8 images, plus
+// the matching decoders so the encoder's output can be checked without
+// a GPU.
+//
+// BC1 stores opaque color at 4 bits per texel; BC3 adds an interpolated
+// alpha block for 8 bits per texel.  Images whose sides aren't multiples
+// of 4 are padded by repeating the last row/column.
+
+#include "ThreadPool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum BcFormat {
+    BC_FORMAT_BC1,
+    BC_FORMAT_BC3,
+};
+
+enum BcQuality {
+    // Bounding-box endpoints: cheap enough to run on every load.
+    BC_QUALITY_FAST,
+    // Principal-axis endpoints refined by least squares, and both alpha
+    // modes tried for BC3.
+    BC_QUALITY_HIGH,
+};
+
+// Bytes needed for a width x height image (a row of blocks is
+// BlockCompress_Pitch bytes).
+size_t
+BlockCompress_Size (BcFormat format, uint32_t width, uint32_t height);
+uint32_t
+BlockCompress_Pitch (BcFormat format, uint32_t width);
+// Encodes the image into dst, rows of blocks dst_pitch bytes apart.  Rows
+// of blocks are spread across the pool's workers when one is given.
+void
+BlockCompress_Encode (
+    BcFormat format, BcQuality quality,
+    uint32_t const * pixels, uint32_t width, uint32_t height,
+    void * dst, size_t dst_pitch,
+    ThreadPool * pool
+);
+// Decodes back to tightly packed A8R8G8B8.
+void
+BlockCompress_Decode (
+    BcFormat format,
+    void const * src, size_t src_pitch, uint32_t width, uint32_t height,
+    uint32_t * pixels
+);
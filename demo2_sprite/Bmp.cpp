@@ -0,0 +1,182 @@
+#include "Bmp.h"
+
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define BMP_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BMP_TARGET_SSSE3
+#else
+#include <cpuid.h>
+#define BMP_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
+// BITMAPFILEHEADER is 14 bytes; the info header that follows starts
+// with the BITMAPINFOHEADER fields whatever its version.
+static size_t const file_header_size = 14;
+static uint32_t const bi_rgb        = 0;
+static uint32_t const bi_bitfields  = 3;
+
+static uint16_t
+read_u16 (uint8_t const * p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+static uint32_t
+read_u32 (uint8_t const * p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool
+Bmp_ReadInfo (void const * data, size_t size, BmpInfo * info) {
+    memset(info, 0, sizeof(*info));
+    uint8_t const * bytes = (uint8_t const *)data;
+    if (size < file_header_size + 40 || bytes[0] != 'B' || bytes[1] != 'M')
+        return false;
+
+    uint8_t const * ih = bytes + file_header_size;
+    uint32_t header_size    = read_u32(ih + 0);
+    int32_t width           = (int32_t)read_u32(ih + 4);
+    int32_t height          = (int32_t)read_u32(ih + 8);
+    uint16_t planes         = read_u16(ih + 12);
+    uint16_t bpp            = read_u16(ih + 14);
+    uint32_t compression    = read_u32(ih + 16);
+    if (header_size < 40 || planes != 1 || (bpp != 24 && bpp != 32))
+        return false;
+    if (width <= 0 || height == 0 || height == INT32_MIN)
+        return false;
+
+    // Bitfields are only accepted when they describe the plain BGRA
+    // layout; the masks follow a 40-byte header or live inside a larger one.
+    if (compression == bi_bitfields) {
+        if (bpp != 32 || size < file_header_size + 40 + 12)
+            return false;
+        uint8_t const * masks = ih + 40;
+        if (read_u32(masks + 0) != 0x00FF0000 || read_u32(masks + 4) != 0x0000FF00 || read_u32(masks + 8) != 0x000000FF)
+            return false;
+    } else if (compression != bi_rgb) {
+        return false;
+    }
+
+    // Sizes are worked out in 64 bits so a huge width can't wrap the
+    // pitch around to something small that passes the size check.
+    uint64_t row_bytes  = (uint64_t)(uint32_t)width * bpp / 8;
+    uint64_t pitch      = ((uint64_t)(uint32_t)width * bpp + 31) / 32 * 4;
+    if (pitch > size || row_bytes > pitch)
+        return false;
+
+    info->width             = (uint32_t)width;
+    info->height            = (uint32_t)(height < 0 ? -(int64_t)height : height);
+    info->bits_per_pixel    = bpp;
+    info->top_down          = height < 0;
+    info->pixel_offset      = read_u32(bytes + 10);
+    info->src_pitch         = (uint32_t)pitch;
+
+    uint64_t end = (uint64_t)info->pixel_offset + pitch * info->height;
+    return info->pixel_offset >= file_header_size + header_size && end <= size;
+}
+
+// Row converters.  'alpha' is OR'ed into every pixel (0 keeps the file's
+// alpha), 'key_mask' is 0xFFFFFFFF when color keying is on, 0 otherwise.
+
+static void
+convert_row_32 (uint32_t * dst, uint8_t const * src, uint32_t count, uint32_t alpha, uint32_t key, uint32_t key_mask) {
+    uint32_t i = 0;
+#ifdef BMP_X86
+    __m128i const v_alpha   = _mm_set1_epi32((int)alpha);
+    __m128i const v_rgb     = _mm_set1_epi32(0x00FFFFFF);
+    __m128i const v_key     = _mm_set1_epi32((int)key);
+    __m128i const v_keymask = _mm_set1_epi32((int)(key_mask & 0xFF000000));
+    for (; i + 4 <= count; i += 4) {
+        __m128i px = _mm_or_si128(_mm_loadu_si128((__m128i const *)(src + i * 4)), v_alpha);
+        __m128i hit = _mm_cmpeq_epi32(_mm_and_si128(px, v_rgb), v_key);
+        px = _mm_andnot_si128(_mm_and_si128(hit, v_keymask), px);
+        _mm_storeu_si128((__m128i *)(dst + i), px);
+    }
+#endif
+    for (; i < count; ++i) {
+        uint32_t px = read_u32(src + i * 4) | alpha;
+        if ((px & 0x00FFFFFF) == key)
+            px &= ~(key_mask & 0xFF000000);
+        dst[i] = px;
+    }
+}
+static void
+convert_row_24_scalar (uint32_t * dst, uint8_t const * src, uint32_t count, uint32_t key, uint32_t key_mask) {
+    for (uint32_t i = 0; i < count; ++i) {
+        uint8_t const * p = src + i * 3;
+        uint32_t px = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | 0xFF000000;
+        if ((px & 0x00FFFFFF) == key)
+            px &= ~(key_mask & 0xFF000000);
+        dst[i] = px;
+    }
+}
+#ifdef BMP_X86
+BMP_TARGET_SSSE3 static void
+convert_row_24_ssse3 (uint32_t * dst, uint8_t const * src, uint32_t count, uint32_t key, uint32_t key_mask) {
+    // Expand 4 BGR triplets to BGRA with one shuffle.  Each load reads 16
+    // bytes but only uses 12, so stop while 6 pixels still remain to stay
+    // inside the row.
+    __m128i const shuffle   = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m128i const v_alpha   = _mm_set1_epi32((int)0xFF000000);
+    __m128i const v_rgb     = _mm_set1_epi32(0x00FFFFFF);
+    __m128i const v_key     = _mm_set1_epi32((int)key);
+    __m128i const v_keymask = _mm_set1_epi32((int)(key_mask & 0xFF000000));
+    uint32_t i = 0;
+    for (; i + 6 <= count; i += 4) {
+        __m128i bgr = _mm_loadu_si128((__m128i const *)(src + i * 3));
+        __m128i px = _mm_or_si128(_mm_shuffle_epi8(bgr, shuffle), v_alpha);
+        __m128i hit = _mm_cmpeq_epi32(_mm_and_si128(px, v_rgb), v_key);
+        px = _mm_andnot_si128(_mm_and_si128(hit, v_keymask), px);
+        _mm_storeu_si128((__m128i *)(dst + i), px);
+    }
+    convert_row_24_scalar(dst + i, src + i * 3, count - i, key, key_mask);
+}
+static bool
+cpu_has_ssse3 () {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[2] & (1 << 9)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (ecx & (1 << 9)) != 0;
+#endif
+}
+#endif
+
+void
+Bmp_Decode (
+    void const * data, BmpInfo const * info,
+    uint32_t flags, uint32_t color_key,
+    void * dst, size_t dst_pitch
+) {
+    typedef void (*ConvertRow24Fn) (uint32_t *, uint8_t const *, uint32_t, uint32_t, uint32_t);
+    ConvertRow24Fn convert_row_24 = convert_row_24_scalar;
+#ifdef BMP_X86
+    static bool const has_ssse3 = cpu_has_ssse3();
+    if (has_ssse3)
+        convert_row_24 = convert_row_24_ssse3;
+#endif
+
+    uint32_t alpha      = (flags & BMP_FILE_ALPHA) && info->bits_per_pixel == 32 ? 0 : 0xFF000000;
+    uint32_t key        = color_key & 0x00FFFFFF;
+    uint32_t key_mask   = (flags & BMP_COLOR_KEY) ? 0xFFFFFFFF : 0;
+
+    uint8_t const * pixels = (uint8_t const *)data + info->pixel_offset;
+    for (uint32_t y = 0; y < info->height; ++y) {
+        // Bottom-up files store the last row first.
+        uint32_t src_row = info->top_down ? y : info->height - 1 - y;
+        uint8_t const * src = pixels + (size_t)src_row * info->src_pitch;
+        uint32_t * row = (uint32_t *)((uint8_t *)dst + y * dst_pitch);
+        if (info->bits_per_pixel == 32)
+            convert_row_32(row, src, info->width, alpha, key, key_mask);
+        else
+            convert_row_24(row, src, info->width, key, key_mask);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Minimal BMP decoder for the demo textures: uncompressed 24- and 32-bit
+// images, stored bottom-up or top-down.  Pixels are converted to
+// A8R8G8B8 (B, G, R, A in memory) one row at a time, straight from the
+// source bytes (typically a memory mapping) into the caller's buffer.
+// It doesn't depend on Windows or D3DX.
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+    // Keep the alpha channel of 32-bit files; otherwise alpha is 0xFF.
+    BMP_FILE_ALPHA  = 1 << 0,
+    // Pixels whose RGB equals the color key get alpha 0.
+    BMP_COLOR_KEY   = 1 << 1,
+};
+
+struct BmpInfo {
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    bits_per_pixel;     // 24 or 32
+    bool        top_down;
+
+    uint32_t    pixel_offset;       // from the start of the file
+    uint32_t    src_pitch;          // rows are padded to 4 bytes
+};
+
+// Parses and validates the headers.  Fails for anything the decoder
+// can't handle (palettes, RLE, unusual bitfields) or for a file that is
+// too short for the pixel array it describes.
+bool
+Bmp_ReadInfo (void const * data, size_t size, BmpInfo * info);
+// Writes info->height rows of info->width pixels to dst, top row first,
+// dst_pitch bytes apart.  color_key is 0x00RRGGBB.
+void
+Bmp_Decode (
+    void const * data, BmpInfo const * info,
+    uint32_t flags, uint32_t color_key,
+    void * dst, size_t dst_pitch
+);
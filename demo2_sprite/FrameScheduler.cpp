@@ -0,0 +1,154 @@
+#include "FrameScheduler.h"
+
+#include <chrono>
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <thread>
+#endif
+
+struct FrameScheduler {
+    int64_t                 max_idle_us;
+    uint32_t                requested;      // frames still owed to invalidations
+    int64_t                 last_frame_us;
+    bool                    dirty;          // the next frame has to be presented
+    uint64_t                ui_hash;        // of the last frame checked for presenting
+
+    // Stats, gathered over one second and published when it ends.
+    int64_t                 window_start_us;
+    uint32_t                frames;
+    uint32_t                idle_frames;
+    uint32_t                presents;
+    int64_t                 wait_us;
+    FrameSchedulerStats     stats;
+};
+
+static int64_t
+now_us () {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+static void
+roll_stats (FrameScheduler * sched, int64_t now) {
+    int64_t elapsed = now - sched->window_start_us;
+    if (elapsed < 1000000)
+        return;
+    sched->stats.frames         = sched->frames;
+    sched->stats.idle_frames    = sched->idle_frames;
+    sched->stats.presents       = sched->presents;
+    sched->stats.frame_ms       = sched->frames ? (float)(elapsed - sched->wait_us) / (1000.0f * (float)sched->frames) : 0.0f;
+    sched->stats.idle_percent   = 100.0f * (float)sched->wait_us / (float)elapsed;
+    sched->window_start_us = now;
+    sched->frames = 0;
+    sched->idle_frames = 0;
+    sched->presents = 0;
+    sched->wait_us = 0;
+}
+
+FrameScheduler *
+FrameScheduler_Create (uint32_t max_idle_ms) {
+    FrameScheduler * sched = (FrameScheduler *)::calloc(1, sizeof(FrameScheduler));
+    sched->max_idle_us = (int64_t)max_idle_ms * 1000;
+    sched->requested = FRAME_SCHEDULER_SETTLE_FRAMES;
+    sched->dirty = true;
+    sched->last_frame_us = now_us();
+    sched->window_start_us = sched->last_frame_us;
+    return sched;
+}
+void
+FrameScheduler_Destroy (FrameScheduler * sched) {
+    ::free(sched);
+}
+void
+FrameScheduler_Invalidate (FrameScheduler * sched, uint32_t frames) {
+    if (frames > sched->requested)
+        sched->requested = frames;
+}
+void
+FrameScheduler_MarkDirty (FrameScheduler * sched) {
+    sched->dirty = true;
+    FrameScheduler_Invalidate(sched, 1);
+}
+void
+FrameScheduler_OnMessage (FrameScheduler * sched, uint32_t msg) {
+#ifdef _WIN32
+    switch (msg) {
+    case WM_PAINT:
+    case WM_SIZE:
+    case WM_EXITSIZEMOVE:
+    case WM_DISPLAYCHANGE:
+        sched->dirty = true;
+        break;
+    case WM_ACTIVATE:
+    case WM_SETFOCUS:
+    case WM_KILLFOCUS:
+        break;
+    default:
+        if ((msg >= WM_KEYFIRST && msg <= WM_KEYLAST) || (msg >= WM_MOUSEFIRST && msg <= WM_MOUSELAST))
+            break;
+        return;
+    }
+    FrameScheduler_Invalidate(sched, FRAME_SCHEDULER_SETTLE_FRAMES);
+#else
+    (void)sched;
+    (void)msg;
+#endif
+}
+bool
+FrameScheduler_ShouldDraw (FrameScheduler * sched) {
+    int64_t now = now_us();
+    roll_stats(sched, now);
+
+    if (sched->requested > 0) {
+        --sched->requested;
+    } else {
+        if (0 == sched->max_idle_us || now - sched->last_frame_us < sched->max_idle_us)
+            return false;
+        ++sched->idle_frames;
+    }
+    sched->last_frame_us = now;
+    ++sched->frames;
+    return true;
+}
+bool
+FrameScheduler_ShouldPresent (FrameScheduler * sched, uint64_t ui_hash) {
+    bool present = sched->dirty || ui_hash != sched->ui_hash;
+    sched->dirty = false;
+    sched->ui_hash = ui_hash;
+    if (present)
+        ++sched->presents;
+    return present;
+}
+void
+FrameScheduler_Wait (FrameScheduler * sched) {
+    int64_t start = now_us();
+    int64_t timeout_us = -1;
+    if (sched->max_idle_us > 0) {
+        timeout_us = sched->last_frame_us + sched->max_idle_us - start;
+        if (timeout_us < 0)
+            timeout_us = 0;
+    }
+
+#ifdef _WIN32
+    // MWMO_INPUTAVAILABLE also returns for input that is already queued
+    // but was seen (and not removed) by an earlier peek.
+    DWORD timeout = timeout_us < 0 ? INFINITE : (DWORD)((timeout_us + 999) / 1000);
+    MsgWaitForMultipleObjectsEx(0, 0, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+#else
+    // No message queue to wait on; sleep in short steps so the caller
+    // keeps polling its other sources.
+    if (timeout_us < 0 || timeout_us > 16000)
+        timeout_us = 16000;
+    std::this_thread::sleep_for(std::chrono::microseconds(timeout_us));
+#endif
+
+    sched->wait_us += now_us() - start;
+}
+FrameSchedulerStats
+FrameScheduler_Stats (FrameScheduler const * sched) {
+    return sched->stats;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Common.h"
+#include "DeviceResources.h"
+
+// One dynamic vertex buffer and one 16-bit index buffer that everything
+// streaming geometry each frame (ImGui, sprite batches, ...) allocates
+// from, instead of each keeping and re-creating its own.
+//
+// Allocations are appended with D3DLOCK_NOOVERWRITE, so the GPU keeps
+// reading what earlier draws wrote.  When the end is reached the ring
+// starts over at zero with D3DLOCK_DISCARD and the driver hands out fresh
+// memory.  GeometryRing_BeginFrame fences the frames: it closes the
+// previous frame's usage, and a frame that needed more than the whole
+// buffer grows it, so steady state costs at most one discard per frame.
+//
+// The buffers live in the DeviceResources registry and come back by
+// themselves after a reset.  Bind them after locking, since a lock may
+// replace them.
+
+struct GeometryRingSpan {
+    void *      data;       // write-only
+    UINT        first;      // first vertex or index, for the draw call
+};
+
+struct GeometryRingStats {
+    UINT        vertex_size;            // bytes
+    UINT        index_size;
+    UINT        vertex_frame_bytes;     // used by the last finished frame
+    UINT        index_frame_bytes;
+    UINT        vertex_high_water;      // most used by any frame
+    UINT        index_high_water;
+    UINT        locks;                  // last finished frame
+    UINT        discards;
+    UINT        grows;                  // since creation
+};
+
+struct GeometryRing;
+
+GeometryRing *
+GeometryRing_Create (DeviceResources * resources, UINT vertex_bytes, UINT index_count);
+void
+GeometryRing_Destroy (GeometryRing * ring);
+void
+GeometryRing_BeginFrame (GeometryRing * ring);
+// Room for 'count' vertices of 'stride' bytes; span->first is the base
+// vertex index.  Returns false while the device is lost.
+bool
+GeometryRing_LockVertices (GeometryRing * ring, UINT count, UINT stride, GeometryRingSpan * span);
+void
+GeometryRing_UnlockVertices (GeometryRing * ring);
+bool
+GeometryRing_LockIndices (GeometryRing * ring, UINT count, GeometryRingSpan * span);
+void
+GeometryRing_UnlockIndices (GeometryRing * ring);
+IDirect3DVertexBuffer9 *
+GeometryRing_VertexBuffer (GeometryRing const * ring);
+IDirect3DIndexBuffer9 *
+GeometryRing_IndexBuffer (GeometryRing const * ring);
+GeometryRingStats
+GeometryRing_Stats (GeometryRing const * ring);
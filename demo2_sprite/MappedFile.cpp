@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool
+MappedFile_Open (MappedFile * file, char const * path) {
+    memset(file, 0, sizeof(*file));
+#ifdef _WIN32
+    HANDLE hfile = CreateFileA(
+        path, GENERIC_READ, FILE_SHARE_READ, 0,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0
+    );
+    if (INVALID_HANDLE_VALUE == hfile)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(hfile, &file_size) || 0 == file_size.QuadPart) {
+        CloseHandle(hfile);
+        return false;
+    }
+
+    HANDLE hmapping = CreateFileMappingA(hfile, 0, PAGE_READONLY, 0, 0, 0);
+    if (0 == hmapping) {
+        CloseHandle(hfile);
+        return false;
+    }
+
+    void * view = MapViewOfFile(hmapping, FILE_MAP_READ, 0, 0, 0);
+    if (0 == view) {
+        CloseHandle(hmapping);
+        CloseHandle(hfile);
+        return false;
+    }
+
+    file->data = view;
+    file->size = (size_t)file_size.QuadPart;
+    file->file_handle = hfile;
+    file->mapping_handle = hmapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || 0 == st.st_size) {
+        close(fd);
+        return false;
+    }
+
+    void * view = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping keeps its own reference to the file
+    if (MAP_FAILED == view)
+        return false;
+
+    file->data = view;
+    file->size = (size_t)st.st_size;
+#endif
+    return true;
+}
+void
+MappedFile_Close (MappedFile * file) {
+    if (0 == file->data)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+    CloseHandle((HANDLE)file->mapping_handle);
+    CloseHandle((HANDLE)file->file_handle);
+#else
+    munmap((void *)file->data, file->size);
+#endif
+    memset(file, 0, sizeof(*file));
+}
@@ -0,0 +1,434 @@
+#include "MipChain.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define MIP_SSE
+#include <xmmintrin.h>
+#endif
+
+// One texel as four floats in memory order (B, G, R, A).
+#ifdef MIP_SSE
+typedef __m128 Vec4;
+static inline Vec4 vec_load (float const * p)           { return _mm_loadu_ps(p); }
+static inline void vec_store (float * p, Vec4 v)        { _mm_storeu_ps(p, v); }
+static inline Vec4 vec_splat (float s)                  { return _mm_set1_ps(s); }
+static inline Vec4 vec_add (Vec4 a, Vec4 b)             { return _mm_add_ps(a, b); }
+static inline Vec4 vec_mul (Vec4 a, Vec4 b)             { return _mm_mul_ps(a, b); }
+static inline Vec4 vec_madd (Vec4 a, Vec4 b, Vec4 c)    { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline Vec4 vec_max (Vec4 a, Vec4 b)             { return _mm_max_ps(a, b); }
+#else
+struct Vec4 { float v[4]; };
+static inline Vec4 vec_load (float const * p)           { Vec4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void vec_store (float * p, Vec4 v)        { memcpy(p, v.v, sizeof(v.v)); }
+static inline Vec4 vec_splat (float s)                  { Vec4 r = {{s, s, s, s}}; return r; }
+static inline Vec4 vec_add (Vec4 a, Vec4 b)             { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+static inline Vec4 vec_mul (Vec4 a, Vec4 b)             { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+static inline Vec4 vec_madd (Vec4 a, Vec4 b, Vec4 c)    { for (int i = 0; i < 4; ++i) c.v[i] += a.v[i] * b.v[i]; return c; }
+static inline Vec4 vec_max (Vec4 a, Vec4 b)             { for (int i = 0; i < 4; ++i) a.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return a; }
+#endif
+
+#define KAISER_TAPS     8
+#define TO_SRGB_SIZE    4096
+
+struct Tables {
+    float       to_linear[256];
+    uint8_t     to_srgb[TO_SRGB_SIZE + 1];
+    float       kaiser[KAISER_TAPS];
+};
+
+static double
+bessel_i0 (double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x * 0.5 / k) * (x * 0.5 / k);
+        sum += term;
+    }
+    return sum;
+}
+static Tables *
+build_tables () {
+    static Tables tables;
+    for (int i = 0; i < 256; ++i) {
+        double c = i / 255.0;
+        tables.to_linear[i] = (float)(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+    }
+    for (int i = 0; i <= TO_SRGB_SIZE; ++i) {
+        double l = (double)i / TO_SRGB_SIZE;
+        double c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+        tables.to_srgb[i] = (uint8_t)(c * 255.0 + 0.5);
+    }
+
+    // Taps sit at source texel centers -3.5 .. 3.5 from the destination
+    // texel center; in destination units that's -1.75 .. 1.75, inside
+    // a window of radius 2.
+    double const beta = 4.0;
+    double sum = 0.0;
+    double w[KAISER_TAPS];
+    for (int i = 0; i < KAISER_TAPS; ++i) {
+        double t = (i - KAISER_TAPS / 2 + 0.5) * 0.5;
+        double sinc = sin(3.14159265358979 * t) / (3.14159265358979 * t);
+        double r = t / 2.0;
+        w[i] = sinc * bessel_i0(beta * sqrt(1.0 - r * r)) / bessel_i0(beta);
+        sum += w[i];
+    }
+    for (int i = 0; i < KAISER_TAPS; ++i)
+        tables.kaiser[i] = (float)(w[i] / sum);
+    return &tables;
+}
+static Tables const *
+get_tables () {
+    // Function-local static: built once, thread-safe on first use.
+    static Tables const * tables = build_tables();
+    return tables;
+}
+
+struct Pass {
+    Tables const *  tables;
+    uint32_t        flags;
+
+    // source and destination of the current step
+    float const *   src;
+    uint32_t        src_w, src_h;
+    float *         dst;
+    uint32_t        dst_w, dst_h;
+
+    // 8-bit conversion of columns [pack_x0, pack_x1) of the rows from
+    // pack_y0 on
+    uint32_t const * pixels;
+    uint32_t *      out;
+    float           alpha_scale;
+    uint32_t        pack_x0, pack_x1, pack_y0;
+};
+
+static inline uint32_t
+wrap_or_clamp (int i, uint32_t n, bool wrap) {
+    if (wrap)
+        return (uint32_t)(((i % (int)n) + (int)n) % (int)n);
+    return i < 0 ? 0 : (i >= (int)n ? n - 1 : (uint32_t)i);
+}
+
+// Level 0 pixels to premultiplied (linear) floats.
+static void
+expand_rows (void * ctx, uint32_t begin, uint32_t end) {
+    Pass const * p = (Pass const *)ctx;
+    bool srgb = (p->flags & MIP_SRGB) != 0;
+    for (uint32_t y = begin; y < end; ++y) {
+        uint32_t const * src = p->pixels + (size_t)y * p->src_w;
+        float * dst = p->dst + (size_t)y * p->src_w * 4;
+        for (uint32_t x = 0; x < p->src_w; ++x) {
+            uint32_t c = src[x];
+            float a = (c >> 24) / 255.0f;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = (c >> (k * 8)) & 0xFF;
+                dst[x * 4 + k] = (srgb ? p->tables->to_linear[v] : v / 255.0f) * a;
+            }
+            dst[x * 4 + 3] = a;
+        }
+    }
+}
+static void
+box_rows (void * ctx, uint32_t begin, uint32_t end) {
+    Pass const * p = (Pass const *)ctx;
+    bool wrap = (p->flags & MIP_WRAP) != 0;
+    Vec4 const quarter = vec_splat(0.25f);
+    for (uint32_t y = begin; y < end; ++y) {
+        float const * r0 = p->src + (size_t)wrap_or_clamp(2 * y, p->src_h, wrap) * p->src_w * 4;
+        float const * r1 = p->src + (size_t)wrap_or_clamp(2 * y + 1, p->src_h, wrap) * p->src_w * 4;
+        float * dst = p->dst + (size_t)y * p->dst_w * 4;
+        for (uint32_t x = 0; x < p->dst_w; ++x) {
+            uint32_t x0 = wrap_or_clamp(2 * x, p->src_w, wrap) * 4;
+            uint32_t x1 = wrap_or_clamp(2 * x + 1, p->src_w, wrap) * 4;
+            Vec4 sum = vec_add(vec_add(vec_load(r0 + x0), vec_load(r0 + x1)), vec_add(vec_load(r1 + x0), vec_load(r1 + x1)));
+            vec_store(dst + x * 4, vec_mul(sum, quarter));
+        }
+    }
+}
+// Kaiser is separable: halve the width into dst (dst_w x src_h), then
+// halve the height of that into the next level.
+static void
+kaiser_rows_h (void * ctx, uint32_t begin, uint32_t end) {
+    Pass const * p = (Pass const *)ctx;
+    bool wrap = (p->flags & MIP_WRAP) != 0;
+    for (uint32_t y = begin; y < end; ++y) {
+        float const * src = p->src + (size_t)y * p->src_w * 4;
+        float * dst = p->dst + (size_t)y * p->dst_w * 4;
+        for (uint32_t x = 0; x < p->dst_w; ++x) {
+            Vec4 sum = vec_splat(0.0f);
+            int first = (int)(2 * x) - KAISER_TAPS / 2 + 1;
+            for (int t = 0; t < KAISER_TAPS; ++t) {
+                uint32_t sx = wrap_or_clamp(first + t, p->src_w, wrap);
+                sum = vec_madd(vec_load(src + sx * 4), vec_splat(p->tables->kaiser[t]), sum);
+            }
+            vec_store(dst + x * 4, vec_max(sum, vec_splat(0.0f)));
+        }
+    }
+}
+static void
+kaiser_rows_v (void * ctx, uint32_t begin, uint32_t end) {
+    Pass const * p = (Pass const *)ctx;
+    bool wrap = (p->flags & MIP_WRAP) != 0;
+    for (uint32_t y = begin; y < end; ++y) {
+        float const * rows[KAISER_TAPS];
+        int first = (int)(2 * y) - KAISER_TAPS / 2 + 1;
+        for (int t = 0; t < KAISER_TAPS; ++t)
+            rows[t] = p->src + (size_t)wrap_or_clamp(first + t, p->src_h, wrap) * p->src_w * 4;
+
+        float * dst = p->dst + (size_t)y * p->dst_w * 4;
+        for (uint32_t x = 0; x < p->dst_w; ++x) {
+            Vec4 sum = vec_splat(0.0f);
+            for (int t = 0; t < KAISER_TAPS; ++t)
+                sum = vec_madd(vec_load(rows[t] + x * 4), vec_splat(p->tables->kaiser[t]), sum);
+            vec_store(dst + x * 4, vec_max(sum, vec_splat(0.0f)));
+        }
+    }
+}
+// Premultiplied floats back to 8-bit, applying the coverage scale.
+static void
+pack_rows (void * ctx, uint32_t begin, uint32_t end) {
+    Pass const * p = (Pass const *)ctx;
+    bool srgb = (p->flags & MIP_SRGB) != 0;
+    for (uint32_t y = p->pack_y0 + begin; y < p->pack_y0 + end; ++y) {
+        float const * src = p->src + (size_t)y * p->src_w * 4;
+        uint32_t * out = p->out + (size_t)y * p->src_w;
+        for (uint32_t x = p->pack_x0; x < p->pack_x1; ++x) {
+            float a = src[x * 4 + 3];
+            float inv_a = a > 0.0f ? 1.0f / a : 0.0f;
+            uint32_t c = 0;
+            for (int k = 0; k < 3; ++k) {
+                float v = src[x * 4 + k] * inv_a;
+                v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+                uint32_t b = srgb ? p->tables->to_srgb[(int)(v * TO_SRGB_SIZE + 0.5f)] : (uint32_t)(v * 255.0f + 0.5f);
+                c |= b << (k * 8);
+            }
+            float sa = a * p->alpha_scale;
+            sa = sa > 1.0f ? 1.0f : sa;
+            c |= (uint32_t)(sa * 255.0f + 0.5f) << 24;
+            out[x] = c;
+        }
+    }
+}
+
+// Texels [x0, x1) x [y0, y1) of a float level 'width' texels wide.
+struct CoverageRect {
+    float const *   level;
+    uint32_t        width;
+    uint32_t        x0, y0, x1, y1;
+};
+static CoverageRect
+coverage_rect (float const * level, uint32_t width, uint32_t height, MipRegion const * region, uint32_t level_index) {
+    // Round outwards, so a region keeps at least one texel.
+    uint32_t round = (1u << level_index) - 1;
+    CoverageRect r;
+    r.level = level;
+    r.width = width;
+    r.x0 = region->x >> level_index;
+    r.y0 = region->y >> level_index;
+    r.x1 = (region->x + region->width + round) >> level_index;
+    r.y1 = (region->y + region->height + round) >> level_index;
+    if (r.x1 > width)   r.x1 = width;
+    if (r.y1 > height)  r.y1 = height;
+    return r;
+}
+static float
+alpha_coverage (CoverageRect const * r, float scale, uint8_t alpha_ref) {
+    size_t n = 0;
+    for (uint32_t y = r->y0; y < r->y1; ++y) {
+        float const * row = r->level + (size_t)y * r->width * 4;
+        for (uint32_t x = r->x0; x < r->x1; ++x) {
+            float a = row[x * 4 + 3] * scale;
+            if ((uint32_t)((a > 1.0f ? 1.0f : a) * 255.0f + 0.5f) > alpha_ref)
+                ++n;
+        }
+    }
+    return (float)n / (float)((size_t)(r->x1 - r->x0) * (r->y1 - r->y0));
+}
+static float
+find_coverage_scale (CoverageRect const * r, float target, uint8_t alpha_ref) {
+    // Coverage grows with the scale, so bisect towards the target from
+    // whichever side of 1 it lies, keeping the scale as close to 1 as
+    // possible (a fully opaque level stays untouched).
+    size_t count = (size_t)(r->x1 - r->x0) * (r->y1 - r->y0);
+    float current = alpha_coverage(r, 1.0f, alpha_ref);
+    if (fabsf(current - target) * count < 1.0f)
+        return 1.0f;
+
+    bool raise = current < target;
+    float lo = raise ? 1.0f : 0.0f;
+    float hi = raise ? 4.0f : 1.0f;
+    for (int i = 0; i < 16; ++i) {
+        float mid = 0.5f * (lo + hi);
+        float c = alpha_coverage(r, mid, alpha_ref);
+        if (raise ? c < target : c <= target)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return raise ? hi : lo;
+}
+
+uint32_t
+MipChain_LevelCount (uint32_t width, uint32_t height) {
+    uint32_t n = 1;
+    while (width > 1 || height > 1) {
+        width  = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ++n;
+    }
+    return n;
+}
+bool
+MipChain_Build (
+    MipChain * chain,
+    uint32_t * pixels, uint32_t width, uint32_t height, uint32_t level_count,
+    MipFilter filter, uint32_t flags, uint8_t alpha_ref,
+    MipRegion const * regions, uint32_t region_count,
+    ThreadPool * pool
+) {
+    memset(chain, 0, sizeof(*chain));
+    if (0 == width || 0 == height)
+        return false;
+    for (uint32_t r = 0; r < region_count; ++r) {
+        MipRegion const * region = &regions[r];
+        if (0 == region->width || 0 == region->height || region->x >= width || region->y >= height)
+            return false;
+    }
+    if (region_count > MIP_CHAIN_MAX_REGIONS)
+        return false;
+
+    uint32_t max_levels = MipChain_LevelCount(width, height);
+    if (0 == level_count || level_count > max_levels)
+        level_count = max_levels;
+    if (level_count > MIP_CHAIN_MAX_LEVELS)
+        level_count = MIP_CHAIN_MAX_LEVELS;
+
+    // Lay out all levels past 0 in one block.
+    size_t total = 0;
+    uint32_t w = width, h = height;
+    chain->levels[0].width  = w;
+    chain->levels[0].height = h;
+    chain->levels[0].pixels = pixels;
+    for (uint32_t i = 1; i < level_count; ++i) {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+        chain->levels[i].width  = w;
+        chain->levels[i].height = h;
+        total += (size_t)w * h;
+    }
+    chain->level_count = level_count;
+    if (1 == level_count)
+        return true;
+
+    chain->memory = ::malloc(total * sizeof(uint32_t));
+    // Float working set: the current level, the next one, and the
+    // half-width intermediate of the separable Kaiser pass (which is as
+    // big as level 0 for a one texel wide image).
+    size_t texels = (size_t)width * height;
+    float * cur = (float *)::malloc(texels * 4 * sizeof(float));
+    float * next = (float *)::malloc((texels / 2 + 1) * 4 * sizeof(float));
+    float * temp = (filter == MIP_FILTER_KAISER) ? (float *)::malloc(texels * 4 * sizeof(float)) : 0;
+    if (0 == chain->memory || 0 == cur || 0 == next || (filter == MIP_FILTER_KAISER && 0 == temp)) {
+        ::free(cur);
+        ::free(next);
+        ::free(temp);
+        MipChain_Release(chain);
+        return false;
+    }
+
+    uint32_t * out = (uint32_t *)chain->memory;
+    for (uint32_t i = 1; i < level_count; ++i) {
+        chain->levels[i].pixels = out;
+        out += (size_t)chain->levels[i].width * chain->levels[i].height;
+    }
+
+    Pass pass = {};
+    pass.tables = get_tables();
+    pass.flags  = flags;
+
+    // Aim for roughly 16K texels per chunk.
+    #define ROW_GRAIN(w) ((16384 / (w)) > 0 ? (16384 / (w)) : 1)
+
+    pass.pixels = pixels;
+    pass.src_w  = width;
+    pass.src_h  = height;
+    pass.dst    = cur;
+    ThreadPool_ParallelFor(pool, height, ROW_GRAIN(width), expand_rows, &pass);
+
+    // Without regions the whole image is one.
+    MipRegion whole = { 0, 0, width, height };
+    if (0 == region_count) {
+        regions = &whole;
+        region_count = 1;
+    }
+    bool preserve = (flags & MIP_PRESERVE_COVERAGE) != 0;
+    float coverage[MIP_CHAIN_MAX_REGIONS];
+    for (uint32_t r = 0; preserve && r < region_count; ++r) {
+        CoverageRect rect = coverage_rect(cur, width, height, &regions[r], 0);
+        coverage[r] = alpha_coverage(&rect, 1.0f, alpha_ref);
+    }
+
+    for (uint32_t i = 1; i < level_count; ++i) {
+        MipLevel const * src = &chain->levels[i - 1];
+        MipLevel const * dst = &chain->levels[i];
+
+        pass.src    = cur;
+        pass.src_w  = src->width;
+        pass.src_h  = src->height;
+        if (filter == MIP_FILTER_KAISER) {
+            pass.dst    = temp;
+            pass.dst_w  = dst->width;
+            pass.dst_h  = src->height;
+            ThreadPool_ParallelFor(pool, src->height, ROW_GRAIN(dst->width), kaiser_rows_h, &pass);
+
+            pass.src    = temp;
+            pass.src_w  = dst->width;
+            pass.dst    = next;
+            pass.dst_h  = dst->height;
+            ThreadPool_ParallelFor(pool, dst->height, ROW_GRAIN(dst->width), kaiser_rows_v, &pass);
+        } else {
+            pass.dst    = next;
+            pass.dst_w  = dst->width;
+            pass.dst_h  = dst->height;
+            ThreadPool_ParallelFor(pool, dst->height, ROW_GRAIN(dst->width), box_rows, &pass);
+        }
+
+        // The scale only touches the 8-bit output; the float chain keeps
+        // the filtered alpha so errors don't compound down the levels.
+        // Regions are packed again with their own scale over the level.
+        pass.alpha_scale = 1.0f;
+        pass.src    = next;
+        pass.src_w  = dst->width;
+        pass.out    = dst->pixels;
+        pass.pack_x0 = 0;
+        pass.pack_x1 = dst->width;
+        pass.pack_y0 = 0;
+        ThreadPool_ParallelFor(pool, dst->height, ROW_GRAIN(dst->width), pack_rows, &pass);
+        for (uint32_t r = 0; preserve && r < region_count; ++r) {
+            CoverageRect rect = coverage_rect(next, dst->width, dst->height, &regions[r], i);
+            pass.alpha_scale = find_coverage_scale(&rect, coverage[r], alpha_ref);
+            if (1.0f == pass.alpha_scale)
+                continue;
+            pass.pack_x0 = rect.x0;
+            pass.pack_x1 = rect.x1;
+            pass.pack_y0 = rect.y0;
+            ThreadPool_ParallelFor(pool, rect.y1 - rect.y0, ROW_GRAIN(rect.x1 - rect.x0), pack_rows, &pass);
+        }
+
+        float * swap = cur;
+        cur = next;
+        next = swap;
+    }
+    #undef ROW_GRAIN
+
+    ::free(cur);
+    ::free(next);
+    ::free(temp);
+    return true;
+}
+void
+MipChain_Release (MipChain * chain) {
+    ::free(chain->memory);
+    memset(chain, 0, sizeof(*chain));
+}
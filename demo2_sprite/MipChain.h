@@ -0,0 +1,70 @@
+#pragma once
+
+// CPU mip chain generation for A8R8G8B8 images.
+//
+// Filtering happens in floating point on premultiplied colors, in linear
+// light when MIP_SRGB is set, so dark fringes don't creep in around
+// transparent texels and bright detail doesn't dim with distance.  With
+// MIP_PRESERVE_COVERAGE each level's alpha is rescaled so the fraction
+// of texels passing the alpha test matches level 0, which keeps
+// alpha-tested sprites from thinning out as they shrink.  Regions keep
+// the coverage of each sprite of an atlas page on its own, so one
+// sprite's texels don't shift another's alpha.
+
+#include "ThreadPool.h"
+
+#include <stdint.h>
+
+#define MIP_CHAIN_MAX_LEVELS 16
+#define MIP_CHAIN_MAX_REGIONS 16
+
+enum MipFilter {
+    MIP_FILTER_BOX,         // 2x2 average
+    MIP_FILTER_KAISER,      // 8-tap Kaiser-windowed sinc, sharper
+};
+
+enum {
+    MIP_SRGB                = 1 << 0,   // color channels are sRGB encoded
+    MIP_WRAP                = 1 << 1,   // image tiles; filter across edges
+    MIP_PRESERVE_COVERAGE   = 1 << 2,   // see above; uses alpha_ref
+};
+
+struct MipLevel {
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t *  pixels;     // tightly packed, width * 4 bytes per row
+};
+
+// A rectangle of level 0 whose coverage is preserved separately.  At
+// level i it covers the texels its level 0 texels fold into.
+struct MipRegion {
+    uint32_t    x, y;
+    uint32_t    width, height;
+};
+
+struct MipChain {
+    uint32_t    level_count;
+    MipLevel    levels[MIP_CHAIN_MAX_LEVELS];
+
+    void *      memory;     // levels 1 and up
+};
+
+// Number of levels down to 1x1.
+uint32_t
+MipChain_LevelCount (uint32_t width, uint32_t height);
+// Level 0 refers to 'pixels' without copying them.  level_count 0 builds
+// the full chain.  Rows are spread across the pool's workers.  The alpha
+// test is 'alpha > alpha_ref', as with D3DCMP_GREATER.  With no regions
+// MIP_PRESERVE_COVERAGE treats the whole image as one; with regions,
+// texels outside all of them keep their filtered alpha.  At most
+// MIP_CHAIN_MAX_REGIONS, which mustn't overlap.
+bool
+MipChain_Build (
+    MipChain * chain,
+    uint32_t * pixels, uint32_t width, uint32_t height, uint32_t level_count,
+    MipFilter filter, uint32_t flags, uint8_t alpha_ref,
+    MipRegion const * regions, uint32_t region_count,
+    ThreadPool * pool
+);
+void
+MipChain_Release (MipChain * chain);
@@ -0,0 +1,115 @@
+#include "SpriteBatch.h"
+
+#include <string.h>
+
+// 16-bit indices address at most this many quads per draw call.
+#define SPRITE_BATCH_MAX_QUADS  (65536 / 4)
+
+struct SpriteQuad {
+    IDirect3DTexture9 *     texture;
+    SpriteVertex            vertices[4];
+};
+
+struct SpriteBatch {
+    GeometryRing *  ring;
+    SpriteQuad *    quads;
+    UINT            count;
+    UINT            capacity;
+};
+
+static void
+transform_corner (SpriteVertex * v, D3DXMATRIX const * m, float x, float y, float u, float t, D3DCOLOR color) {
+    v->x = x * m->_11 + y * m->_21 + m->_41;
+    v->y = x * m->_12 + y * m->_22 + m->_42;
+    v->z = x * m->_13 + y * m->_23 + m->_43;
+    v->color = color;
+    v->u = u;
+    v->v = t;
+}
+// Draws quads [first, first + count), all of which fit one 16-bit range.
+static void
+flush_quads (SpriteBatch * batch, IDirect3DDevice9 * device, UINT first, UINT count) {
+    GeometryRingSpan vertices, indices;
+    if (false == GeometryRing_LockVertices(batch->ring, count * 4, sizeof(SpriteVertex), &vertices))
+        return;
+    if (false == GeometryRing_LockIndices(batch->ring, count * 6, &indices)) {
+        GeometryRing_UnlockVertices(batch->ring);
+        return;
+    }
+    SpriteVertex * vtx = (SpriteVertex *)vertices.data;
+    WORD * idx = (WORD *)indices.data;
+    for (UINT i = 0; i < count; ++i) {
+        memcpy(vtx + i * 4, batch->quads[first + i].vertices, sizeof(batch->quads[0].vertices));
+        WORD base = (WORD)(i * 4);
+        WORD * q = idx + i * 6;
+        q[0] = base;     q[1] = base + 1; q[2] = base + 2;
+        q[3] = base;     q[4] = base + 2; q[5] = base + 3;
+    }
+    GeometryRing_UnlockIndices(batch->ring);
+    GeometryRing_UnlockVertices(batch->ring);
+
+    device->SetStreamSource(0, GeometryRing_VertexBuffer(batch->ring), 0, sizeof(SpriteVertex));
+    device->SetIndices(GeometryRing_IndexBuffer(batch->ring));
+
+    // One draw call per run of quads sharing a texture.
+    for (UINT run = 0; run < count; ) {
+        IDirect3DTexture9 * texture = batch->quads[first + run].texture;
+        UINT end = run + 1;
+        while (end < count && batch->quads[first + end].texture == texture)
+            ++end;
+        device->SetTexture(0, texture);
+        device->DrawIndexedPrimitive(
+            D3DPT_TRIANGLELIST, vertices.first, run * 4, (end - run) * 4,
+            indices.first + run * 6, (end - run) * 2
+        );
+        run = end;
+    }
+}
+
+SpriteBatch *
+SpriteBatch_Create (GeometryRing * ring) {
+    SpriteBatch * batch = (SpriteBatch *)::calloc(1, sizeof(SpriteBatch));
+    batch->ring = ring;
+    return batch;
+}
+void
+SpriteBatch_Destroy (SpriteBatch * batch) {
+    if (0 == batch)
+        return;
+    ::free(batch->quads);
+    ::free(batch);
+}
+void
+SpriteBatch_Draw (
+    SpriteBatch * batch, IDirect3DTexture9 * texture, D3DXMATRIX const * transform,
+    float x0, float y0, float x1, float y1,
+    float u0, float v0, float u1, float v1,
+    D3DCOLOR color
+) {
+    if (batch->count == batch->capacity) {
+        batch->capacity = batch->capacity ? batch->capacity * 2 : 64;
+        batch->quads = (SpriteQuad *)::realloc(batch->quads, batch->capacity * sizeof(SpriteQuad));
+    }
+    SpriteQuad * quad = &batch->quads[batch->count++];
+    quad->texture = texture;
+    transform_corner(&quad->vertices[0], transform, x0, y0, u0, v0, color);
+    transform_corner(&quad->vertices[1], transform, x1, y0, u1, v0, color);
+    transform_corner(&quad->vertices[2], transform, x1, y1, u1, v1, color);
+    transform_corner(&quad->vertices[3], transform, x0, y1, u0, v1, color);
+}
+void
+SpriteBatch_Flush (SpriteBatch * batch, IDirect3DDevice9 * device) {
+    if (0 == batch->count)
+        return;
+
+    D3DXMATRIX identity;
+    D3DXMatrixIdentity(&identity);
+    device->SetTransform(D3DTS_WORLD, &identity);
+    device->SetFVF(SPRITE_VERTEX_FVF);
+
+    for (UINT first = 0; first < batch->count; first += SPRITE_BATCH_MAX_QUADS) {
+        UINT count = batch->count - first;
+        flush_quads(batch, device, first, count < SPRITE_BATCH_MAX_QUADS ? count : SPRITE_BATCH_MAX_QUADS);
+    }
+    batch->count = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Common.h"
+#include "GeometryRing.h"
+
+// Textured quads collected on the CPU and drawn from the shared geometry
+// ring: one vertex lock, one index lock and one draw call per run of
+// quads using the same texture.  Quads are transformed on the CPU and
+// drawn with an identity world matrix under the device's view and
+// projection.  Render states are left to the caller.
+
+struct SpriteVertex {
+    float       x, y, z;
+    D3DCOLOR    color;
+    float       u, v;
+};
+#define SPRITE_VERTEX_FVF   (D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX1)
+
+struct SpriteBatch;
+
+SpriteBatch *
+SpriteBatch_Create (GeometryRing * ring);
+void
+SpriteBatch_Destroy (SpriteBatch * batch);
+// Adds the quad spanning (x0, y0)-(x1, y1) in the sprite's own space,
+// with (u0, v0) at the first corner and (u1, v1) at the opposite one.
+void
+SpriteBatch_Draw (
+    SpriteBatch * batch, IDirect3DTexture9 * texture, D3DXMATRIX const * transform,
+    float x0, float y0, float x1, float y1,
+    float u0, float v0, float u1, float v1,
+    D3DCOLOR color
+);
+void
+SpriteBatch_Flush (SpriteBatch * batch, IDirect3DDevice9 * device);
@@ -0,0 +1,151 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPoolTask {
+    ThreadPoolTaskFn    fn;
+    void *              arg;
+};
+
+struct ThreadPool {
+    std::vector<std::thread>        threads;
+
+    std::mutex                      mutex;
+    std::condition_variable         wake;
+    std::deque<ThreadPoolTask>      tasks;
+    bool                            quit;
+};
+
+static void
+worker_main (ThreadPool * pool) {
+    for (;;) {
+        ThreadPoolTask task;
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->wake.wait(lock, [pool] { return pool->quit || !pool->tasks.empty(); });
+
+            // Drain the queue before honouring quit so Destroy never
+            // drops work that was already submitted.
+            if (pool->tasks.empty())
+                return;
+            task = pool->tasks.front();
+            pool->tasks.pop_front();
+        }
+        task.fn(task.arg);
+    }
+}
+
+ThreadPool *
+ThreadPool_Create (uint32_t thread_count) {
+    if (0 == thread_count) {
+        uint32_t hw = std::thread::hardware_concurrency();
+        thread_count = hw > 1 ? hw - 1 : 1;
+    }
+
+    ThreadPool * pool = new ThreadPool;
+    pool->quit = false;
+    pool->threads.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; ++i)
+        pool->threads.emplace_back(worker_main, pool);
+    return pool;
+}
+void
+ThreadPool_Destroy (ThreadPool * pool) {
+    if (0 == pool)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->quit = true;
+    }
+    pool->wake.notify_all();
+    for (size_t i = 0; i < pool->threads.size(); ++i)
+        pool->threads[i].join();
+    delete pool;
+}
+uint32_t
+ThreadPool_ThreadCount (ThreadPool const * pool) {
+    return (uint32_t)pool->threads.size();
+}
+void
+ThreadPool_Submit (ThreadPool * pool, ThreadPoolTaskFn fn, void * arg) {
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        ThreadPoolTask task = {fn, arg};
+        pool->tasks.push_back(task);
+    }
+    pool->wake.notify_one();
+}
+
+struct ParallelFor {
+    ThreadPoolRangeFn       fn;
+    void *                  ctx;
+    uint32_t                count;
+    uint32_t                grain;
+    std::atomic<uint32_t>   next;       // first item of the next chunk
+    std::atomic<uint32_t>   done;       // items finished
+    std::atomic<uint32_t>   refs;       // caller + helpers still holding the job
+};
+
+static void
+release_job (ParallelFor * job) {
+    if (1 == job->refs.fetch_sub(1, std::memory_order_acq_rel))
+        delete job;
+}
+static void
+run_chunks (ParallelFor * job) {
+    for (;;) {
+        uint32_t begin = job->next.fetch_add(job->grain);
+        if (begin >= job->count)
+            break;
+        uint32_t end = begin + job->grain < job->count ? begin + job->grain : job->count;
+        job->fn(job->ctx, begin, end);
+        job->done.fetch_add(end - begin, std::memory_order_release);
+    }
+}
+static void
+parallel_for_task (void * arg) {
+    ParallelFor * job = (ParallelFor *)arg;
+    run_chunks(job);
+    release_job(job);
+}
+
+void
+ThreadPool_ParallelFor (ThreadPool * pool, uint32_t count, uint32_t grain, ThreadPoolRangeFn fn, void * ctx) {
+    if (0 == count)
+        return;
+    if (0 == grain)
+        grain = 1;
+
+    // No point waking more helpers than there are chunks left after ours.
+    uint32_t chunks = (count + grain - 1) / grain;
+    uint32_t helpers = ThreadPool_ThreadCount(pool);
+    if (helpers > chunks - 1)
+        helpers = chunks - 1;
+
+    // Heap-allocated and reference counted: a helper may only get to run
+    // after the caller has finished every chunk and returned.
+    ParallelFor * job = new ParallelFor;
+    job->fn     = fn;
+    job->ctx    = ctx;
+    job->count  = count;
+    job->grain  = grain;
+    job->next.store(0);
+    job->done.store(0);
+    job->refs.store(helpers + 1);
+    for (uint32_t i = 0; i < helpers; ++i)
+        ThreadPool_Submit(pool, parallel_for_task, job);
+
+    run_chunks(job);
+
+    // Every chunk has been claimed by now; only wait for the ones other
+    // threads are still running.  Never waits on a queued helper, so
+    // calling this from inside a task can't deadlock the pool.
+    while (job->done.load(std::memory_order_acquire) < count)
+        std::this_thread::yield();
+    release_job(job);
+}
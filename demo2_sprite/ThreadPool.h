@@ -0,0 +1,29 @@
+#pragma once
+
+// Fixed set of worker threads pulling tasks off a shared FIFO.  Tasks
+// are plain function pointers so callers don't need to know anything
+// about the threading library underneath.
+
+#include <stdint.h>
+
+struct ThreadPool;
+
+typedef void (*ThreadPoolTaskFn) (void * arg);
+typedef void (*ThreadPoolRangeFn) (void * ctx, uint32_t begin, uint32_t end);
+
+// thread_count 0 picks one worker per hardware thread, minus one for the
+// caller (at least one).
+ThreadPool *
+ThreadPool_Create (uint32_t thread_count);
+// Waits for queued tasks to finish, then joins the workers.
+void
+ThreadPool_Destroy (ThreadPool * pool);
+uint32_t
+ThreadPool_ThreadCount (ThreadPool const * pool);
+void
+ThreadPool_Submit (ThreadPool * pool, ThreadPoolTaskFn fn, void * arg);
+// Splits [0, count) into chunks of at most 'grain' items and runs fn on
+// them across the workers.  The calling thread takes chunks as well and
+// returns once all of them are done, so it is safe to call from a task.
+void
+ThreadPool_ParallelFor (ThreadPool * pool, uint32_t count, uint32_t grain, ThreadPoolRangeFn fn, void * ctx);
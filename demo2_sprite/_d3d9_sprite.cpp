@@ -12,6 +12,16 @@
 
 #include "DirectInput.h"
 #include "BulletArray.h"
+#include "ThreadPool.h"
+#include "AssetLoader.h"
+#include "Bmp.h"
+#include "MipChain.h"
+#include "BlockCompress.h"
+#include "Atlas.h"
+#include "DeviceResources.h"
+#include "GeometryRing.h"
+#include "SpriteBatch.h"
+#include "FrameScheduler.h"
 
 #include <DearImGui/imgui.h>
 #include <DearImGui/imgui_impl_dx9.h>
@@ -32,19 +42,21 @@ typedef struct {
 
     D3DPRESENT_PARAMETERS   present_params;
 
-    ID3DXSprite *           sprite;
+    SpriteBatch *           sprites;
 
     // background
     IDirect3DTexture9 *     bg_tex;
     D3DXVECTOR3             bg_center;
 
+    // ship and bullet images share the sprite atlas
+    IDirect3DTexture9 *     atlas_tex[ATLAS_MAX_PAGES];
+    AtlasRect               sprite_rects[2];
+
     // bullet data
-    IDirect3DTexture9 *     bullet_tex;
     D3DXVECTOR3             bullet_center;
     float                   bullet_speed;
 
     // ship data
-    IDirect3DTexture9 *     ship_tex;
     D3DXVECTOR3             ship_center;
     D3DXVECTOR3             ship_pos;
     float                   ship_rotation;
@@ -54,6 +66,11 @@ typedef struct {
     float                   ship_accel;
     float                   ship_drag;
 
+    // asset loading
+    __int64                 load_start;
+    float                   load_ms;
+    UINT                    texture_bytes;
+
     bool                    paused;
     bool                    initialized;
 } D3D9RenderContext;
@@ -61,8 +78,332 @@ typedef struct {
 D3D9RenderContext * g_render_ctx = nullptr;
 DirectInput * g_dinput = nullptr;
 BulletArray * g_bullets = nullptr;
+ThreadPool * g_thread_pool = nullptr;
+AssetLoader * g_asset_loader = nullptr;
+DeviceResources * g_device_resources = nullptr;
+GeometryRing * g_geometry_ring = nullptr;
+FrameScheduler * g_frame_scheduler = nullptr;
+
+// A scene with nothing going on is still redrawn this often, which is
+// also when polled state (DirectInput devices) gets looked at.
+#define IDLE_REDRAW_MS  500
+
+enum { SPRITE_SHIP, SPRITE_BULLET, SPRITE_COUNT };
+static bool const sprite_preserves_coverage[SPRITE_COUNT] = { true, false };
+
+// Mip levels of the sprite atlas; cells are aligned to 1 << (levels - 1)
+// texels so they stay apart all the way down.
+#define SPRITE_ATLAS_SIZE       256
+#define SPRITE_ATLAS_PADDING    8
+#define SPRITE_ATLAS_MIPS       5
 
 // Helper functions.
+struct TextureRequest {
+    IDirect3DTexture9 **    tex;
+    uint32_t                bmp_flags;
+    MipFilter               mip_filter;
+    uint32_t                mip_flags;
+
+    // D3DFMT_DXT1/DXT5 to block compress on the worker, or A8R8G8B8.
+    D3DFORMAT               format;
+    BcQuality               bc_quality;
+};
+struct DecodedTexture {
+    uint32_t *              pixels;
+    MipChain                mips;
+
+    // Block-compressed levels, back to back with tightly packed rows of
+    // blocks.  Null when the texture stays A8R8G8B8.
+    D3DFORMAT               format;
+    uint8_t *               blocks;
+    size_t                  level_offsets[MIP_CHAIN_MAX_LEVELS];
+};
+static bool
+texture_format_supported (D3D9RenderContext * render_ctx, D3DFORMAT format) {
+    D3DDISPLAYMODE mode;
+    render_ctx->d3d9_object->GetAdapterDisplayMode(D3DADAPTER_DEFAULT, &mode);
+    return SUCCEEDED(render_ctx->d3d9_object->CheckDeviceFormat(
+        D3DADAPTER_DEFAULT, render_ctx->device_type, mode.Format, 0, D3DRTYPE_TEXTURE, format
+    ));
+}
+static void
+compress_texture (DecodedTexture * decoded, BcQuality quality) {
+    // DXT textures need a top level that is a whole number of blocks.
+    MipChain const * mips = &decoded->mips;
+    if (mips->levels[0].width % 4 || mips->levels[0].height % 4) {
+        decoded->format = D3DFMT_A8R8G8B8;
+        return;
+    }
+    BcFormat bc = D3DFMT_DXT1 == decoded->format ? BC_FORMAT_BC1 : BC_FORMAT_BC3;
+    size_t total = 0;
+    for (uint32_t i = 0; i < mips->level_count; ++i) {
+        decoded->level_offsets[i] = total;
+        total += BlockCompress_Size(bc, mips->levels[i].width, mips->levels[i].height);
+    }
+    // Without room for the blocks, upload the A8R8G8B8 levels instead.
+    decoded->blocks = (uint8_t *)::malloc(total);
+    if (0 == decoded->blocks) {
+        decoded->format = D3DFMT_A8R8G8B8;
+        return;
+    }
+    for (uint32_t i = 0; i < mips->level_count; ++i) {
+        MipLevel const * level = &mips->levels[i];
+        BlockCompress_Encode(
+            bc, quality, level->pixels, level->width, level->height,
+            decoded->blocks + decoded->level_offsets[i], BlockCompress_Pitch(bc, level->width),
+            g_thread_pool
+        );
+    }
+}
+static bool
+prepare_texture (
+    DecodedTexture * decoded, uint32_t * pixels, uint32_t width, uint32_t height, uint32_t level_count,
+    MipRegion const * regions, uint32_t region_count, TextureRequest const * req
+) {
+    // Alpha ref matches D3DRS_ALPHAREF set in render_state_restore.
+    MipChain_Build(
+        &decoded->mips, pixels, width, height, level_count,
+        req->mip_filter, req->mip_flags, 10, regions, region_count, g_thread_pool
+    );
+    decoded->format = req->format;
+    if (decoded->mips.level_count > 0 && D3DFMT_A8R8G8B8 != decoded->format)
+        compress_texture(decoded, req->bc_quality);
+    return decoded->mips.level_count > 0;
+}
+static uint32_t *
+decode_bmp (Asset * asset, uint32_t bmp_flags) {
+    BmpInfo info;
+    if (false == Bmp_ReadInfo(asset->file.data, asset->file.size, &info))
+        return 0;
+    uint64_t bytes = (uint64_t)info.width * info.height * 4;
+    if (bytes > SIZE_MAX)
+        return 0;
+    uint32_t * pixels = (uint32_t *)::malloc((size_t)bytes);
+    if (0 == pixels)
+        return 0;
+    Bmp_Decode(asset->file.data, &info, bmp_flags, 0x000000, pixels, (size_t)info.width * 4);
+    asset->width = info.width;
+    asset->height = info.height;
+    return pixels;
+}
+static bool
+decode_texture (Asset * asset) {
+    // Runs on a worker: expand the mapped file into A8R8G8B8 pixels and
+    // build the mip chain, so the device thread only has to copy levels.
+    TextureRequest const * req = (TextureRequest const *)asset->user;
+    uint32_t * pixels = decode_bmp(asset, req->bmp_flags);
+    if (0 == pixels)
+        return false;
+
+    DecodedTexture * decoded = (DecodedTexture *)::calloc(1, sizeof(DecodedTexture));
+    decoded->pixels = pixels;
+    asset->payload = decoded;
+    return prepare_texture(decoded, pixels, asset->width, asset->height, 0, 0, 0, req);
+}
+static IDirect3DTexture9 *
+create_texture (DecodedTexture const * decoded) {
+    IDirect3DTexture9 * tex = 0;
+    if (SUCCEEDED(g_render_ctx->device->CreateTexture(
+            decoded->mips.levels[0].width, decoded->mips.levels[0].height, decoded->mips.level_count,
+            0, decoded->format, D3DPOOL_MANAGED, &tex, 0
+        ))) {
+        for (UINT i = 0; i < decoded->mips.level_count; ++i) {
+            MipLevel const * level = &decoded->mips.levels[i];
+            D3DLOCKED_RECT rect;
+            if (FAILED(tex->LockRect(i, &rect, 0, 0)))
+                continue;
+
+            // Compressed levels are copied a row of 4x4 blocks at a time.
+            BYTE const * src = (BYTE const *)level->pixels;
+            UINT row_size = level->width * 4;
+            UINT rows = level->height;
+            if (decoded->blocks) {
+                BcFormat bc = D3DFMT_DXT1 == decoded->format ? BC_FORMAT_BC1 : BC_FORMAT_BC3;
+                src = decoded->blocks + decoded->level_offsets[i];
+                row_size = BlockCompress_Pitch(bc, level->width);
+                rows = (level->height + 3) / 4;
+            }
+            for (UINT y = 0; y < rows; ++y)
+                memcpy((BYTE *)rect.pBits + y * rect.Pitch, src + y * row_size, row_size);
+            g_render_ctx->texture_bytes += row_size * rows;
+            tex->UnlockRect(i);
+        }
+    }
+    return tex;
+}
+static void
+release_texture_data (DecodedTexture * decoded) {
+    ::free(decoded->blocks);
+    MipChain_Release(&decoded->mips);
+    ::free(decoded->pixels);
+}
+static void
+complete_texture (Asset * asset) {
+    TextureRequest const * req = (TextureRequest const *)asset->user;
+    DecodedTexture * decoded = (DecodedTexture *)asset->payload;
+    IDirect3DTexture9 * tex = asset->ok ? create_texture(decoded) : 0;
+    if (decoded) {
+        release_texture_data(decoded);
+        ::free(decoded);
+    }
+
+    *req->tex = tex;
+    if (0 == tex)
+        MessageBoxA(0, asset->path, "failed to load texture", 0);
+}
+
+// The ship and bullet images are decoded separately, then packed into an
+// atlas once both have arrived so they can be drawn as one batch.
+struct SpriteSheet;
+struct SpriteSlot {
+    SpriteSheet *           sheet;
+    AtlasImage              image;
+};
+struct SpriteSheet {
+    SpriteSlot              slots[SPRITE_COUNT];
+    uint32_t                arrived;
+    bool                    failed;
+    TextureRequest          request;    // for the atlas pages
+};
+struct DecodedAtlas {
+    Atlas                   atlas;
+    AtlasRect               rects[SPRITE_COUNT];
+    DecodedTexture          pages[ATLAS_MAX_PAGES];
+};
+static bool
+decode_sprite_image (Asset * asset) {
+    SpriteSlot const * slot = (SpriteSlot const *)asset->user;
+    asset->payload = decode_bmp(asset, slot->sheet->request.bmp_flags);
+    return 0 != asset->payload;
+}
+static bool
+decode_atlas (Asset * asset) {
+    SpriteSheet * sheet = (SpriteSheet *)asset->user;
+    AtlasImage images[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; ++i)
+        images[i] = sheet->slots[i].image;
+
+    DecodedAtlas * decoded = (DecodedAtlas *)::calloc(1, sizeof(DecodedAtlas));
+    asset->payload = decoded;
+    bool ok = Atlas_Build(
+        &decoded->atlas, images, SPRITE_COUNT,
+        SPRITE_ATLAS_SIZE, SPRITE_ATLAS_PADDING, SPRITE_ATLAS_MIPS, decoded->rects
+    );
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        ::free((void *)sheet->slots[i].image.pixels);
+        sheet->slots[i].image.pixels = 0;
+    }
+    for (uint32_t i = 0; ok && i < decoded->atlas.page_count; ++i) {
+        // Coverage is preserved over the ship's rect alone, as when it had
+        // a texture of its own; the bullet and the gutters keep their
+        // filtered alpha.
+        MipRegion regions[SPRITE_COUNT];
+        uint32_t region_count = 0;
+        for (int j = 0; j < SPRITE_COUNT; ++j) {
+            AtlasRect const * r = &decoded->rects[j];
+            if (r->page != i || !sprite_preserves_coverage[j])
+                continue;
+            MipRegion region = { r->x, r->y, r->width, r->height };
+            regions[region_count++] = region;
+        }
+        ok = prepare_texture(
+            &decoded->pages[i], decoded->atlas.pages[i].pixels, decoded->atlas.size, decoded->atlas.size,
+            decoded->atlas.mip_levels, regions, region_count, &sheet->request
+        );
+    }
+    return ok;
+}
+static void
+complete_atlas (Asset * asset) {
+    DecodedAtlas * decoded = (DecodedAtlas *)asset->payload;
+    bool ok = asset->ok;
+    for (uint32_t i = 0; ok && i < decoded->atlas.page_count; ++i) {
+        g_render_ctx->atlas_tex[i] = create_texture(&decoded->pages[i]);
+        ok = 0 != g_render_ctx->atlas_tex[i];
+    }
+    if (ok)
+        memcpy(g_render_ctx->sprite_rects, decoded->rects, sizeof(decoded->rects));
+    else
+        MessageBoxA(0, "sprite atlas", "failed to load texture", 0);
+
+    if (decoded) {
+        for (uint32_t i = 0; i < decoded->atlas.page_count; ++i)
+            release_texture_data(&decoded->pages[i]);
+        Atlas_Release(&decoded->atlas);
+        ::free(decoded);
+    }
+}
+static void
+complete_sprite_image (Asset * asset) {
+    SpriteSlot * slot = (SpriteSlot *)asset->user;
+    SpriteSheet * sheet = slot->sheet;
+    if (asset->ok) {
+        slot->image.pixels = (uint32_t *)asset->payload;
+        slot->image.width = asset->width;
+        slot->image.height = asset->height;
+    } else {
+        sheet->failed = true;
+        MessageBoxA(0, asset->path, "failed to load texture", 0);
+    }
+
+    if (++sheet->arrived < SPRITE_COUNT)
+        return;
+    if (sheet->failed) {
+        for (int i = 0; i < SPRITE_COUNT; ++i)
+            ::free((void *)sheet->slots[i].image.pixels);
+        return;
+    }
+    AssetLoader_Submit(g_asset_loader, 0, decode_atlas, complete_atlas, sheet);
+}
+static void
+load_textures (D3D9RenderContext * render_ctx) {
+    // The ship and bullet keep their alpha channel and also key out pure
+    // black; the background is a plain 24-bit image.  The background is
+    // tiled and minified heavily, so it gets the sharper Kaiser filter;
+    // the ship keeps its coverage down the atlas mips.
+    // Where the device supports it the background goes to DXT1 and the
+    // atlas, which needs its alpha, to DXT5; the small atlas can afford
+    // the slower, higher quality encoder.  The background wraps, so it
+    // can't share the atlas and keeps a texture of its own.
+    bool dxt1 = texture_format_supported(render_ctx, D3DFMT_DXT1);
+    bool dxt5 = texture_format_supported(render_ctx, D3DFMT_DXT5);
+    static TextureRequest bg_request;
+    bg_request.tex          = &render_ctx->bg_tex;
+    bg_request.bmp_flags    = 0;
+    bg_request.mip_filter   = MIP_FILTER_KAISER;
+    bg_request.mip_flags    = MIP_SRGB | MIP_WRAP;
+    bg_request.format       = dxt1 ? D3DFMT_DXT1 : D3DFMT_A8R8G8B8;
+    bg_request.bc_quality   = BC_QUALITY_FAST;
+
+    static SpriteSheet sheet;
+    memset(&sheet, 0, sizeof(sheet));
+    for (int i = 0; i < SPRITE_COUNT; ++i)
+        sheet.slots[i].sheet = &sheet;
+    sheet.request.bmp_flags     = BMP_FILE_ALPHA | BMP_COLOR_KEY;
+    sheet.request.mip_filter    = MIP_FILTER_BOX;
+    sheet.request.mip_flags     = MIP_SRGB | MIP_PRESERVE_COVERAGE;  // per sprite_preserves_coverage
+    sheet.request.format        = dxt5 ? D3DFMT_DXT5 : D3DFMT_A8R8G8B8;
+    sheet.request.bc_quality    = BC_QUALITY_HIGH;
+
+    // All three files decode in parallel; sprites whose texture hasn't
+    // arrived yet are simply skipped when drawing.
+    QueryPerformanceCounter((LARGE_INTEGER*)&render_ctx->load_start);
+    AssetLoader_Submit(g_asset_loader, "bkgd1.bmp", decode_texture, complete_texture, &bg_request);
+    AssetLoader_Submit(g_asset_loader, "alienship.bmp", decode_sprite_image, complete_sprite_image, &sheet.slots[SPRITE_SHIP]);
+    AssetLoader_Submit(g_asset_loader, "bullet.bmp", decode_sprite_image, complete_sprite_image, &sheet.slots[SPRITE_BULLET]);
+}
+static void
+pump_assets (D3D9RenderContext * render_ctx) {
+    if (0 == AssetLoader_Pump(g_asset_loader))
+        return;
+    FrameScheduler_MarkDirty(g_frame_scheduler);
+    if (0 == AssetLoader_Pending(g_asset_loader)) {
+        __int64 cnts_per_sec = 0, now = 0;
+        QueryPerformanceFrequency((LARGE_INTEGER*)&cnts_per_sec);
+        QueryPerformanceCounter((LARGE_INTEGER*)&now);
+        render_ctx->load_ms = 1000.0f * (float)(now - render_ctx->load_start) / (float)cnts_per_sec;
+    }
+}
 static void
 update_ship (D3D9RenderContext * render_ctx, float dt) {
     // Check input.
@@ -120,12 +461,8 @@ static void update_bullets (D3D9RenderContext * render_ctx, float dt) {
     }
 }
 static void draw_bg (D3D9RenderContext * render_ctx) {
-    // Set a texture coordinate scaling transform.  Here we scale the texture 
-    // coordinates by 10 in each dimension.  This tiles the texture 
-    // ten times over the sprite surface.
-    D3DXMATRIX tex_scale;
-    D3DXMatrixScaling(&tex_scale, 10.0f, 10.0f, 0.0f);
-    render_ctx->device->SetTransform(D3DTS_TEXTURE0, &tex_scale);
+    if (0 == render_ctx->bg_tex)
+        return;
 
     // Position and size the background sprite--remember that 
     // we always draw the ship in the center of the client area 
@@ -135,35 +472,42 @@ static void draw_bg (D3D9RenderContext * render_ctx) {
     D3DXMatrixTranslation(&T, -render_ctx->ship_pos.x, -render_ctx->ship_pos.y, -render_ctx->ship_pos.z);
     D3DXMatrixScaling(&S, 20.0f, 20.0f, 0.0f);
     ST = S * T;
-    render_ctx->sprite->SetTransform(&ST);
-
-    // Draw the background sprite.
-    render_ctx->sprite->Draw(render_ctx->bg_tex, 0, &render_ctx->bg_center, 0, D3DCOLOR_XRGB(255, 255, 255));
-    render_ctx->sprite->Flush();
 
-    // Restore defaults texture coordinate scaling transform.
-    D3DXMatrixScaling(&tex_scale, 1.0f, -1.0f, 0.0f);
-    render_ctx->device->SetTransform(D3DTS_TEXTURE0, &tex_scale);
+    // Draw the background sprite.  Texture coordinates run to 10 in each
+    // dimension, which tiles the texture ten times over the sprite surface.
+    D3DSURFACE_DESC desc;
+    render_ctx->bg_tex->GetLevelDesc(0, &desc);
+    D3DXVECTOR3 const * c = &render_ctx->bg_center;
+    SpriteBatch_Draw(
+        render_ctx->sprites, render_ctx->bg_tex, &ST,
+        -c->x, -c->y, (float)desc.Width - c->x, (float)desc.Height - c->y,
+        0.0f, 0.0f, 10.0f, 10.0f, D3DCOLOR_XRGB(255, 255, 255)
+    );
+    SpriteBatch_Flush(render_ctx->sprites, render_ctx->device);
 }
-static void draw_ship (D3D9RenderContext * render_ctx) {
-    // Turn on the alpha test.
+static void
+draw_sprite (D3D9RenderContext * render_ctx, int sprite, D3DXMATRIX const * transform, D3DXVECTOR3 const * center) {
+    // The view is y-up, so the image's first row goes on top.
+    AtlasRect const * r = &render_ctx->sprite_rects[sprite];
+    SpriteBatch_Draw(
+        render_ctx->sprites, render_ctx->atlas_tex[r->page], transform,
+        -center->x, center->y, (float)r->width - center->x, center->y - (float)r->height,
+        r->u0, r->v0, r->u1, r->v1, D3DCOLOR_XRGB(255, 255, 255)
+    );
+}
+static void draw_sprites (D3D9RenderContext * render_ctx) {
+    if (0 == render_ctx->atlas_tex[0])
+        return;
+
+    // The ship and bullets share the atlas, so they go out as one batch
+    // with both the alpha test and alpha blending on.
     render_ctx->device->SetRenderState(D3DRS_ALPHATESTENABLE, true);
+    render_ctx->device->SetRenderState(D3DRS_ALPHABLENDENABLE, true);
 
     // Set ships orientation.
-    D3DXMATRIX R;
-    D3DXMatrixRotationZ(&R, render_ctx->ship_rotation);
-    render_ctx->sprite->SetTransform(&R);
-
-    // Draw the ship.
-    render_ctx->sprite->Draw(render_ctx->ship_tex, 0, &render_ctx->ship_center, 0, D3DCOLOR_XRGB(255, 255, 255));
-    render_ctx->sprite->Flush();
-
-    // Turn off the alpha test.
-    render_ctx->device->SetRenderState(D3DRS_ALPHATESTENABLE, false);
-}
-static void draw_bullets (D3D9RenderContext * render_ctx) {
-    // Turn on alpha blending.
-    render_ctx->device->SetRenderState(D3DRS_ALPHABLENDENABLE, true);
+    D3DXMATRIX ship_R;
+    D3DXMatrixRotationZ(&ship_R, render_ctx->ship_rotation);
+    draw_sprite(render_ctx, SPRITE_SHIP, &ship_R, &render_ctx->ship_center);
 
     for (int i = 0; i < BulletArray_Count(g_bullets); ++i) {
         D3DXVECTOR3 pos = BulletArray_GetItemPos(g_bullets, i);
@@ -174,17 +518,16 @@ static void draw_bullets (D3D9RenderContext * render_ctx) {
         D3DXMatrixRotationZ(&R, rotation);
         D3DXMatrixTranslation(&T, pos.x, pos.y, pos.z);
         RT = R * T;
-        render_ctx->sprite->SetTransform(&RT);
 
         // Add it to the batch.
-        render_ctx->sprite->Draw(render_ctx->bullet_tex, 0, &render_ctx->bullet_center, 0, D3DCOLOR_XRGB(255, 255, 255));
+        draw_sprite(render_ctx, SPRITE_BULLET, &RT, &render_ctx->bullet_center);
         ++i;
     }
-    // Draw all the bullets at once.
-    render_ctx->sprite->Flush();
+    // Draw the ship and all the bullets at once.
+    SpriteBatch_Flush(render_ctx->sprites, render_ctx->device);
 
-    // Turn off alpha blending.
     render_ctx->device->SetRenderState(D3DRS_ALPHABLENDENABLE, false);
+    render_ctx->device->SetRenderState(D3DRS_ALPHATESTENABLE, false);
 }
 static bool
 check_device_caps () {
@@ -192,16 +535,16 @@ check_device_caps () {
     return true;
 }
 static void
-d3d9_lost_device (D3D9RenderContext * render_ctx) {
-    render_ctx->sprite->OnLostDevice();
+imgui_lost (void * user) {
+    ImGui_ImplDX9_InvalidateDeviceObjects();
 }
 static void
-d3d9_reset_device (D3D9RenderContext * render_ctx) {
-    ImGui_ImplDX9_InvalidateDeviceObjects();
-    render_ctx->device->Reset(&render_ctx->present_params);
+imgui_restore (IDirect3DDevice9 * device, void * user) {
     ImGui_ImplDX9_CreateDeviceObjects();
-
-    render_ctx->sprite->OnResetDevice();
+}
+static void
+render_state_restore (IDirect3DDevice9 * device, void * user) {
+    D3D9RenderContext * render_ctx = (D3D9RenderContext *)user;
 
     // Sets up the camera 1000 units back looking at the origin.
     D3DXMATRIX V;
@@ -239,10 +582,69 @@ d3d9_reset_device (D3D9RenderContext * render_ctx) {
     render_ctx->device->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
     render_ctx->device->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
 
-    // Indicates that we are using 2D texture coordinates.
-    render_ctx->device->SetTextureStageState(
-        0, D3DTSS_TEXTURETRANSFORMFLAGS, D3DTTFF_COUNT2
-    );
+    // Sprites come out facing either way depending on their corners.
+    render_ctx->device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+}
+static void
+register_device_resources (D3D9RenderContext * render_ctx) {
+    DeviceResourceDesc const descs[] = {
+        {"imgui",           imgui_lost, imgui_restore,           0},
+        {"render state",    0,          render_state_restore,    render_ctx},
+    };
+    for (int i = 0; i < _countof(descs); ++i)
+        DeviceResources_Add(g_device_resources, &descs[i]);
+}
+static void
+d3d9_reset_device (D3D9RenderContext * render_ctx) {
+    DeviceResources_Reset(g_device_resources, &render_ctx->present_params);
+    FrameScheduler_MarkDirty(g_frame_scheduler);
+}
+static bool
+imgui_lock_vertices (void * user, unsigned int count, unsigned int stride, IDirect3DVertexBuffer9 ** buffer, unsigned int * first, void ** data) {
+    GeometryRing * ring = (GeometryRing *)user;
+    GeometryRingSpan span;
+    if (false == GeometryRing_LockVertices(ring, count, stride, &span))
+        return false;
+    *buffer = GeometryRing_VertexBuffer(ring);
+    *first = span.first;
+    *data = span.data;
+    return true;
+}
+static void
+imgui_unlock_vertices (void * user) {
+    GeometryRing_UnlockVertices((GeometryRing *)user);
+}
+static bool
+imgui_lock_indices (void * user, unsigned int count, unsigned int index_size, IDirect3DIndexBuffer9 ** buffer, unsigned int * first, void ** data) {
+    // The ring only holds 16-bit indices.
+    GeometryRing * ring = (GeometryRing *)user;
+    GeometryRingSpan span;
+    if (index_size != sizeof(WORD) || false == GeometryRing_LockIndices(ring, count, &span))
+        return false;
+    *buffer = GeometryRing_IndexBuffer(ring);
+    *first = span.first;
+    *data = span.data;
+    return true;
+}
+static void
+imgui_unlock_indices (void * user) {
+    GeometryRing_UnlockIndices((GeometryRing *)user);
+}
+// ImGui tessellates window draw lists on the pool (io.ParallelForFn).
+struct ImGuiParallelTask {
+    void    (*task) (void * task_data, int index);
+    void *  task_data;
+};
+static void
+imgui_parallel_range (void * ctx, uint32_t begin, uint32_t end) {
+    ImGuiParallelTask const * t = (ImGuiParallelTask const *)ctx;
+    for (uint32_t i = begin; i < end; ++i)
+        t->task(t->task_data, (int)i);
+}
+static void
+imgui_parallel_for (void * user, int count, void (*task) (void * task_data, int index), void * task_data) {
+    ImGuiParallelTask t = {task, task_data};
+    ThreadPool_ParallelFor((ThreadPool *)user, (uint32_t)count, 1, imgui_parallel_range, &t);
 }
 static bool is_device_lost (D3D9RenderContext * render_ctx) {
     // Get the state of the graphics device.
@@ -259,7 +661,6 @@ static bool is_device_lost (D3D9RenderContext * render_ctx) {
         return true;
     } else if (hr == D3DERR_DEVICENOTRESET) {
         // The device is lost but we can reset and restore it.
-        d3d9_lost_device(render_ctx);
         d3d9_reset_device(render_ctx);
         return false;
     } else
@@ -310,31 +711,34 @@ d3d9_enable_fullscreen_mode (D3D9RenderContext * render_ctx, bool enable) {
     }
 
     // Reset the device with the changes.
-    d3d9_lost_device(render_ctx);
     d3d9_reset_device(render_ctx);
 }
-static void
+// Returns true while something is still moving.
+static bool
 update_scene (D3D9RenderContext * render_ctx, float dt) {
     DirectInput_Poll(g_dinput);
 
     update_ship(render_ctx, dt);
     update_bullets(render_ctx, dt);
+
+    // Drag only ever slows the ship down; call it parked below a unit
+    // per second, and keep going while a key may speed it up again.
+    bool steering = DirectInput_KeyDown(g_dinput, DIK_A) || DirectInput_KeyDown(g_dinput, DIK_D) ||
+                    DirectInput_KeyDown(g_dinput, DIK_W) || DirectInput_KeyDown(g_dinput, DIK_S) ||
+                    DirectInput_KeyDown(g_dinput, DIK_SPACE);
+    return steering || fabsf(render_ctx->ship_speed) > 1.0f || BulletArray_Count(g_bullets) > 0;
 }
 static void
 draw_scene (D3D9RenderContext * render_ctx) {
     render_ctx->device->Clear(0, 0, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, D3DCOLOR_XRGB(255, 255, 255), 1.0f, 0);
 
+    GeometryRing_BeginFrame(g_geometry_ring);
     render_ctx->device->BeginScene();
 
-    render_ctx->sprite->Begin(D3DXSPRITE_OBJECTSPACE | D3DXSPRITE_DONOTMODIFY_RENDERSTATE);
     draw_bg(render_ctx);
-    draw_ship(render_ctx);
-    draw_bullets(render_ctx);
-
-    render_ctx->sprite->End();
+    draw_sprites(render_ctx);
 
 #ifdef ENABLE_IMGUI
-    ImGui::Render();
     ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
 #endif // ENABLE_IMGUI
 
@@ -374,7 +778,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
             } else if (wparam == SIZE_MAXIMIZED) {
                 render_ctx->paused = false;
                 min_maxed = true;
-                d3d9_lost_device(render_ctx);
                 d3d9_reset_device(render_ctx);
             }
             // Restored is any resize that is not a minimize or maximize.
@@ -388,7 +791,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
                 // and are in windowed mode?  Do not execute this code if 
                 // we are restoring to full screen mode.
                 if (min_maxed && render_ctx->present_params.Windowed) {
-                    d3d9_lost_device(render_ctx);
                     d3d9_reset_device(render_ctx);
                 } else {
                     // No, which implies the user is resizing by dragging
@@ -413,7 +815,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
         GetClientRect(render_ctx->wnd, &client_rect);
         render_ctx->present_params.BackBufferWidth  = client_rect.right;
         render_ctx->present_params.BackBufferHeight = client_rect.bottom;
-        d3d9_lost_device(render_ctx);
         d3d9_reset_device(render_ctx);
 
         return 0;
@@ -443,6 +844,7 @@ extern IMGUI_IMPL_API LRESULT
 ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 LRESULT CALLBACK
 wnd_proc (HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
+    FrameScheduler_OnMessage(g_frame_scheduler, msg);
     if (ImGui_ImplWin32_WndProcHandler(hwnd, msg, wparam, lparam))
         return true;
     // Don't start processing messages until the application has been created.
@@ -561,11 +963,12 @@ init_render_ctx (
         render_ctx->ship_accel = 1000.0f;
         render_ctx->ship_drag = 0.85f;
 
-        D3DXCreateSprite(render_ctx->device, &render_ctx->sprite);
+        g_device_resources = DeviceResources_Create(render_ctx->device);
+        register_device_resources(render_ctx);
+        g_geometry_ring = GeometryRing_Create(g_device_resources, 1024 * 1024, 64 * 1024);
+        render_ctx->sprites = SpriteBatch_Create(g_geometry_ring);
 
-        D3DXCreateTextureFromFile(render_ctx->device, _T("bkgd1.bmp"), &render_ctx->bg_tex);
-        D3DXCreateTextureFromFile(render_ctx->device, _T("alienship.bmp"), &render_ctx->ship_tex);
-        D3DXCreateTextureFromFile(render_ctx->device, _T("bullet.bmp"), &render_ctx->bullet_tex);
+        load_textures(render_ctx);
 
         render_ctx->bg_center = D3DXVECTOR3(256.0f, 256.0f, 0.0f);
         render_ctx->ship_center = D3DXVECTOR3(64.0f, 64.0f, 0.0f);
@@ -589,6 +992,13 @@ WinMain (
 
 #pragma region Initialize
 
+    // First, as the window procedure reports to it from the start.
+    g_frame_scheduler = FrameScheduler_Create(IDLE_REDRAW_MS);
+
+    // -- setup asset loading (before the render context submits its textures)
+    g_thread_pool = ThreadPool_Create(0);
+    g_asset_loader = AssetLoader_Create(g_thread_pool);
+
     g_render_ctx = (D3D9RenderContext *)::malloc(sizeof(D3D9RenderContext));
     init_render_ctx(
         g_render_ctx,
@@ -633,6 +1043,9 @@ WinMain (
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigDeferredDrawLists = true;
+    io.ParallelForFn = imgui_parallel_for;
+    io.ParallelForUserData = g_thread_pool;
     //io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
     //io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
 
@@ -644,6 +1057,12 @@ WinMain (
     ImGui_ImplWin32_Init(g_render_ctx->wnd);
     ImGui_ImplDX9_Init(g_render_ctx->device);
 
+    // ImGui streams its geometry through the shared ring too
+    ImGui_ImplDX9_BufferAllocator imgui_allocator = {
+        g_geometry_ring, imgui_lock_vertices, imgui_unlock_vertices, imgui_lock_indices, imgui_unlock_indices
+    };
+    ImGui_ImplDX9_SetBufferAllocator(&imgui_allocator);
+
 #pragma endregion
 #pragma region Main Loop
     MSG  msg;
@@ -668,11 +1087,27 @@ WinMain (
                 Sleep(20);
                 continue;
             }
-            if (false == is_device_lost(g_render_ctx)) {
+            // Nothing changed since the last frame: block until something
+            // does or the idle redraw is due.  Time spent waiting doesn't
+            // advance the simulation.
+            if (false == FrameScheduler_ShouldDraw(g_frame_scheduler)) {
+                FrameScheduler_Wait(g_frame_scheduler);
+                QueryPerformanceCounter((LARGE_INTEGER*)&prev_time_stamp);
+                continue;
+            }
+            if (is_device_lost(g_render_ctx)) {
+                // Keep checking until the device can be reset.
+                FrameScheduler_Invalidate(g_frame_scheduler, 1);
+            } else {
                 __int64 curr_time_stamp = 0;
                 QueryPerformanceCounter((LARGE_INTEGER*)&curr_time_stamp);
                 float dt = (curr_time_stamp - prev_time_stamp) * secs_per_cnt;
 
+                // Hand over any textures the workers finished decoding.
+                pump_assets(g_render_ctx);
+                if (AssetLoader_Pending(g_asset_loader) > 0)
+                    FrameScheduler_Invalidate(g_frame_scheduler, 1);
+
                 //
                 // DearImGui
                 // 
@@ -694,14 +1129,42 @@ WinMain (
                     ImGui::SameLine();
                     ImGui::Text("counter = %d", counter);
 
-                    ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+                    if (AssetLoader_Pending(g_asset_loader) > 0)
+                        ImGui::Text("Loading assets... (%u left)", AssetLoader_Pending(g_asset_loader));
+                    else
+                        ImGui::Text("Assets loaded in %.1f ms (%u KB of textures)", g_render_ctx->load_ms, g_render_ctx->texture_bytes / 1024);
+                    GeometryRingStats ring = GeometryRing_Stats(g_geometry_ring);
+                    ImGui::Text(
+                        "Streamed geometry: %u KB/frame, peak %u KB of %u KB, %u locks, %u discards",
+                        (ring.vertex_frame_bytes + ring.index_frame_bytes) / 1024,
+                        (ring.vertex_high_water + ring.index_high_water) / 1024,
+                        (ring.vertex_size + ring.index_size) / 1024, ring.locks, ring.discards
+                    );
+                    ImGui::Text("Last device reset: %.2f ms", DeviceResources_LastResetMs(g_device_resources));
+                    // Updated once a second: text changing every frame would
+                    // get every frame presented.
+                    FrameSchedulerStats frames = FrameScheduler_Stats(g_frame_scheduler);
+                    ImGui::Text("Frames drawn: %u/s (%u idle redraws), %u presented", frames.frames, frames.idle_frames, frames.presents);
+                    ImGui::Text("Application average %.3f ms/frame, %.0f%% of the time idle", frames.frame_ms, frames.idle_percent);
                     ImGui::End();
 
                     ImGui::EndFrame();
+
+                    // Keep drawing while a widget is held, a window is being
+                    // dragged or text is being typed (the caret blinks).
+                    ImGuiIO & io = ImGui::GetIO();
+                    if (ImGui::IsAnyItemActive() || io.WantTextInput || (io.WantCaptureMouse && ImGui::IsAnyMouseDown()))
+                        FrameScheduler_Invalidate(g_frame_scheduler, 1);
                 }
 
-                update_scene(g_render_ctx, dt);
-                draw_scene(g_render_ctx);
+                if (update_scene(g_render_ctx, dt))
+                    FrameScheduler_MarkDirty(g_frame_scheduler);
+
+                // Neither the scene nor the UI changed: what's on screen is
+                // still right, so it is neither rendered nor presented again.
+                ImGui::Render();
+                if (FrameScheduler_ShouldPresent(g_frame_scheduler, ImGui::GetDrawData()->ContentHash))
+                    draw_scene(g_render_ctx);
 
                 // Prepare for next iteration: The current time stamp becomes
                 // the previous time stamp for the next iteration.
@@ -723,12 +1186,19 @@ WinMain (
     ImGui::DestroyContext();
 
 
+    AssetLoader_Destroy(g_asset_loader);
+    SpriteBatch_Destroy(g_render_ctx->sprites);
+    GeometryRing_Destroy(g_geometry_ring);
+    DeviceResources_Destroy(g_device_resources);
+    ThreadPool_Destroy(g_thread_pool);
+
     BulletArray_Deinit(g_bullets);
     ::free(bullets_memory);
 
     DirectInput_Deinit(g_dinput);
 
     ::free(g_render_ctx);
+    FrameScheduler_Destroy(g_frame_scheduler);
 #pragma endregion
 }
 
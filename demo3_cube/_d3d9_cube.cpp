@@ -11,6 +11,8 @@
 #include "Common.h"
 
 #include "DirectInput.h"
+#include "FrameScheduler.h"
+#include "DeviceResources.h"
 #include "Vertex.h"
 
 #include <DearImGui/imgui.h>
@@ -48,20 +50,21 @@ typedef struct {
 
 D3D9RenderContext * g_render_ctx = nullptr;
 DirectInput * g_dinput = nullptr;
+FrameScheduler * g_frame_scheduler = nullptr;
+DeviceResources * g_device_resources = nullptr;
 VertexPos g_vertex_pos = {};
 
+// A scene with nothing going on is still redrawn this often, which is
+// also when polled state (DirectInput devices) gets looked at.
+#define IDLE_REDRAW_MS  500
+
 // Helper functions.
 static void
 create_vertex_buffer (D3D9RenderContext * render_ctx) {
-    // Obtain a pointer to a new vertex buffer.
-    render_ctx->device->CreateVertexBuffer(8 * sizeof(VertexPos), D3DUSAGE_WRITEONLY,
-        0, D3DPOOL_MANAGED, &render_ctx->vb, 0);
-
-    // Now lock it to obtain a pointer to its internal data, and write the
-    // cube's vertex data.
+    // Write the cube's vertex data, then hand it to the registry: it
+    // creates the D3DPOOL_DEFAULT buffer and refills it after a reset.
 
-    VertexPos * v = nullptr;
-    render_ctx->vb->Lock(0, 0, (void**)&v, 0);
+    VertexPos v[8] = {};
 
     v[0].pos = D3DXVECTOR3(-1.0f, -1.0f, -1.0f);
     v[1].pos = D3DXVECTOR3(-1.0f, 1.0f, -1.0f);
@@ -72,20 +75,15 @@ create_vertex_buffer (D3D9RenderContext * render_ctx) {
     v[6].pos = D3DXVECTOR3(1.0f, 1.0f, 1.0f);
     v[7].pos = D3DXVECTOR3(1.0f, -1.0f, 1.0f);
 
-    render_ctx->vb->Unlock();
+    DeviceResources_CreateVertexBuffer(g_device_resources, sizeof(v), D3DUSAGE_WRITEONLY,
+        0, v, &render_ctx->vb);
 }
 static void
 create_index_buffer (D3D9RenderContext * render_ctx) {
-    // Obtain a pointer to a new index buffer.
-    render_ctx->device->CreateIndexBuffer(36 * sizeof(WORD), D3DUSAGE_WRITEONLY,
-        D3DFMT_INDEX16, D3DPOOL_MANAGED, &render_ctx->ib, 0);
-
-    // Now lock it to obtain a pointer to its internal data, and write the
-    // cube's index data.
+    // Write the cube's index data, then hand it to the registry as for
+    // the vertices.
 
-    WORD * k = 0;
-
-    render_ctx->ib->Lock(0, 0, (void**)&k, 0);
+    WORD k[36];
 
     // Front face.
     k[0] = 0; k[1] = 1; k[2] = 2;
@@ -111,7 +109,8 @@ create_index_buffer (D3D9RenderContext * render_ctx) {
     k[30] = 4; k[31] = 0; k[32] = 3;
     k[33] = 4; k[34] = 3; k[35] = 7;
 
-    render_ctx->ib->Unlock();
+    DeviceResources_CreateIndexBuffer(g_device_resources, sizeof(k), D3DUSAGE_WRITEONLY,
+        D3DFMT_INDEX16, k, &render_ctx->ib);
 }
 static void
 create_view_mat(D3D9RenderContext * render_ctx) {
@@ -134,18 +133,32 @@ check_device_caps () {
     return true;
 }
 static void
-d3d9_lost_device (D3D9RenderContext * render_ctx) {
-    //
+imgui_lost (void * user) {
+    ImGui_ImplDX9_InvalidateDeviceObjects();
 }
 static void
-d3d9_reset_device (D3D9RenderContext * render_ctx) {
-    ImGui_ImplDX9_InvalidateDeviceObjects();
-    render_ctx->device->Reset(&render_ctx->present_params);
+imgui_restore (IDirect3DDevice9 * device, void * user) {
     ImGui_ImplDX9_CreateDeviceObjects();
-
+}
+static void
+proj_restore (IDirect3DDevice9 * device, void * user) {
     // The aspect ratio depends on the backbuffer dimensions, which can 
     // possibly change after a reset.  So rebuild the projection matrix.
-    create_proj_mat(render_ctx);
+    create_proj_mat((D3D9RenderContext *)user);
+}
+static void
+register_device_resources (D3D9RenderContext * render_ctx) {
+    DeviceResourceDesc const descs[] = {
+        {"imgui",           imgui_lost, imgui_restore,   0},
+        {"projection",      0,          proj_restore,    render_ctx},
+    };
+    for (int i = 0; i < _countof(descs); ++i)
+        DeviceResources_Add(g_device_resources, &descs[i]);
+}
+static void
+d3d9_reset_device (D3D9RenderContext * render_ctx) {
+    DeviceResources_Reset(g_device_resources, &render_ctx->present_params);
+    FrameScheduler_MarkDirty(g_frame_scheduler);
 }
 static bool is_device_lost (D3D9RenderContext * render_ctx) {
     // Get the state of the graphics device.
@@ -162,7 +175,6 @@ static bool is_device_lost (D3D9RenderContext * render_ctx) {
         return true;
     } else if (hr == D3DERR_DEVICENOTRESET) {
         // The device is lost but we can reset and restore it.
-        d3d9_lost_device(render_ctx);
         d3d9_reset_device(render_ctx);
         return false;
     } else
@@ -213,14 +225,18 @@ d3d9_enable_fullscreen_mode (D3D9RenderContext * render_ctx, bool enable) {
     }
 
     // Reset the device with the changes.
-    d3d9_lost_device(render_ctx);
     d3d9_reset_device(render_ctx);
 }
-static void
+// Returns true while the camera is moving.
+static bool
 update_scene (D3D9RenderContext * render_ctx, float dt) {
     // Get snapshot of input devices.
     DirectInput_Poll(g_dinput);
 
+    float prev_rotation_y = render_ctx->camera_rotation_y;
+    float prev_radius     = render_ctx->camera_radius;
+    float prev_height     = render_ctx->camera_height;
+
     // Check input.
     if (DirectInput_KeyDown(g_dinput, DIK_W))
         render_ctx->camera_height   += 25.0f * dt;
@@ -243,6 +259,11 @@ update_scene (D3D9RenderContext * render_ctx, float dt) {
     // change every frame based on input, so we need to rebuild the
     // view matrix every frame with the latest changes.
     create_view_mat(render_ctx);
+
+    return DirectInput_KeyDown(g_dinput, DIK_W) || DirectInput_KeyDown(g_dinput, DIK_S) ||
+           prev_rotation_y != render_ctx->camera_rotation_y ||
+           prev_radius     != render_ctx->camera_radius ||
+           prev_height     != render_ctx->camera_height;
 }
 static void
 draw_scene (D3D9RenderContext * render_ctx) {
@@ -268,7 +289,6 @@ draw_scene (D3D9RenderContext * render_ctx) {
     render_ctx->device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, 8, 0, 12);
 
 #ifdef ENABLE_IMGUI
-    ImGui::Render();
     ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
 #endif // ENABLE_IMGUI
 
@@ -307,7 +327,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
             } else if (wparam == SIZE_MAXIMIZED) {
                 render_ctx->paused = false;
                 min_maxed = true;
-                d3d9_lost_device(render_ctx);
                 d3d9_reset_device(render_ctx);
             }
             // Restored is any resize that is not a minimize or maximize.
@@ -321,7 +340,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
                 // and are in windowed mode?  Do not execute this code if 
                 // we are restoring to full screen mode.
                 if (min_maxed && render_ctx->present_params.Windowed) {
-                    d3d9_lost_device(render_ctx);
                     d3d9_reset_device(render_ctx);
                 } else {
                     // No, which implies the user is resizing by dragging
@@ -346,7 +364,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
         GetClientRect(render_ctx->wnd, &client_rect);
         render_ctx->present_params.BackBufferWidth  = client_rect.right;
         render_ctx->present_params.BackBufferHeight = client_rect.bottom;
-        d3d9_lost_device(render_ctx);
         d3d9_reset_device(render_ctx);
 
         return 0;
@@ -376,6 +393,7 @@ extern IMGUI_IMPL_API LRESULT
 ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 LRESULT CALLBACK
 wnd_proc (HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
+    FrameScheduler_OnMessage(g_frame_scheduler, msg);
     if (ImGui_ImplWin32_WndProcHandler(hwnd, msg, wparam, lparam))
         return true;
     // Don't start processing messages until the application has been created.
@@ -494,6 +512,8 @@ init_render_ctx (
 
         render_ctx->initialized = true;
 
+        g_device_resources = DeviceResources_Create(render_ctx->device);
+        register_device_resources(render_ctx);
         d3d9_reset_device(render_ctx);
     }
 }
@@ -506,6 +526,9 @@ WinMain (
 
 #pragma region Initialize
 
+    // First, as the window procedure reports to it from the start.
+    g_frame_scheduler = FrameScheduler_Create(IDLE_REDRAW_MS);
+
     g_render_ctx = (D3D9RenderContext *)::malloc(sizeof(D3D9RenderContext));
     init_render_ctx(
         g_render_ctx,
@@ -571,7 +594,18 @@ WinMain (
                 Sleep(20);
                 continue;
             }
-            if (false == is_device_lost(g_render_ctx)) {
+            // Nothing changed since the last frame: block until something
+            // does or the idle redraw is due.  Time spent waiting doesn't
+            // advance the simulation.
+            if (false == FrameScheduler_ShouldDraw(g_frame_scheduler)) {
+                FrameScheduler_Wait(g_frame_scheduler);
+                QueryPerformanceCounter((LARGE_INTEGER*)&prev_time_stamp);
+                continue;
+            }
+            if (is_device_lost(g_render_ctx)) {
+                // Keep checking until the device can be reset.
+                FrameScheduler_Invalidate(g_frame_scheduler, 1);
+            } else {
                 __int64 curr_time_stamp = 0;
                 QueryPerformanceCounter((LARGE_INTEGER*)&curr_time_stamp);
                 float dt = (curr_time_stamp - prev_time_stamp) * secs_per_cnt;
@@ -596,14 +630,30 @@ WinMain (
                     ImGui::SameLine();
                     ImGui::Text("counter = %d", counter);
 
-                    ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+                    // Updated once a second: text changing every frame would
+                    // get every frame presented.
+                    FrameSchedulerStats frames = FrameScheduler_Stats(g_frame_scheduler);
+                    ImGui::Text("Frames drawn: %u/s (%u idle redraws), %u presented", frames.frames, frames.idle_frames, frames.presents);
+                    ImGui::Text("Application average %.3f ms/frame, %.0f%% of the time idle", frames.frame_ms, frames.idle_percent);
                     ImGui::End();
 
                     ImGui::EndFrame();
+
+                    // Keep drawing while a widget is held, a window is being
+                    // dragged or text is being typed (the caret blinks).
+                    ImGuiIO & io = ImGui::GetIO();
+                    if (ImGui::IsAnyItemActive() || io.WantTextInput || (io.WantCaptureMouse && ImGui::IsAnyMouseDown()))
+                        FrameScheduler_Invalidate(g_frame_scheduler, 1);
                 }
 
-                update_scene(g_render_ctx, dt);
-                draw_scene(g_render_ctx);
+                if (update_scene(g_render_ctx, dt))
+                    FrameScheduler_MarkDirty(g_frame_scheduler);
+
+                // Neither the scene nor the UI changed: what's on screen is
+                // still right, so it is neither rendered nor presented again.
+                ImGui::Render();
+                if (FrameScheduler_ShouldPresent(g_frame_scheduler, ImGui::GetDrawData()->ContentHash))
+                    draw_scene(g_render_ctx);
 
                 // Prepare for next iteration: The current time stamp becomes
                 // the previous time stamp for the next iteration.
@@ -625,8 +675,10 @@ WinMain (
     ImGui::DestroyContext();
 
     DirectInput_Deinit(g_dinput);
+    DeviceResources_Destroy(g_device_resources);
 
     ::free(g_render_ctx);
+    FrameScheduler_Destroy(g_frame_scheduler);
 #pragma endregion
 }
 
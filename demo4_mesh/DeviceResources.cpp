@@ -0,0 +1,177 @@
+#include "DeviceResources.h"
+
+#include <chrono>
+
+#include <stdlib.h>
+#include <string.h>
+
+// A buffer created through the registry, with what it takes to build it
+// again.
+struct RegistryBuffer {
+    UINT                        length;
+    DWORD                       usage;
+    DWORD                       fvf;
+    D3DFORMAT                   format;
+    void *                      shadow;     // null for dynamic buffers
+    IDirect3DVertexBuffer9 **   vb;         // exactly one of vb/ib is set
+    IDirect3DIndexBuffer9 **    ib;
+};
+
+struct DeviceResourceEntry {
+    DeviceResourceDesc  desc;
+    RegistryBuffer *    buffer;
+    bool                used;
+};
+
+struct DeviceResources {
+    IDirect3DDevice9 *      device;
+
+    // Ids index this array and are never reused, which keeps the
+    // registration order that lost/restore rely on.
+    DeviceResourceEntry *   entries;
+    uint32_t                count;
+    uint32_t                capacity;
+
+    float                   last_reset_ms;
+};
+
+static void
+buffer_lost (void * user) {
+    RegistryBuffer * buffer = (RegistryBuffer *)user;
+    if (buffer->vb && *buffer->vb) {
+        (*buffer->vb)->Release();
+        *buffer->vb = 0;
+    }
+    if (buffer->ib && *buffer->ib) {
+        (*buffer->ib)->Release();
+        *buffer->ib = 0;
+    }
+}
+static void
+buffer_restore (IDirect3DDevice9 * device, void * user) {
+    RegistryBuffer * buffer = (RegistryBuffer *)user;
+    void * dst = 0;
+    if (buffer->vb) {
+        if (FAILED(device->CreateVertexBuffer(buffer->length, buffer->usage, buffer->fvf, D3DPOOL_DEFAULT, buffer->vb, 0)))
+            return;
+        if (buffer->shadow && SUCCEEDED((*buffer->vb)->Lock(0, 0, &dst, 0))) {
+            memcpy(dst, buffer->shadow, buffer->length);
+            (*buffer->vb)->Unlock();
+        }
+    } else {
+        if (FAILED(device->CreateIndexBuffer(buffer->length, buffer->usage, buffer->format, D3DPOOL_DEFAULT, buffer->ib, 0)))
+            return;
+        if (buffer->shadow && SUCCEEDED((*buffer->ib)->Lock(0, 0, &dst, 0))) {
+            memcpy(dst, buffer->shadow, buffer->length);
+            (*buffer->ib)->Unlock();
+        }
+    }
+}
+static uint32_t
+add_buffer (DeviceResources * resources, RegistryBuffer * buffer, void const * data, char const * name) {
+    if (data) {
+        buffer->shadow = ::malloc(buffer->length);
+        memcpy(buffer->shadow, data, buffer->length);
+    }
+    buffer_restore(resources->device, buffer);
+
+    DeviceResourceDesc desc = {name, buffer_lost, buffer_restore, buffer};
+    uint32_t id = DeviceResources_Add(resources, &desc);
+    resources->entries[id].buffer = buffer;
+    return id;
+}
+
+DeviceResources *
+DeviceResources_Create (IDirect3DDevice9 * device) {
+    DeviceResources * resources = (DeviceResources *)::calloc(1, sizeof(DeviceResources));
+    resources->device = device;
+    return resources;
+}
+void
+DeviceResources_Destroy (DeviceResources * resources) {
+    if (0 == resources)
+        return;
+    for (uint32_t i = 0; i < resources->count; ++i)
+        if (resources->entries[i].used && resources->entries[i].buffer)
+            DeviceResources_Remove(resources, i);
+    ::free(resources->entries);
+    ::free(resources);
+}
+uint32_t
+DeviceResources_Add (DeviceResources * resources, DeviceResourceDesc const * desc) {
+    if (resources->count == resources->capacity) {
+        resources->capacity = resources->capacity ? resources->capacity * 2 : 16;
+        resources->entries = (DeviceResourceEntry *)::realloc(
+            resources->entries, resources->capacity * sizeof(DeviceResourceEntry)
+        );
+    }
+    DeviceResourceEntry * entry = &resources->entries[resources->count];
+    entry->desc     = *desc;
+    entry->buffer   = 0;
+    entry->used     = true;
+    return resources->count++;
+}
+void
+DeviceResources_Remove (DeviceResources * resources, uint32_t id) {
+    DeviceResourceEntry * entry = &resources->entries[id];
+    if (false == entry->used)
+        return;
+    if (entry->buffer) {
+        buffer_lost(entry->buffer);
+        ::free(entry->buffer->shadow);
+        ::free(entry->buffer);
+        entry->buffer = 0;
+    }
+    entry->used = false;
+}
+uint32_t
+DeviceResources_CreateVertexBuffer (
+    DeviceResources * resources, UINT length, DWORD usage, DWORD fvf,
+    void const * data, IDirect3DVertexBuffer9 ** buffer
+) {
+    RegistryBuffer * rb = (RegistryBuffer *)::calloc(1, sizeof(RegistryBuffer));
+    rb->length  = length;
+    rb->usage   = usage;
+    rb->fvf     = fvf;
+    rb->vb      = buffer;
+    return add_buffer(resources, rb, data, "vertex buffer");
+}
+uint32_t
+DeviceResources_CreateIndexBuffer (
+    DeviceResources * resources, UINT length, DWORD usage, D3DFORMAT format,
+    void const * data, IDirect3DIndexBuffer9 ** buffer
+) {
+    RegistryBuffer * rb = (RegistryBuffer *)::calloc(1, sizeof(RegistryBuffer));
+    rb->length  = length;
+    rb->usage   = usage;
+    rb->format  = format;
+    rb->ib      = buffer;
+    return add_buffer(resources, rb, data, "index buffer");
+}
+HRESULT
+DeviceResources_Reset (DeviceResources * resources, D3DPRESENT_PARAMETERS * params) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = resources->count; i-- > 0; ) {
+        DeviceResourceEntry * entry = &resources->entries[i];
+        if (entry->used && entry->desc.lost)
+            entry->desc.lost(entry->desc.user);
+    }
+
+    HRESULT hr = resources->device->Reset(params);
+    if (FAILED(hr))
+        return hr;
+
+    for (uint32_t i = 0; i < resources->count; ++i) {
+        DeviceResourceEntry * entry = &resources->entries[i];
+        if (entry->used && entry->desc.restore)
+            entry->desc.restore(resources->device, entry->desc.user);
+    }
+
+    resources->last_reset_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return hr;
+}
+float
+DeviceResources_LastResetMs (DeviceResources const * resources) {
+    return resources->last_reset_ms;
+}
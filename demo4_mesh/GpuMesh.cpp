@@ -0,0 +1,188 @@
+#include "GpuMesh.h"
+#include "MeshSimplify.h"
+
+bool
+GpuMesh_CreateFromCache (IDirect3DDevice9 * device, MeshCache const * cache, GpuMesh * mesh) {
+    memset(mesh, 0, sizeof(*mesh));
+    MeshCacheHeader const * header = cache->header;
+
+    UINT vb_size = header->vertex_count * header->vertex_stride;
+    UINT ib_size = header->index_count * header->index_size;
+    D3DFORMAT index_format = (header->index_size == 2) ? D3DFMT_INDEX16 : D3DFMT_INDEX32;
+
+    // MeshCacheVertexElement mirrors D3DVERTEXELEMENT9, so the declaration
+    // is read straight out of the mapping.
+    static_assert(sizeof(MeshCacheVertexElement) == sizeof(D3DVERTEXELEMENT9), "vertex element layout mismatch");
+    if (FAILED(device->CreateVertexDeclaration((D3DVERTEXELEMENT9 const *)header->decl, &mesh->decl)))
+        return false;
+
+    if (FAILED(device->CreateVertexBuffer(vb_size, D3DUSAGE_WRITEONLY, 0, D3DPOOL_MANAGED, &mesh->vb, 0)) ||
+        FAILED(device->CreateIndexBuffer(ib_size, D3DUSAGE_WRITEONLY, index_format, D3DPOOL_MANAGED, &mesh->ib, 0))) {
+        GpuMesh_Release(mesh);
+        return false;
+    }
+
+    // One copy per buffer, straight from the mapped pages into the locked
+    // buffer: no intermediate parse or staging step.
+    void * dst = 0;
+    if (FAILED(mesh->vb->Lock(0, 0, &dst, 0))) {
+        GpuMesh_Release(mesh);
+        return false;
+    }
+    memcpy(dst, cache->vertices, vb_size);
+    mesh->vb->Unlock();
+    if (FAILED(mesh->ib->Lock(0, 0, &dst, 0))) {
+        GpuMesh_Release(mesh);
+        return false;
+    }
+    memcpy(dst, cache->indices, ib_size);
+    mesh->ib->Unlock();
+
+    mesh->stride    = header->vertex_stride;
+    mesh->lod_count = header->lod_count;
+    memcpy(mesh->lods, header->lods, header->lod_count * sizeof(MeshCacheLod));
+    mesh->center    = D3DXVECTOR3(header->bounds_center[0], header->bounds_center[1], header->bounds_center[2]);
+    mesh->radius    = header->bounds_radius;
+    return true;
+}
+bool
+GpuMesh_WriteCache (ID3DXMesh * d3dx_mesh, char const * path, uint64_t key, UINT max_lods) {
+    D3DVERTEXELEMENT9 decl[MAX_FVF_DECL_SIZE];
+    if (FAILED(d3dx_mesh->GetDeclaration(decl)))
+        return false;
+
+    // D3DX shapes only use a handful of elements; refuse anything that
+    // wouldn't fit the cache header rather than truncating it.
+    UINT decl_count = D3DXGetDeclLength(decl) + 1;
+    if (decl_count > MESH_CACHE_MAX_DECL_ELEMENTS)
+        return false;
+
+    // The simplifier needs float3 positions.
+    int pos_offset = -1;
+    for (UINT i = 0; i + 1 < decl_count; ++i) {
+        if (decl[i].Usage == D3DDECLUSAGE_POSITION && decl[i].UsageIndex == 0 && decl[i].Type == D3DDECLTYPE_FLOAT3)
+            pos_offset = decl[i].Offset;
+    }
+    if (pos_offset < 0)
+        max_lods = 1;
+
+    void * vertices = 0;
+    void * indices = 0;
+    if (FAILED(d3dx_mesh->LockVertexBuffer(D3DLOCK_READONLY, &vertices)))
+        return false;
+    if (FAILED(d3dx_mesh->LockIndexBuffer(D3DLOCK_READONLY, &indices))) {
+        d3dx_mesh->UnlockVertexBuffer();
+        return false;
+    }
+
+    UINT stride     = d3dx_mesh->GetNumBytesPerVertex();
+    UINT nverts     = d3dx_mesh->GetNumVertices();
+    UINT nindices   = d3dx_mesh->GetNumFaces() * 3;
+    bool is_32bit   = (d3dx_mesh->GetOptions() & D3DXMESH_32BIT) != 0;
+
+    MeshCacheDesc desc = {};
+    desc.key            = key;
+    desc.decl           = (MeshCacheVertexElement const *)decl;
+    desc.vertices       = vertices;
+    desc.vertex_stride  = stride;
+    desc.vertex_count   = nverts;
+    desc.indices        = indices;
+    desc.index_size     = is_32bit ? 4 : 2;
+    desc.index_count    = nindices;
+
+    // Build the LOD chain.  All levels share the vertex buffer, so only
+    // the concatenated index buffer and the LOD table change.
+    MeshCacheLod lods[MESH_CACHE_MAX_LODS];
+    uint32_t * lod_indices = 0;
+    void * packed_indices = 0;
+    bool ret = true;
+    if (max_lods > 1) {
+        uint32_t * indices32 = (uint32_t *)::malloc(nindices * sizeof(uint32_t));
+        if (0 == indices32) {
+            d3dx_mesh->UnlockIndexBuffer();
+            d3dx_mesh->UnlockVertexBuffer();
+            return false;
+        }
+        for (UINT i = 0; i < nindices; ++i)
+            indices32[i] = is_32bit ? ((DWORD *)indices)[i] : ((WORD *)indices)[i];
+
+        size_t total = 0;
+        desc.lod_count = MeshSimplify_BuildLodChain(
+            indices32, nindices,
+            (float const *)((BYTE *)vertices + pos_offset), nverts, stride,
+            max_lods, 0.5f,
+            &lod_indices, &total, lods
+        );
+        desc.lods = lods;
+        desc.index_count = (uint32_t)total;
+        ::free(indices32);
+
+        if (is_32bit) {
+            desc.indices = lod_indices;
+        } else {
+            WORD * indices16 = (WORD *)::malloc(total * sizeof(WORD));
+            if (0 == indices16) {
+                ret = false;
+            } else {
+                for (size_t i = 0; i < total; ++i)
+                    indices16[i] = (WORD)lod_indices[i];
+                desc.indices = packed_indices = indices16;
+            }
+        }
+    }
+    if (ret)
+        ret = MeshCache_Write(path, &desc);
+
+    ::free(packed_indices);
+    ::free(lod_indices);
+    d3dx_mesh->UnlockIndexBuffer();
+    d3dx_mesh->UnlockVertexBuffer();
+    return ret;
+}
+UINT
+GpuMesh_SelectLod (GpuMesh const * mesh, D3DXMATRIX const * world_view, float proj_scale, float max_pixel_error) {
+    // View-space distance to the nearest point of the bounding sphere
+    // (assumes world_view has no scaling, which holds for the demos).
+    D3DXVECTOR3 center;
+    D3DXVec3TransformCoord(&center, &mesh->center, world_view);
+    float distance = D3DXVec3Length(&center) - mesh->radius;
+    if (distance <= 0.0f)
+        return 0;
+
+    // Pick the coarsest level whose geometric error projects to at most
+    // max_pixel_error pixels on screen.
+    UINT lod = 0;
+    for (UINT i = 1; i < mesh->lod_count; ++i) {
+        float pixels = mesh->lods[i].error * proj_scale / distance;
+        if (pixels > max_pixel_error)
+            break;
+        lod = i;
+    }
+    return lod;
+}
+void
+GpuMesh_Bind (IDirect3DDevice9 * device, GpuMesh const * mesh) {
+    device->SetStreamSource(0, mesh->vb, 0, mesh->stride);
+    device->SetIndices(mesh->ib);
+    device->SetVertexDeclaration(mesh->decl);
+}
+void
+GpuMesh_Draw (IDirect3DDevice9 * device, GpuMesh const * mesh, UINT lod) {
+    if (lod >= mesh->lod_count)
+        lod = mesh->lod_count - 1;
+    MeshCacheLod const * l = &mesh->lods[lod];
+    device->DrawIndexedPrimitive(
+        D3DPT_TRIANGLELIST, 0,
+        l->min_vertex, l->num_vertices,
+        l->index_start, l->index_count / 3
+    );
+}
+void
+GpuMesh_Release (GpuMesh * mesh) {
+    if (mesh->vb)   mesh->vb->Release();
+    if (mesh->ib)   mesh->ib->Release();
+    if (mesh->decl) mesh->decl->Release();
+    mesh->vb = 0;
+    mesh->ib = 0;
+    mesh->decl = 0;
+}
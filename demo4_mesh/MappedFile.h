@@ -0,0 +1,21 @@
+#pragma once
+
+// Read-only memory mapping of a whole file. The mapping stays valid
+// until MappedFile_Close, so callers can hand out pointers into it
+// instead of reading the file into their own buffers.
+
+#include <stddef.h>
+
+struct MappedFile {
+    void const *    data;
+    size_t          size;
+
+    // platform handles
+    void *          file_handle;
+    void *          mapping_handle;
+};
+
+bool
+MappedFile_Open (MappedFile * file, char const * path);
+void
+MappedFile_Close (MappedFile * file);
@@ -0,0 +1,206 @@
+#include "MeshCache.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Values from d3d9types.h, repeated so that this file builds without the DirectX headers.
+static uint8_t const decl_type_float3   = 2;    // D3DDECLTYPE_FLOAT3
+static uint8_t const decl_usage_pos     = 0;    // D3DDECLUSAGE_POSITION
+static uint16_t const decl_end_stream   = 0xFF; // D3DDECL_END()
+static uint8_t const decl_type_unused   = 17;   // D3DDECLTYPE_UNUSED, in D3DDECL_END()
+
+static uint64_t
+align_up (uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+static uint32_t
+count_decl_elements (MeshCacheVertexElement const * decl) {
+    // Including the end element; 0 if there is none within the limit.
+    for (uint32_t n = 0; n < MESH_CACHE_MAX_DECL_ELEMENTS; ++n) {
+        if (decl[n].stream == decl_end_stream)
+            return n + 1;
+    }
+    return 0;
+}
+static void
+compute_bounds (MeshCacheDesc const * desc, MeshCacheHeader * header) {
+    // Find the position element; meshes without one get empty bounds.
+    int pos_offset = -1;
+    for (uint32_t i = 0; i + 1 < header->decl_count; ++i) {
+        if (header->decl[i].usage == decl_usage_pos && header->decl[i].usage_index == 0 &&
+            header->decl[i].type == decl_type_float3) {
+            pos_offset = header->decl[i].offset;
+            break;
+        }
+    }
+    if (pos_offset < 0 || 0 == desc->vertex_count)
+        return;
+
+    float mn[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float mx[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    uint8_t const * v = (uint8_t const *)desc->vertices + pos_offset;
+    for (uint32_t i = 0; i < desc->vertex_count; ++i, v += desc->vertex_stride) {
+        float p[3];
+        memcpy(p, v, sizeof(p));
+        for (int c = 0; c < 3; ++c) {
+            if (p[c] < mn[c]) mn[c] = p[c];
+            if (p[c] > mx[c]) mx[c] = p[c];
+        }
+    }
+
+    float radius_sq = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        header->bounds_min[c] = mn[c];
+        header->bounds_max[c] = mx[c];
+        header->bounds_center[c] = 0.5f * (mn[c] + mx[c]);
+    }
+    v = (uint8_t const *)desc->vertices + pos_offset;
+    for (uint32_t i = 0; i < desc->vertex_count; ++i, v += desc->vertex_stride) {
+        float p[3];
+        memcpy(p, v, sizeof(p));
+        float dx = p[0] - header->bounds_center[0];
+        float dy = p[1] - header->bounds_center[1];
+        float dz = p[2] - header->bounds_center[2];
+        float d = dx * dx + dy * dy + dz * dz;
+        if (d > radius_sq) radius_sq = d;
+    }
+    header->bounds_radius = sqrtf(radius_sq);
+}
+static bool
+write_padding (FILE * fp, uint64_t from, uint64_t to) {
+    static uint8_t const zeros[MESH_CACHE_BLOB_ALIGNMENT] = {};
+    size_t n = (size_t)(to - from);
+    return n == 0 || fwrite(zeros, 1, n, fp) == n;
+}
+uint64_t
+MeshCache_HashKey (void const * data, size_t size, uint64_t seed) {
+    // FNV-1a, 64-bit.
+    uint64_t h = seed ^ 0xCBF29CE484222325ull;
+    uint8_t const * p = (uint8_t const *)data;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+bool
+MeshCache_Write (char const * path, MeshCacheDesc const * desc) {
+    if (desc->index_size != 2 && desc->index_size != 4)
+        return false;
+    if (desc->lod_count > MESH_CACHE_MAX_LODS)
+        return false;
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic            = MESH_CACHE_MAGIC;
+    header.version          = MESH_CACHE_VERSION;
+    header.header_size      = sizeof(MeshCacheHeader);
+    header.key              = desc->key;
+    header.vertex_stride    = desc->vertex_stride;
+    header.vertex_count     = desc->vertex_count;
+    header.index_size       = desc->index_size;
+    header.index_count      = desc->index_count;
+
+    header.decl_count = count_decl_elements(desc->decl);
+    if (0 == header.decl_count)
+        return false;
+    memcpy(header.decl, desc->decl, header.decl_count * sizeof(MeshCacheVertexElement));
+
+    if (desc->lod_count > 0) {
+        header.lod_count = desc->lod_count;
+        memcpy(header.lods, desc->lods, desc->lod_count * sizeof(MeshCacheLod));
+    } else {
+        header.lod_count = 1;
+        header.lods[0].index_start  = 0;
+        header.lods[0].index_count  = desc->index_count;
+        header.lods[0].min_vertex   = 0;
+        header.lods[0].num_vertices = desc->vertex_count;
+        header.lods[0].error        = 0.0f;
+    }
+
+    compute_bounds(desc, &header);
+
+    uint64_t vb_size = (uint64_t)desc->vertex_count * desc->vertex_stride;
+    uint64_t ib_size = (uint64_t)desc->index_count * desc->index_size;
+    header.vertex_offset = align_up(sizeof(MeshCacheHeader), MESH_CACHE_BLOB_ALIGNMENT);
+    header.index_offset  = align_up(header.vertex_offset + vb_size, MESH_CACHE_BLOB_ALIGNMENT);
+    header.file_size     = header.index_offset + ib_size;
+
+    // Write to a temporary file first so that a crash mid-write never
+    // leaves a truncated cache behind that looks valid.
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE * fp = fopen(tmp_path, "wb");
+    if (0 == fp)
+        return false;
+
+    bool ok =
+        fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        write_padding(fp, sizeof(header), header.vertex_offset) &&
+        fwrite(desc->vertices, 1, (size_t)vb_size, fp) == vb_size &&
+        write_padding(fp, header.vertex_offset + vb_size, header.index_offset) &&
+        fwrite(desc->indices, 1, (size_t)ib_size, fp) == ib_size;
+    ok = (0 == fclose(fp)) && ok;
+
+    if (ok) {
+        remove(path);
+        ok = (0 == rename(tmp_path, path));
+    }
+    if (!ok)
+        remove(tmp_path);
+    return ok;
+}
+bool
+MeshCache_Open (MeshCache * cache, char const * path, uint64_t expected_key) {
+    memset(cache, 0, sizeof(*cache));
+    if (false == MappedFile_Open(&cache->file, path))
+        return false;
+
+    // Validate everything up front; after this, the blobs are used
+    // directly without any further checks or parsing.
+    MeshCacheHeader const * header = (MeshCacheHeader const *)cache->file.data;
+    bool valid =
+        cache->file.size >= sizeof(MeshCacheHeader) &&
+        header->magic == MESH_CACHE_MAGIC &&
+        header->version == MESH_CACHE_VERSION &&
+        header->header_size == sizeof(MeshCacheHeader) &&
+        header->key == expected_key &&
+        header->file_size == cache->file.size &&
+        (header->index_size == 2 || header->index_size == 4) &&
+        header->decl_count > 0 && header->decl_count <= MESH_CACHE_MAX_DECL_ELEMENTS &&
+        header->lod_count > 0 && header->lod_count <= MESH_CACHE_MAX_LODS &&
+        header->vertex_offset % MESH_CACHE_BLOB_ALIGNMENT == 0 &&
+        header->index_offset % MESH_CACHE_BLOB_ALIGNMENT == 0 &&
+        header->vertex_offset + (uint64_t)header->vertex_count * header->vertex_stride <= header->index_offset &&
+        header->index_offset + (uint64_t)header->index_count * header->index_size <= header->file_size;
+    // CreateVertexDeclaration reads up to the end element, which must be
+    // the last one.
+    valid = valid &&
+        count_decl_elements(header->decl) == header->decl_count &&
+        header->decl[header->decl_count - 1].type == decl_type_unused;
+    for (uint32_t i = 0; valid && i < header->lod_count; ++i) {
+        MeshCacheLod const * lod = &header->lods[i];
+        valid =
+            (uint64_t)lod->index_start + lod->index_count <= header->index_count &&
+            (uint64_t)lod->min_vertex + lod->num_vertices <= header->vertex_count;
+    }
+
+    if (!valid) {
+        MappedFile_Close(&cache->file);
+        memset(cache, 0, sizeof(*cache));
+        return false;
+    }
+
+    uint8_t const * base = (uint8_t const *)cache->file.data;
+    cache->header   = header;
+    cache->vertices = base + header->vertex_offset;
+    cache->indices  = base + header->index_offset;
+    return true;
+}
+void
+MeshCache_Close (MeshCache * cache) {
+    MappedFile_Close(&cache->file);
+    memset(cache, 0, sizeof(*cache));
+}
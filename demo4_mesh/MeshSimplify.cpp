@@ -0,0 +1,513 @@
+#include "MeshSimplify.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+// Border edges get an extra plane perpendicular to the face so open
+// boundaries (and welded seams that remain open) keep their shape.
+static double const border_weight = 10.0;
+static int const max_passes = 100;
+// Triangles removed by one collapse that are looked at to carry corners
+// over; more only happen around very badly shaped vertices.
+static int const max_removed_triangles = 16;
+
+struct Quadric {
+    double a2, b2, c2, d2;
+    double ab, ac, ad;
+    double bc, bd;
+    double cd;
+    double w;       // accumulated area, used to normalize the error
+};
+struct Vec3 {
+    double x, y, z;
+};
+struct Collapse {
+    uint32_t    from;
+    uint32_t    to;
+    double      cost;
+};
+
+static Vec3
+load_pos (float const * positions, size_t stride, uint32_t v) {
+    float const * p = (float const *)((uint8_t const *)positions + v * stride);
+    Vec3 ret = {p[0], p[1], p[2]};
+    return ret;
+}
+static Vec3
+sub (Vec3 a, Vec3 b) {
+    Vec3 ret = {a.x - b.x, a.y - b.y, a.z - b.z};
+    return ret;
+}
+static Vec3
+cross (Vec3 a, Vec3 b) {
+    Vec3 ret = {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    return ret;
+}
+static double
+dot (Vec3 a, Vec3 b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+static void
+quadric_add_plane (Quadric * q, Vec3 n, double d, double weight) {
+    q->a2 += weight * n.x * n.x;
+    q->b2 += weight * n.y * n.y;
+    q->c2 += weight * n.z * n.z;
+    q->d2 += weight * d * d;
+    q->ab += weight * n.x * n.y;
+    q->ac += weight * n.x * n.z;
+    q->ad += weight * n.x * d;
+    q->bc += weight * n.y * n.z;
+    q->bd += weight * n.y * d;
+    q->cd += weight * n.z * d;
+}
+static void
+quadric_add (Quadric * q, Quadric const * r) {
+    q->a2 += r->a2; q->b2 += r->b2; q->c2 += r->c2; q->d2 += r->d2;
+    q->ab += r->ab; q->ac += r->ac; q->ad += r->ad;
+    q->bc += r->bc; q->bd += r->bd;
+    q->cd += r->cd;
+    q->w  += r->w;
+}
+// Mean squared distance from p to the planes accumulated in q.
+static double
+quadric_error (Quadric const * q, Vec3 p) {
+    double e =
+        q->a2 * p.x * p.x + q->b2 * p.y * p.y + q->c2 * p.z * p.z +
+        2.0 * (q->ab * p.x * p.y + q->ac * p.x * p.z + q->bc * p.y * p.z) +
+        2.0 * (q->ad * p.x + q->bd * p.y + q->cd * p.z) +
+        q->d2;
+    e = fabs(e);
+    return q->w > 0.0 ? e / q->w : e;
+}
+// Maps every vertex to the lowest-numbered vertex with the same position.
+static void
+build_position_remap (
+    uint32_t * remap,
+    float const * positions, size_t vertex_count, size_t stride
+) {
+    uint32_t * order = (uint32_t *)::malloc(vertex_count * sizeof(uint32_t));
+    for (size_t i = 0; i < vertex_count; ++i)
+        order[i] = (uint32_t)i;
+
+    auto less = [&] (uint32_t a, uint32_t b) {
+        float const * pa = (float const *)((uint8_t const *)positions + a * stride);
+        float const * pb = (float const *)((uint8_t const *)positions + b * stride);
+        if (pa[0] != pb[0]) return pa[0] < pb[0];
+        if (pa[1] != pb[1]) return pa[1] < pb[1];
+        if (pa[2] != pb[2]) return pa[2] < pb[2];
+        return a < b;
+    };
+    std::sort(order, order + vertex_count, less);
+
+    size_t i = 0;
+    while (i < vertex_count) {
+        size_t j = i + 1;
+        float const * pi = (float const *)((uint8_t const *)positions + order[i] * stride);
+        while (j < vertex_count) {
+            float const * pj = (float const *)((uint8_t const *)positions + order[j] * stride);
+            if (pi[0] != pj[0] || pi[1] != pj[1] || pi[2] != pj[2])
+                break;
+            ++j;
+        }
+        // order is sorted by index within equal positions, so order[i]
+        // is the lowest vertex of the group.
+        for (size_t k = i; k < j; ++k)
+            remap[order[k]] = order[i];
+        i = j;
+    }
+    ::free(order);
+}
+// Counts how many triangles use each undirected edge; an edge used by a
+// single triangle is on a border.  Edges are kept in a sorted array of
+// (min, max) pairs for lookups.
+struct EdgeTable {
+    uint64_t *  keys;
+    uint32_t *  counts;
+    size_t      size;
+};
+static uint64_t
+edge_key (uint32_t a, uint32_t b) {
+    return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+}
+static void
+build_edge_table (EdgeTable * table, uint32_t const * indices, size_t index_count) {
+    uint64_t * keys = (uint64_t *)::malloc(index_count * sizeof(uint64_t));
+    for (size_t i = 0; i < index_count; i += 3) {
+        keys[i + 0] = edge_key(indices[i + 0], indices[i + 1]);
+        keys[i + 1] = edge_key(indices[i + 1], indices[i + 2]);
+        keys[i + 2] = edge_key(indices[i + 2], indices[i + 0]);
+    }
+    std::sort(keys, keys + index_count);
+
+    table->keys = keys;
+    table->counts = (uint32_t *)::malloc(index_count * sizeof(uint32_t));
+    table->size = 0;
+    for (size_t i = 0; i < index_count; ) {
+        size_t j = i + 1;
+        while (j < index_count && keys[j] == keys[i])
+            ++j;
+        table->keys[table->size] = keys[i];
+        table->counts[table->size] = (uint32_t)(j - i);
+        ++table->size;
+        i = j;
+    }
+}
+static uint32_t
+edge_count (EdgeTable const * table, uint32_t a, uint32_t b) {
+    uint64_t key = edge_key(a, b);
+    uint64_t const * it = std::lower_bound(table->keys, table->keys + table->size, key);
+    if (it == table->keys + table->size || *it != key)
+        return 0;
+    return table->counts[it - table->keys];
+}
+static void
+free_edge_table (EdgeTable * table) {
+    ::free(table->keys);
+    ::free(table->counts);
+}
+// Welded vertices stand for several original ones where attributes
+// differ at one position (normal seams, cylinder caps).  Each corner of a
+// surviving triangle keeps its own original vertex: when 'from' moves
+// onto 'to', a corner's original vertex is replaced by the one its side
+// of the seam used for 'to' in a triangle the collapse removes.  A corner
+// with no such triangle would have to borrow another side's attributes,
+// so the collapse is refused; seam vertices thereby only move along the
+// seam.  On success wedge_to[o] gives the replacement of original vertex
+// o for every corner of 'from'.
+static bool
+collapse_wedges (
+    uint32_t from, uint32_t to,
+    uint32_t const * indices, uint32_t const * corners,
+    uint32_t const * adjacency, uint32_t const * adjacency_offsets,
+    uint32_t * wedge_to
+) {
+    uint32_t pairs[max_removed_triangles][2];
+    int npairs = 0;
+    for (uint32_t k = adjacency_offsets[from]; k < adjacency_offsets[from + 1]; ++k) {
+        size_t t = (size_t)adjacency[k] * 3;
+        int f = -1, g = -1;
+        for (int c = 0; c < 3; ++c) {
+            if (indices[t + c] == from) f = c;
+            if (indices[t + c] == to)   g = c;
+        }
+        if (g < 0)
+            continue;
+        if (npairs == max_removed_triangles)
+            return false;
+        pairs[npairs][0] = corners[t + f];
+        pairs[npairs][1] = corners[t + g];
+        ++npairs;
+    }
+    for (uint32_t k = adjacency_offsets[from]; k < adjacency_offsets[from + 1]; ++k) {
+        size_t t = (size_t)adjacency[k] * 3;
+        if (indices[t + 0] == to || indices[t + 1] == to || indices[t + 2] == to)
+            continue;
+        uint32_t o = corners[t + (indices[t + 0] == from ? 0 : indices[t + 1] == from ? 1 : 2)];
+        int p = 0;
+        while (p < npairs && pairs[p][0] != o)
+            ++p;
+        if (p == npairs)
+            return false;
+        wedge_to[o] = pairs[p][1];
+    }
+    return true;
+}
+// Would moving 'from' onto 'to' flip or collapse any of the triangles
+// around 'from' that survive the collapse?
+static bool
+collapse_flips (
+    uint32_t from, uint32_t to,
+    uint32_t const * indices,
+    uint32_t const * adjacency, uint32_t const * adjacency_offsets,
+    float const * positions, size_t stride
+) {
+    Vec3 pf = load_pos(positions, stride, from);
+    Vec3 pt = load_pos(positions, stride, to);
+    for (uint32_t k = adjacency_offsets[from]; k < adjacency_offsets[from + 1]; ++k) {
+        uint32_t const * tri = &indices[adjacency[k] * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to)
+            continue;   // this triangle degenerates and is removed
+
+        // rotate so that 'from' comes first
+        uint32_t a = tri[1], b = tri[2];
+        if (tri[1] == from) { a = tri[2]; b = tri[0]; }
+        if (tri[2] == from) { a = tri[0]; b = tri[1]; }
+        Vec3 pa = load_pos(positions, stride, a);
+        Vec3 pb = load_pos(positions, stride, b);
+
+        Vec3 n0 = cross(sub(pa, pf), sub(pb, pf));
+        Vec3 n1 = cross(sub(pa, pt), sub(pb, pt));
+        double d = dot(n0, n1);
+        if (d <= 1e-3 * sqrt(dot(n0, n0) * dot(n1, n1)))
+            return true;
+    }
+    return false;
+}
+size_t
+MeshSimplify_Simplify (
+    uint32_t * dst_indices,
+    uint32_t const * indices, size_t index_count,
+    float const * positions, size_t vertex_count, size_t vertex_stride,
+    size_t target_index_count, float target_error,
+    float * out_error
+) {
+    // Weld by position and work on the welded index buffer in place.
+    // Quadrics and topology only see welded vertices; 'corners' keeps the
+    // original vertex of every corner, which is what gets written out.
+    uint32_t * remap = (uint32_t *)::malloc(vertex_count * sizeof(uint32_t));
+    build_position_remap(remap, positions, vertex_count, vertex_stride);
+    for (size_t i = 0; i < index_count; ++i)
+        dst_indices[i] = remap[indices[i]];
+    uint32_t * corners = (uint32_t *)::malloc(index_count * sizeof(uint32_t));
+    memcpy(corners, indices, index_count * sizeof(uint32_t));
+    uint32_t * wedge_to = (uint32_t *)::malloc(vertex_count * sizeof(uint32_t));
+
+    Quadric * quadrics = (Quadric *)::calloc(vertex_count, sizeof(Quadric));
+    uint32_t * collapse_to = (uint32_t *)::malloc(vertex_count * sizeof(uint32_t));
+    bool * locked = (bool *)::malloc(vertex_count * sizeof(bool));
+    bool * border = (bool *)::malloc(vertex_count * sizeof(bool));
+    uint32_t * adjacency_offsets = (uint32_t *)::malloc((vertex_count + 1) * sizeof(uint32_t));
+    uint32_t * adjacency = (uint32_t *)::malloc(index_count * sizeof(uint32_t));
+    Collapse * candidates = (Collapse *)::malloc(index_count * sizeof(Collapse));
+
+    // Face and border quadrics.
+    EdgeTable edges;
+    build_edge_table(&edges, dst_indices, index_count);
+    memset(border, 0, vertex_count * sizeof(bool));
+    for (size_t i = 0; i < index_count; i += 3) {
+        Vec3 p0 = load_pos(positions, vertex_stride, dst_indices[i + 0]);
+        Vec3 p1 = load_pos(positions, vertex_stride, dst_indices[i + 1]);
+        Vec3 p2 = load_pos(positions, vertex_stride, dst_indices[i + 2]);
+        Vec3 n = cross(sub(p1, p0), sub(p2, p0));
+        double len = sqrt(dot(n, n));
+        if (len == 0.0)
+            continue;
+        n.x /= len; n.y /= len; n.z /= len;
+        double area = 0.5 * len;
+
+        Quadric q = {};
+        quadric_add_plane(&q, n, -dot(n, p0), area);
+        q.w = area;
+        for (int c = 0; c < 3; ++c)
+            quadric_add(&quadrics[dst_indices[i + c]], &q);
+
+        for (int e = 0; e < 3; ++e) {
+            uint32_t a = dst_indices[i + e];
+            uint32_t b = dst_indices[i + (e + 1) % 3];
+            if (edge_count(&edges, a, b) != 1)
+                continue;
+            border[a] = border[b] = true;
+
+            Vec3 pa = load_pos(positions, vertex_stride, a);
+            Vec3 pb = load_pos(positions, vertex_stride, b);
+            Vec3 edge = sub(pb, pa);
+            Vec3 bn = cross(edge, n);
+            double blen = sqrt(dot(bn, bn));
+            if (blen == 0.0)
+                continue;
+            bn.x /= blen; bn.y /= blen; bn.z /= blen;
+
+            Quadric bq = {};
+            quadric_add_plane(&bq, bn, -dot(bn, pa), dot(edge, edge) * border_weight);
+            quadric_add(&quadrics[a], &bq);
+            quadric_add(&quadrics[b], &bq);
+        }
+    }
+
+    double max_cost = (double)target_error * (double)target_error;
+    double result_cost = 0.0;
+    size_t result_count = index_count;
+
+    for (int pass = 0; pass < max_passes && result_count > target_index_count; ++pass) {
+        // Vertex -> triangle adjacency for the current index buffer.
+        memset(adjacency_offsets, 0, (vertex_count + 1) * sizeof(uint32_t));
+        for (size_t i = 0; i < result_count; ++i)
+            adjacency_offsets[dst_indices[i] + 1]++;
+        for (size_t v = 0; v < vertex_count; ++v)
+            adjacency_offsets[v + 1] += adjacency_offsets[v];
+        for (size_t i = 0; i < result_count; ++i) {
+            uint32_t v = dst_indices[i];
+            adjacency[adjacency_offsets[v]++] = (uint32_t)(i / 3);
+        }
+        for (size_t v = vertex_count; v > 0; --v)
+            adjacency_offsets[v] = adjacency_offsets[v - 1];
+        adjacency_offsets[0] = 0;
+
+        free_edge_table(&edges);
+        build_edge_table(&edges, dst_indices, result_count);
+
+        // Rank every edge by the cheaper of its two collapse directions.
+        size_t ncandidates = 0;
+        for (size_t i = 0; i < result_count; i += 3) {
+            for (int e = 0; e < 3; ++e) {
+                uint32_t a = dst_indices[i + e];
+                uint32_t b = dst_indices[i + (e + 1) % 3];
+                bool is_border_edge = edge_count(&edges, a, b) == 1;
+                if (a > b && !is_border_edge)
+                    continue;   // interior edges are seen from both triangles; rank them once
+
+                Quadric q = quadrics[a];
+                quadric_add(&q, &quadrics[b]);
+
+                // Border vertices may only slide along the border.
+                double cost_ab = (border[a] && !is_border_edge) ? DBL_MAX : quadric_error(&q, load_pos(positions, vertex_stride, b));
+                double cost_ba = (border[b] && !is_border_edge) ? DBL_MAX : quadric_error(&q, load_pos(positions, vertex_stride, a));
+                if (cost_ab == DBL_MAX && cost_ba == DBL_MAX)
+                    continue;
+
+                Collapse c;
+                c.from = cost_ab <= cost_ba ? a : b;
+                c.to   = cost_ab <= cost_ba ? b : a;
+                c.cost = cost_ab <= cost_ba ? cost_ab : cost_ba;
+                if (c.cost <= max_cost)
+                    candidates[ncandidates++] = c;
+            }
+        }
+        if (0 == ncandidates)
+            break;
+        std::sort(candidates, candidates + ncandidates,
+            [] (Collapse const & l, Collapse const & r) { return l.cost < r.cost; });
+
+        for (size_t v = 0; v < vertex_count; ++v)
+            collapse_to[v] = (uint32_t)v;
+        memset(locked, 0, vertex_count * sizeof(bool));
+
+        // Apply the cheapest independent collapses until the target is
+        // reached.  Every vertex touched by a collapse is locked for the
+        // rest of the pass so adjacency stays valid.
+        size_t triangles = result_count / 3;
+        size_t target_triangles = target_index_count / 3;
+        size_t ncollapsed = 0;
+        for (size_t i = 0; i < ncandidates && triangles > target_triangles; ++i) {
+            Collapse const * c = &candidates[i];
+            if (locked[c->from] || locked[c->to])
+                continue;
+            if (collapse_flips(c->from, c->to, dst_indices, adjacency, adjacency_offsets, positions, vertex_stride))
+                continue;
+            if (false == collapse_wedges(c->from, c->to, dst_indices, corners, adjacency, adjacency_offsets, wedge_to))
+                continue;
+
+            uint32_t removed = 0;
+            for (uint32_t k = adjacency_offsets[c->from]; k < adjacency_offsets[c->from + 1]; ++k) {
+                uint32_t const * tri = &dst_indices[adjacency[k] * 3];
+                if (tri[0] == c->to || tri[1] == c->to || tri[2] == c->to)
+                    ++removed;
+                locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = true;
+            }
+
+            collapse_to[c->from] = c->to;
+            quadric_add(&quadrics[c->to], &quadrics[c->from]);
+            triangles -= removed;
+            if (c->cost > result_cost)
+                result_cost = c->cost;
+            ++ncollapsed;
+        }
+        if (0 == ncollapsed)
+            break;
+
+        // Rewrite the index buffer and drop degenerate triangles.
+        size_t write = 0;
+        for (size_t i = 0; i < result_count; i += 3) {
+            uint32_t a = collapse_to[dst_indices[i + 0]];
+            uint32_t b = collapse_to[dst_indices[i + 1]];
+            uint32_t c = collapse_to[dst_indices[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = dst_indices[i + k];
+                corners[write + k] = collapse_to[v] == v ? corners[i + k] : wedge_to[corners[i + k]];
+            }
+            dst_indices[write + 0] = a;
+            dst_indices[write + 1] = b;
+            dst_indices[write + 2] = c;
+            write += 3;
+        }
+        result_count = write;
+    }
+
+    memcpy(dst_indices, corners, result_count * sizeof(uint32_t));
+
+    free_edge_table(&edges);
+    ::free(wedge_to);
+    ::free(corners);
+    ::free(candidates);
+    ::free(adjacency);
+    ::free(adjacency_offsets);
+    ::free(border);
+    ::free(locked);
+    ::free(collapse_to);
+    ::free(quadrics);
+    ::free(remap);
+
+    if (out_error)
+        *out_error = (float)sqrt(result_cost);
+    return result_count;
+}
+static void
+fill_lod_range (MeshCacheLod * lod, uint32_t const * indices, size_t start, size_t count, float error) {
+    uint32_t mn = UINT32_MAX, mx = 0;
+    for (size_t i = start; i < start + count; ++i) {
+        if (indices[i] < mn) mn = indices[i];
+        if (indices[i] > mx) mx = indices[i];
+    }
+    lod->index_start  = (uint32_t)start;
+    lod->index_count  = (uint32_t)count;
+    lod->min_vertex   = count ? mn : 0;
+    lod->num_vertices = count ? mx - mn + 1 : 0;
+    lod->error        = error;
+}
+uint32_t
+MeshSimplify_BuildLodChain (
+    uint32_t const * indices, size_t index_count,
+    float const * positions, size_t vertex_count, size_t vertex_stride,
+    uint32_t max_lods, float reduction,
+    uint32_t ** out_indices, size_t * out_index_count,
+    MeshCacheLod * out_lods
+) {
+    if (max_lods > MESH_CACHE_MAX_LODS)
+        max_lods = MESH_CACHE_MAX_LODS;
+
+    // Every level is at most as large as level 0.
+    uint32_t * all = (uint32_t *)::malloc(index_count * max_lods * sizeof(uint32_t));
+    uint32_t * scratch = (uint32_t *)::malloc(index_count * sizeof(uint32_t));
+
+    memcpy(all, indices, index_count * sizeof(uint32_t));
+    fill_lod_range(&out_lods[0], all, 0, index_count, 0.0f);
+    size_t total = index_count;
+    uint32_t nlods = 1;
+
+    size_t prev_count = index_count;
+    while (nlods < max_lods) {
+        size_t target = (size_t)((float)prev_count * reduction) / 3 * 3;
+        if (target < 3)
+            break;
+
+        // Each level is simplified from the full mesh so its error is
+        // measured against the original surface, not the previous level.
+        float error = 0.0f;
+        size_t count = MeshSimplify_Simplify(
+            scratch, indices, index_count,
+            positions, vertex_count, vertex_stride,
+            target, FLT_MAX, &error
+        );
+
+        // Stop once the simplifier can't make meaningful progress.
+        if (count == 0 || count > prev_count * 9 / 10)
+            break;
+
+        memcpy(all + total, scratch, count * sizeof(uint32_t));
+        fill_lod_range(&out_lods[nlods], all, total, count, error);
+        total += count;
+        prev_count = count;
+        ++nlods;
+    }
+
+    ::free(scratch);
+    *out_indices = all;
+    *out_index_count = total;
+    return nlods;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// Quadric-error edge-collapse mesh simplification.
+//
+// Vertices are never moved or created: every collapse merges a vertex
+// into one of its neighbours, so all levels of detail index the original
+// vertex buffer and only need their own range of the index buffer.
+// Vertices sharing a position (normal seams, cylinder caps) are welded
+// before simplifying so the surface doesn't tear along those seams; every
+// corner still indexes a vertex from its own side of the seam, so the
+// levels keep the attributes of the triangles they replace.
+
+#include "MeshCache.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Simplifies a triangle list towards target_index_count without
+// exceeding target_error (object-space distance).  Writes the result to
+// dst_indices, which must hold index_count entries, and returns the new
+// index count.  out_error receives the error of the result.
+size_t
+MeshSimplify_Simplify (
+    uint32_t * dst_indices,
+    uint32_t const * indices, size_t index_count,
+    float const * positions, size_t vertex_count, size_t vertex_stride,
+    size_t target_index_count, float target_error,
+    float * out_error
+);
+
+// Builds a chain of up to max_lods levels, each with roughly
+// 'reduction' times the triangles of the previous one.  Level 0 is the
+// input itself.  The levels are concatenated into one index buffer
+// (allocated with malloc, released by the caller) and described by
+// out_lods.  Returns the number of levels written.
+uint32_t
+MeshSimplify_BuildLodChain (
+    uint32_t const * indices, size_t index_count,
+    float const * positions, size_t vertex_count, size_t vertex_stride,
+    uint32_t max_lods, float reduction,
+    uint32_t ** out_indices, size_t * out_index_count,
+    MeshCacheLod * out_lods
+);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <d3d9.h>
+#include <stdint.h>
+
+// Registry of everything that must be released before
+// IDirect3DDevice9::Reset and rebuilt after it: D3DPOOL_DEFAULT buffers
+// and textures, D3DX objects holding such resources (effects, sprites,
+// fonts) and the render state set up after a reset.
+//
+// DeviceResources_Reset does the whole sequence in one call:
+//   lost     - every entry, newest first, drops its device resources
+//   Reset    - the device itself
+//   restore  - every entry, oldest first, recreates and refills
+// Buffers created through the registry keep their contents on the CPU,
+// so refilling one is a single copy.
+// If Reset fails everything stays released and the call can simply be
+// repeated, so lost callbacks must tolerate running twice.
+
+typedef void (*DeviceLostFn) (void * user);
+typedef void (*DeviceRestoreFn) (IDirect3DDevice9 * device, void * user);
+
+struct DeviceResourceDesc {
+    char const *        name;
+    DeviceLostFn        lost;       // both optional
+    DeviceRestoreFn     restore;
+    void *              user;
+};
+
+struct DeviceResources;
+
+DeviceResources *
+DeviceResources_Create (IDirect3DDevice9 * device);
+// Releases the buffers created through the registry.  Other entries are
+// left to their owners.
+void
+DeviceResources_Destroy (DeviceResources * resources);
+// Returns an id for DeviceResources_Remove.
+uint32_t
+DeviceResources_Add (DeviceResources * resources, DeviceResourceDesc const * desc);
+void
+DeviceResources_Remove (DeviceResources * resources, uint32_t id);
+// D3DPOOL_DEFAULT buffers owned by the registry.  With 'data' the
+// contents are kept as a CPU-side shadow and uploaded again after every
+// reset; dynamic buffers refilled each frame pass null.  *buffer is
+// updated in place whenever the buffer is recreated.
+uint32_t
+DeviceResources_CreateVertexBuffer (
+    DeviceResources * resources, UINT length, DWORD usage, DWORD fvf,
+    void const * data, IDirect3DVertexBuffer9 ** buffer
+);
+uint32_t
+DeviceResources_CreateIndexBuffer (
+    DeviceResources * resources, UINT length, DWORD usage, D3DFORMAT format,
+    void const * data, IDirect3DIndexBuffer9 ** buffer
+);
+HRESULT
+DeviceResources_Reset (DeviceResources * resources, D3DPRESENT_PARAMETERS * params);
+// Duration of the last successful DeviceResources_Reset.
+float
+DeviceResources_LastResetMs (DeviceResources const * resources);
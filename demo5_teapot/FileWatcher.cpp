@@ -0,0 +1,223 @@
+#include "FileWatcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// How long a file has to stay untouched before its change is reported.
+#define FILE_WATCHER_SETTLE_MS  100
+
+struct WatchedFile {
+    char                    name[260];
+    // Bumped by the watcher thread on every change.  Only the thread
+    // calling FileWatcher_TakeChange touches taken, the last count it
+    // reported, so a change landing while one is being taken stays
+    // pending instead of being cleared with it.
+    std::atomic<uint32_t>   changes;
+    uint32_t                taken;
+    std::atomic<int64_t>    last_change_ms;
+};
+
+struct FileWatcher {
+    WatchedFile             files[FILE_WATCHER_MAX_FILES];
+    // Names are written before the count is bumped, so the watcher
+    // thread only ever sees complete entries.
+    std::atomic<int>        count;
+    std::thread             thread;
+
+#ifdef _WIN32
+    HANDLE                  dir;
+    HANDLE                  quit_event;
+#else
+    int                     fd;
+    int                     quit_pipe[2];
+#endif
+};
+
+static int64_t
+now_ms () {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+// Called on the watcher thread with every name the OS reports; a null
+// name means events were dropped and everything may have changed.
+static void
+mark_changed (FileWatcher * watcher, char const * name) {
+    int count = watcher->count.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        WatchedFile * file = &watcher->files[i];
+#ifdef _WIN32
+        bool match = 0 == name || 0 == _stricmp(name, file->name);
+#else
+        bool match = 0 == name || 0 == strcmp(name, file->name);
+#endif
+        if (match) {
+            file->last_change_ms.store(now_ms());
+            file->changes.fetch_add(1, std::memory_order_release);
+        }
+    }
+}
+
+#ifdef _WIN32
+static void
+watch_thread (FileWatcher * watcher) {
+    // DWORD-aligned, as ReadDirectoryChangesW requires.
+    static DWORD const buffer_size = 16 * 1024;
+    DWORD * buffer = new DWORD[buffer_size / sizeof(DWORD)];
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.hEvent = CreateEventA(0, TRUE, FALSE, 0);
+
+    for (;;) {
+        ResetEvent(overlapped.hEvent);
+        if (!ReadDirectoryChangesW(
+            watcher->dir, buffer, buffer_size, FALSE,
+            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+            0, &overlapped, 0
+        ))
+            break;
+
+        DWORD bytes = 0;
+        HANDLE handles[2] = {overlapped.hEvent, watcher->quit_event};
+        if (WAIT_OBJECT_0 != WaitForMultipleObjects(2, handles, FALSE, INFINITE)) {
+            CancelIo(watcher->dir);
+            GetOverlappedResult(watcher->dir, &overlapped, &bytes, TRUE);
+            break;
+        }
+        if (!GetOverlappedResult(watcher->dir, &overlapped, &bytes, FALSE))
+            break;
+
+        // Zero bytes means the buffer overflowed and the events are lost.
+        if (0 == bytes) {
+            mark_changed(watcher, 0);
+            continue;
+        }
+        BYTE const * at = (BYTE const *)buffer;
+        for (;;) {
+            FILE_NOTIFY_INFORMATION const * info = (FILE_NOTIFY_INFORMATION const *)at;
+            char name[260];
+            int len = WideCharToMultiByte(
+                CP_UTF8, 0, info->FileName, (int)(info->FileNameLength / sizeof(WCHAR)),
+                name, sizeof(name) - 1, 0, 0
+            );
+            name[len] = 0;
+            mark_changed(watcher, name);
+            if (0 == info->NextEntryOffset)
+                break;
+            at += info->NextEntryOffset;
+        }
+    }
+    CloseHandle(overlapped.hEvent);
+    delete [] buffer;
+}
+#else
+static void
+watch_thread (FileWatcher * watcher) {
+    alignas(inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        pollfd fds[2] = {{watcher->fd, POLLIN, 0}, {watcher->quit_pipe[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0)
+            continue;
+        if (fds[1].revents)
+            break;
+
+        ssize_t bytes;
+        while ((bytes = read(watcher->fd, buffer, sizeof(buffer))) > 0) {
+            for (char const * at = buffer; at < buffer + bytes; ) {
+                inotify_event const * e = (inotify_event const *)at;
+                if (e->mask & IN_Q_OVERFLOW)
+                    mark_changed(watcher, 0);
+                else if (e->len)
+                    mark_changed(watcher, e->name);
+                at += sizeof(inotify_event) + e->len;
+            }
+        }
+    }
+}
+#endif
+
+FileWatcher *
+FileWatcher_Create (char const * directory) {
+    FileWatcher * watcher = new FileWatcher;
+    watcher->count.store(0);
+#ifdef _WIN32
+    watcher->dir = CreateFileA(
+        directory, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, 0
+    );
+    if (INVALID_HANDLE_VALUE == watcher->dir) {
+        delete watcher;
+        return 0;
+    }
+    watcher->quit_event = CreateEventA(0, TRUE, FALSE, 0);
+#else
+    watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watcher->fd < 0 ||
+        inotify_add_watch(watcher->fd, directory, IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_MOVED_TO) < 0 ||
+        pipe(watcher->quit_pipe) < 0) {
+        if (watcher->fd >= 0)
+            close(watcher->fd);
+        delete watcher;
+        return 0;
+    }
+#endif
+    watcher->thread = std::thread(watch_thread, watcher);
+    return watcher;
+}
+void
+FileWatcher_Destroy (FileWatcher * watcher) {
+    if (0 == watcher)
+        return;
+#ifdef _WIN32
+    SetEvent(watcher->quit_event);
+    watcher->thread.join();
+    CloseHandle(watcher->quit_event);
+    CloseHandle(watcher->dir);
+#else
+    char quit = 0;
+    if (write(watcher->quit_pipe[1], &quit, 1) < 0) {}
+    watcher->thread.join();
+    close(watcher->quit_pipe[0]);
+    close(watcher->quit_pipe[1]);
+    close(watcher->fd);
+#endif
+    delete watcher;
+}
+int
+FileWatcher_Add (FileWatcher * watcher, char const * name) {
+    int id = watcher->count.load(std::memory_order_relaxed);
+    if (id == FILE_WATCHER_MAX_FILES)
+        return -1;
+    WatchedFile * file = &watcher->files[id];
+    strncpy(file->name, name, sizeof(file->name) - 1);
+    file->name[sizeof(file->name) - 1] = 0;
+    file->changes.store(0);
+    file->taken = 0;
+    file->last_change_ms.store(0);
+    watcher->count.store(id + 1, std::memory_order_release);
+    return id;
+}
+bool
+FileWatcher_TakeChange (FileWatcher * watcher, int id) {
+    if (id < 0 || id >= watcher->count.load(std::memory_order_relaxed))
+        return false;
+    WatchedFile * file = &watcher->files[id];
+    uint32_t changes = file->changes.load(std::memory_order_acquire);
+    if (changes == file->taken)
+        return false;
+    if (now_ms() - file->last_change_ms.load() < FILE_WATCHER_SETTLE_MS)
+        return false;
+    file->taken = changes;
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Watches files in one directory for changes, so assets can be reloaded
+// while the demo runs.
+//
+// A background thread waits on the OS (ReadDirectoryChangesW on Windows,
+// inotify elsewhere) and marks watched files dirty.  The device thread
+// polls with FileWatcher_TakeChange.  Editors tend to save in several
+// writes, so a change is only reported once the file has been quiet for
+// a short while.
+
+#include <stdint.h>
+
+#define FILE_WATCHER_MAX_FILES  16
+
+struct FileWatcher;
+
+// Returns 0 if the directory can't be watched.
+FileWatcher *
+FileWatcher_Create (char const * directory);
+void
+FileWatcher_Destroy (FileWatcher * watcher);
+// name is a file directly inside the directory.  Returns an id for
+// FileWatcher_TakeChange, or -1 when full.
+int
+FileWatcher_Add (FileWatcher * watcher, char const * name);
+// True once per settled burst of changes to the file; clears the change.
+bool
+FileWatcher_TakeChange (FileWatcher * watcher, int id);
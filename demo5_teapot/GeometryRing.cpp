@@ -0,0 +1,155 @@
+#include "GeometryRing.h"
+
+#define GEOMETRY_RING_USAGE     (D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY)
+
+struct RingBuffer {
+    IDirect3DVertexBuffer9 *    vb;         // exactly one of vb/ib is used
+    IDirect3DIndexBuffer9 *     ib;
+    uint32_t                    id;         // registry entry
+    UINT                        size;
+    UINT                        offset;     // next free byte
+
+    UINT                        frame_bytes;
+    UINT                        last_frame_bytes;
+    UINT                        high_water;
+};
+
+struct GeometryRing {
+    DeviceResources *   resources;
+    RingBuffer          vertices;
+    RingBuffer          indices;
+
+    UINT                locks;
+    UINT                discards;
+    UINT                last_locks;
+    UINT                last_discards;
+    UINT                grows;
+};
+
+static void
+create_buffer (GeometryRing * ring, RingBuffer * rb, UINT size) {
+    rb->size = size;
+    rb->offset = 0;
+    if (rb == &ring->vertices)
+        rb->id = DeviceResources_CreateVertexBuffer(ring->resources, size, GEOMETRY_RING_USAGE, 0, 0, &rb->vb);
+    else
+        rb->id = DeviceResources_CreateIndexBuffer(ring->resources, size, GEOMETRY_RING_USAGE, D3DFMT_INDEX16, 0, &rb->ib);
+}
+static void
+grow_buffer (GeometryRing * ring, RingBuffer * rb, UINT bytes) {
+    UINT size = rb->size;
+    while (size < bytes)
+        size *= 2;
+    // Draws already issued from the old buffer keep it alive in the
+    // runtime until the GPU is done with them.
+    DeviceResources_Remove(ring->resources, rb->id);
+    create_buffer(ring, rb, size);
+    ++ring->grows;
+}
+static bool
+lock_buffer (GeometryRing * ring, RingBuffer * rb, UINT count, UINT stride, GeometryRingSpan * span) {
+    UINT bytes = count * stride;
+    if (0 == bytes)
+        return false;
+    if (bytes > rb->size)
+        grow_buffer(ring, rb, bytes);
+    if (0 == rb->vb && 0 == rb->ib)
+        return false;
+
+    // Offsets are kept a multiple of the stride so they can be given to
+    // the draw call as a first vertex or index.
+    UINT offset = (rb->offset + stride - 1) / stride * stride;
+    DWORD flags = D3DLOCK_NOOVERWRITE;
+    if (offset + bytes > rb->size) {
+        offset = 0;
+        flags = D3DLOCK_DISCARD;
+        ++ring->discards;
+    }
+
+    HRESULT hr = rb->vb
+        ? rb->vb->Lock(offset, bytes, &span->data, flags)
+        : rb->ib->Lock(offset, bytes, &span->data, flags);
+    if (FAILED(hr))
+        return false;
+
+    span->first = offset / stride;
+    rb->frame_bytes += bytes;
+    rb->offset = offset + bytes;
+    ++ring->locks;
+    return true;
+}
+static void
+end_frame (GeometryRing * ring, RingBuffer * rb) {
+    rb->last_frame_bytes = rb->frame_bytes;
+    if (rb->frame_bytes > rb->high_water)
+        rb->high_water = rb->frame_bytes;
+    // A frame that wrapped around on its own data would discard again
+    // every frame; give the next one room for all of it.
+    if (rb->frame_bytes > rb->size)
+        grow_buffer(ring, rb, rb->frame_bytes);
+    rb->frame_bytes = 0;
+}
+
+GeometryRing *
+GeometryRing_Create (DeviceResources * resources, UINT vertex_bytes, UINT index_count) {
+    GeometryRing * ring = (GeometryRing *)::calloc(1, sizeof(GeometryRing));
+    ring->resources = resources;
+    create_buffer(ring, &ring->vertices, vertex_bytes);
+    create_buffer(ring, &ring->indices, index_count * sizeof(WORD));
+    return ring;
+}
+void
+GeometryRing_Destroy (GeometryRing * ring) {
+    if (0 == ring)
+        return;
+    DeviceResources_Remove(ring->resources, ring->vertices.id);
+    DeviceResources_Remove(ring->resources, ring->indices.id);
+    ::free(ring);
+}
+void
+GeometryRing_BeginFrame (GeometryRing * ring) {
+    end_frame(ring, &ring->vertices);
+    end_frame(ring, &ring->indices);
+    ring->last_locks = ring->locks;
+    ring->last_discards = ring->discards;
+    ring->locks = 0;
+    ring->discards = 0;
+}
+bool
+GeometryRing_LockVertices (GeometryRing * ring, UINT count, UINT stride, GeometryRingSpan * span) {
+    return lock_buffer(ring, &ring->vertices, count, stride, span);
+}
+void
+GeometryRing_UnlockVertices (GeometryRing * ring) {
+    ring->vertices.vb->Unlock();
+}
+bool
+GeometryRing_LockIndices (GeometryRing * ring, UINT count, GeometryRingSpan * span) {
+    return lock_buffer(ring, &ring->indices, count, sizeof(WORD), span);
+}
+void
+GeometryRing_UnlockIndices (GeometryRing * ring) {
+    ring->indices.ib->Unlock();
+}
+IDirect3DVertexBuffer9 *
+GeometryRing_VertexBuffer (GeometryRing const * ring) {
+    return ring->vertices.vb;
+}
+IDirect3DIndexBuffer9 *
+GeometryRing_IndexBuffer (GeometryRing const * ring) {
+    return ring->indices.ib;
+}
+GeometryRingStats
+GeometryRing_Stats (GeometryRing const * ring) {
+    GeometryRingStats stats;
+    stats.vertex_size           = ring->vertices.size;
+    stats.index_size            = ring->indices.size;
+    stats.vertex_frame_bytes    = ring->vertices.last_frame_bytes;
+    stats.index_frame_bytes     = ring->indices.last_frame_bytes;
+    stats.vertex_high_water     = ring->vertices.high_water;
+    stats.index_high_water      = ring->indices.high_water;
+    stats.locks                 = ring->last_locks;
+    stats.discards              = ring->last_discards;
+    stats.grows                 = ring->grows;
+    return stats;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Common.h"
+#include "MeshCache.h"
+
+// Static mesh living in managed vertex/index buffers, created from a
+// memory-mapped MeshCache. All LODs share the same buffers.
+struct GpuMesh {
+    IDirect3DVertexBuffer9 *        vb;
+    IDirect3DIndexBuffer9 *         ib;
+    IDirect3DVertexDeclaration9 *   decl;
+    UINT                            stride;
+
+    UINT                            lod_count;
+    MeshCacheLod                    lods[MESH_CACHE_MAX_LODS];
+
+    D3DXVECTOR3                     center;
+    float                           radius;
+};
+
+bool
+GpuMesh_CreateFromCache (IDirect3DDevice9 * device, MeshCache const * cache, GpuMesh * mesh);
+bool
+GpuMesh_WriteCache (ID3DXMesh * d3dx_mesh, char const * path, uint64_t key, UINT max_lods);
+void
+GpuMesh_Bind (IDirect3DDevice9 * device, GpuMesh const * mesh);
+UINT
+GpuMesh_SelectLod (GpuMesh const * mesh, D3DXMATRIX const * world_view, float proj_scale, float max_pixel_error);
+void
+GpuMesh_Draw (IDirect3DDevice9 * device, GpuMesh const * mesh, UINT lod);
+void
+GpuMesh_Release (GpuMesh * mesh);
@@ -0,0 +1,106 @@
+#pragma once
+
+// Versioned binary mesh container.
+//
+// A mesh is written once (MeshCache_Write) and memory-mapped on later
+// runs (MeshCache_Open). Everything the renderer needs is laid out so
+// that it can be consumed straight from the mapping:
+//
+//   [MeshCacheHeader][pad][vertex blob][pad][index blob]
+//
+// The vertex declaration uses the exact layout of D3DVERTEXELEMENT9 and
+// is terminated by an end element, so it can be passed to
+// CreateVertexDeclaration as-is. Blobs start on MESH_CACHE_BLOB_ALIGNMENT
+// boundaries and are copied into the locked buffers with one memcpy each.
+
+#include "MappedFile.h"
+
+#include <stdint.h>
+
+#define MESH_CACHE_MAGIC                0x4853454Du     // 'MESH'
+#define MESH_CACHE_VERSION              1u
+#define MESH_CACHE_BLOB_ALIGNMENT       64u
+#define MESH_CACHE_MAX_DECL_ELEMENTS    16
+#define MESH_CACHE_MAX_LODS             8
+
+// Same memory layout as D3DVERTEXELEMENT9.
+struct MeshCacheVertexElement {
+    uint16_t    stream;
+    uint16_t    offset;
+    uint8_t     type;
+    uint8_t     method;
+    uint8_t     usage;
+    uint8_t     usage_index;
+};
+
+// One level of detail: a range of the shared index blob plus the vertex
+// range it references (the DrawIndexedPrimitive arguments).
+struct MeshCacheLod {
+    uint32_t    index_start;
+    uint32_t    index_count;
+    uint32_t    min_vertex;
+    uint32_t    num_vertices;
+    float       error;          // object-space geometric error of this level
+};
+
+struct MeshCacheHeader {
+    uint32_t                magic;
+    uint32_t                version;
+    uint32_t                header_size;
+    uint32_t                reserved;
+
+    uint64_t                key;            // caller-defined hash of the generation parameters
+    uint64_t                file_size;
+
+    uint32_t                vertex_stride;
+    uint32_t                vertex_count;
+    uint32_t                index_size;     // 2 or 4 bytes
+    uint32_t                index_count;
+
+    uint64_t                vertex_offset;
+    uint64_t                index_offset;
+
+    float                   bounds_min[3];
+    float                   bounds_max[3];
+    float                   bounds_center[3];
+    float                   bounds_radius;
+
+    uint32_t                decl_count;     // including the end element
+    uint32_t                lod_count;
+    MeshCacheVertexElement  decl[MESH_CACHE_MAX_DECL_ELEMENTS];
+    MeshCacheLod            lods[MESH_CACHE_MAX_LODS];
+};
+
+// Input for MeshCache_Write. If lod_count is 0 a single level covering
+// the whole index buffer is written.
+struct MeshCacheDesc {
+    uint64_t                        key;
+
+    MeshCacheVertexElement const *  decl;           // terminated by an end element (stream 0xFF)
+    void const *                    vertices;
+    uint32_t                        vertex_stride;
+    uint32_t                        vertex_count;
+
+    void const *                    indices;
+    uint32_t                        index_size;
+    uint32_t                        index_count;
+
+    MeshCacheLod const *            lods;
+    uint32_t                        lod_count;
+};
+
+struct MeshCache {
+    MappedFile                  file;
+    MeshCacheHeader const *     header;
+    void const *                vertices;
+    void const *                indices;
+};
+
+bool
+MeshCache_Write (char const * path, MeshCacheDesc const * desc);
+bool
+MeshCache_Open (MeshCache * cache, char const * path, uint64_t expected_key);
+void
+MeshCache_Close (MeshCache * cache);
+uint64_t
+MeshCache_HashKey (void const * data, size_t size, uint64_t seed);
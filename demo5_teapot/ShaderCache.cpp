@@ -0,0 +1,221 @@
+#include "ShaderCache.h"
+#include "MappedFile.h"
+
+#include <atomic>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// Deeper nesting than this is taken to be an include cycle.
+#define SHADER_CACHE_MAX_INCLUDE_DEPTH  16
+
+struct ShaderCache {
+    char                    directory[260];
+    ShaderCompiler          compiler;
+    std::atomic<uint32_t>   temp_counter;   // unique temporary file names
+};
+
+static uint64_t
+hash_bytes (uint64_t h, void const * data, size_t size) {
+    // FNV-1a, 64-bit.
+    uint8_t const * p = (uint8_t const *)data;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+static uint64_t
+hash_string (uint64_t h, char const * s) {
+    // The terminator keeps "ab","c" and "a","bc" apart.
+    return hash_bytes(h, s, strlen(s) + 1);
+}
+// Length of the directory part of path, including the trailing slash.
+static size_t
+directory_length (char const * path) {
+    size_t len = strlen(path);
+    while (len > 0 && path[len - 1] != '/' && path[len - 1] != '\\')
+        --len;
+    return len;
+}
+// Hashes the name and contents of every file included by 'source',
+// recursively.  A missing include hashes its name only; compiling will
+// report it.
+static uint64_t
+hash_includes (uint64_t h, char const * path, char const * source, size_t size, int depth) {
+    if (depth >= SHADER_CACHE_MAX_INCLUDE_DEPTH)
+        return h;
+    char const * end = source + size;
+    for (char const * line = source; line < end; ) {
+        char const * p = line;
+        char const * eol = (char const *)memchr(line, '\n', (size_t)(end - line));
+        if (0 == eol)
+            eol = end;
+        line = eol + 1;
+
+        // #include "name" or #include <name>, spaces allowed around '#'.
+        while (p < eol && (*p == ' ' || *p == '\t'))
+            ++p;
+        if (p == eol || *p++ != '#')
+            continue;
+        while (p < eol && (*p == ' ' || *p == '\t'))
+            ++p;
+        if ((size_t)(eol - p) < 7 || strncmp(p, "include", 7))
+            continue;
+        p += 7;
+        while (p < eol && (*p == ' ' || *p == '\t'))
+            ++p;
+        if (p == eol || (*p != '"' && *p != '<'))
+            continue;
+        char close = *p == '"' ? '"' : '>';
+        char const * name = ++p;
+        while (p < eol && *p != close)
+            ++p;
+        if (p == eol)
+            continue;
+
+        char include_path[512];
+        int dir_len = (int)directory_length(path);
+        snprintf(include_path, sizeof(include_path), "%.*s%.*s", dir_len, path, (int)(p - name), name);
+        h = hash_string(h, include_path);
+
+        MappedFile file;
+        if (MappedFile_Open(&file, include_path)) {
+            h = hash_bytes(h, file.data, file.size);
+            h = hash_includes(h, include_path, (char const *)file.data, file.size, depth + 1);
+            MappedFile_Close(&file);
+        }
+    }
+    return h;
+}
+static void
+entry_path (ShaderCache const * cache, uint64_t key, char * out, size_t out_size) {
+    snprintf(out, out_size, "%s/%016llx.bin", cache->directory, (unsigned long long)key);
+}
+static bool
+read_entry (ShaderCache const * cache, uint64_t key, ShaderBlob * code) {
+    char path[512];
+    entry_path(cache, key, path, sizeof(path));
+    MappedFile file;
+    if (false == MappedFile_Open(&file, path))
+        return false;
+
+    ShaderCacheHeader const * header = (ShaderCacheHeader const *)file.data;
+    bool valid =
+        file.size >= sizeof(ShaderCacheHeader) &&
+        header->magic == SHADER_CACHE_MAGIC &&
+        header->version == SHADER_CACHE_VERSION &&
+        header->header_size == sizeof(ShaderCacheHeader) &&
+        header->key == key &&
+        header->code_size == file.size - sizeof(ShaderCacheHeader);
+    // Without the memory for it the entry is as good as missing.
+    if (valid) {
+        code->data = ::malloc((size_t)header->code_size);
+        valid = 0 != code->data;
+    }
+    if (valid) {
+        code->size = (size_t)header->code_size;
+        memcpy(code->data, header + 1, code->size);
+    }
+    MappedFile_Close(&file);
+    return valid;
+}
+static bool
+write_entry (ShaderCache * cache, uint64_t key, ShaderBlob const * code) {
+    ShaderCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic        = SHADER_CACHE_MAGIC;
+    header.version      = SHADER_CACHE_VERSION;
+    header.header_size  = sizeof(ShaderCacheHeader);
+    header.key          = key;
+    header.code_size    = code->size;
+
+    // Write to a temporary file first, as MeshCache does, so a crash or a
+    // second thread storing the same key never exposes a partial entry.
+    char path[512], tmp_path[560];
+    entry_path(cache, key, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%u.tmp", path, cache->temp_counter.fetch_add(1));
+    FILE * fp = fopen(tmp_path, "wb");
+    if (0 == fp)
+        return false;
+
+    bool ok =
+        fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        fwrite(code->data, 1, code->size, fp) == code->size;
+    ok = (0 == fclose(fp)) && ok;
+
+    if (ok) {
+        remove(path);
+        ok = (0 == rename(tmp_path, path));
+    }
+    if (!ok)
+        remove(tmp_path);
+    return ok;
+}
+
+ShaderCache *
+ShaderCache_Create (char const * directory, ShaderCompiler const * compiler) {
+#ifdef _WIN32
+    _mkdir(directory);
+#else
+    mkdir(directory, 0755);
+#endif
+    ShaderCache * cache = new ShaderCache;
+    strncpy(cache->directory, directory, sizeof(cache->directory) - 1);
+    cache->directory[sizeof(cache->directory) - 1] = 0;
+    cache->compiler = *compiler;
+    cache->temp_counter.store(0);
+    return cache;
+}
+void
+ShaderCache_Destroy (ShaderCache * cache) {
+    delete cache;
+}
+uint64_t
+ShaderCache_Key (
+    ShaderCache const * cache, char const * path, void const * source, size_t source_size,
+    ShaderMacro const * macros, uint32_t flags
+) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    h = hash_bytes(h, &cache->compiler.version, sizeof(cache->compiler.version));
+    h = hash_bytes(h, &flags, sizeof(flags));
+    for (ShaderMacro const * m = macros; m && m->name; ++m) {
+        h = hash_string(h, m->name);
+        h = hash_string(h, m->definition ? m->definition : "");
+    }
+    h = hash_string(h, path);
+    h = hash_bytes(h, source, source_size);
+    return hash_includes(h, path, (char const *)source, source_size, 0);
+}
+ShaderCacheStatus
+ShaderCache_Get (
+    ShaderCache * cache, char const * path, void const * source, size_t source_size,
+    ShaderMacro const * macros, uint32_t flags,
+    ShaderBlob * code, ShaderBlob * log
+) {
+    memset(code, 0, sizeof(*code));
+    memset(log, 0, sizeof(*log));
+
+    uint64_t key = ShaderCache_Key(cache, path, source, source_size, macros, flags);
+    if (read_entry(cache, key, code))
+        return SHADER_CACHE_HIT;
+
+    if (false == cache->compiler.compile(cache->compiler.user, path, source, source_size, macros, flags, code, log))
+        return SHADER_CACHE_FAILED;
+    // A failed write only costs a recompile next time.
+    write_entry(cache, key, code);
+    return SHADER_CACHE_COMPILED;
+}
+void
+ShaderBlob_Free (ShaderBlob * blob) {
+    ::free(blob->data);
+    blob->data = 0;
+    blob->size = 0;
+}
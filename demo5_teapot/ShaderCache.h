@@ -0,0 +1,87 @@
+#pragma once
+
+// Content-addressed cache of compiled shader and effect bytecode.
+//
+// The key is a hash of the source, every file it #includes (found by
+// scanning the source and followed recursively), the macro definitions,
+// the compile flags and the compiler version.  Compiled code is stored
+// as <directory>/<key>.bin:
+//
+//   [ShaderCacheHeader][code]
+//
+// so a run whose sources haven't changed never invokes the compiler.
+// Editing any input simply produces a new key.  The compiler itself is
+// behind an interface, which keeps this file free of D3DX and lets any
+// compiler, or a stub, drive the cache.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHADER_CACHE_MAGIC      0x52444853u     // 'SHDR'
+#define SHADER_CACHE_VERSION    1u
+
+struct ShaderCacheHeader {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    header_size;
+    uint32_t    reserved;
+
+    uint64_t    key;
+    uint64_t    code_size;
+};
+
+// Same memory layout as D3DXMACRO; arrays end with a null name.
+struct ShaderMacro {
+    char const *    name;
+    char const *    definition;
+};
+
+// malloc'ed bytes.
+struct ShaderBlob {
+    void *          data;
+    size_t          size;
+};
+
+// Compiles the source read from 'path'; includes resolve relative to
+// it.  Fills code on success; on failure may fill log with the errors.
+// Called from worker threads, possibly several at once.
+typedef bool (*ShaderCompileFn) (
+    void * user, char const * path, void const * source, size_t source_size,
+    ShaderMacro const * macros, uint32_t flags,
+    ShaderBlob * code, ShaderBlob * log
+);
+
+struct ShaderCompiler {
+    ShaderCompileFn     compile;
+    void *              user;
+    uint32_t            version;    // part of every key
+};
+
+enum ShaderCacheStatus {
+    SHADER_CACHE_HIT,
+    SHADER_CACHE_COMPILED,
+    SHADER_CACHE_FAILED,
+};
+
+struct ShaderCache;
+
+// Creates the directory if needed.
+ShaderCache *
+ShaderCache_Create (char const * directory, ShaderCompiler const * compiler);
+void
+ShaderCache_Destroy (ShaderCache * cache);
+uint64_t
+ShaderCache_Key (
+    ShaderCache const * cache, char const * path, void const * source, size_t source_size,
+    ShaderMacro const * macros, uint32_t flags
+);
+// Returns the stored code when the key matches, otherwise compiles and
+// stores it.  Safe to call from several threads at once.
+ShaderCacheStatus
+ShaderCache_Get (
+    ShaderCache * cache, char const * path, void const * source, size_t source_size,
+    ShaderMacro const * macros, uint32_t flags,
+    ShaderBlob * code, ShaderBlob * log
+);
+void
+ShaderBlob_Free (ShaderBlob * blob);
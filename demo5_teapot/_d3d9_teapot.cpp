@@ -11,6 +11,14 @@
 #include "Common.h"
 
 #include "DirectInput.h"
+#include "GpuMesh.h"
+#include "ThreadPool.h"
+#include "AssetLoader.h"
+#include "FileWatcher.h"
+#include "ShaderCache.h"
+#include "DeviceResources.h"
+#include "GeometryRing.h"
+#include "FrameScheduler.h"
 #include "Vertex.h"
 
 #include <DearImGui/imgui.h>
@@ -37,7 +45,7 @@ typedef struct {
 
     ID3DXMesh *                 cylinder_mesh;
     ID3DXMesh *                 sphere_mesh;
-    ID3DXMesh *                 teapot_mesh;
+    GpuMesh                     teapot_mesh;
 
     IDirect3DVertexBuffer9 *    vb;
     IDirect3DIndexBuffer9 *     ib;
@@ -45,6 +53,12 @@ typedef struct {
     D3DXHANDLE                  htech;
     D3DXHANDLE                  hwvp;
 
+    // transform.fx is recompiled in the background whenever it changes
+    int                         fx_watch;
+    bool                        fx_compiling;
+    bool                        fx_cached;
+    char                        fx_error[1024];
+
     float                       camera_rotation_y;
     float                       camera_radius;
     float                       camera_height;
@@ -52,30 +66,254 @@ typedef struct {
     D3DXMATRIX                  view;
     D3DXMATRIX                  proj;
 
+    float                       lod_pixel_error;
+
     bool                        paused;
     bool                        initialized;
 } D3D9RenderContext;
 
 D3D9RenderContext * g_render_ctx = nullptr;
 DirectInput * g_dinput = nullptr;
+ThreadPool * g_thread_pool = nullptr;
+AssetLoader * g_asset_loader = nullptr;
+FileWatcher * g_file_watcher = nullptr;
+ShaderCache * g_shader_cache = nullptr;
+DeviceResources * g_device_resources = nullptr;
+GeometryRing * g_geometry_ring = nullptr;
+FrameScheduler * g_frame_scheduler = nullptr;
 VertexPos g_vertex_pos = {};
 
+// A scene with nothing going on is still redrawn this often, which is
+// also when polled state (DirectInput, edited files) gets looked at.
+#define IDLE_REDRAW_MS  500
+
 // Helper functions.
 
+#define TEAPOT_LOD_COUNT 6
+
+static bool
+build_teapot_cache (IDirect3DDevice9 * device, char const * path, uint64_t key) {
+    ID3DXMesh * mesh = 0;
+    if (FAILED(D3DXCreateTeapot(device, &mesh, 0)))
+        return false;
+    bool ret = GpuMesh_WriteCache(mesh, path, key, TEAPOT_LOD_COUNT);
+    mesh->Release();
+    return ret;
+}
+static bool
+create_teapot (D3D9RenderContext * render_ctx) {
+    // D3DXCreateTeapot takes no parameters, so the key only changes when
+    // the tag below or the LOD count is bumped.
+    char const teapot_tag [] = "d3dx_teapot_lod6";
+    uint64_t key = MeshCache_HashKey(teapot_tag, sizeof(teapot_tag), 0);
+    char const * path = "teapot.mesh";
+
+    // Try the memory-mapped cache first, otherwise build it once.
+    MeshCache cache;
+    if (false == MeshCache_Open(&cache, path, key)) {
+        if (false == build_teapot_cache(render_ctx->device, path, key))
+            return false;
+        if (false == MeshCache_Open(&cache, path, key))
+            return false;
+    }
+    bool ret = GpuMesh_CreateFromCache(render_ctx->device, &cache, &render_ctx->teapot_mesh);
+    MeshCache_Close(&cache);
+    return ret;
+}
+// Resolves #include for effects compiled from memory relative to the
+// including file, as compiling straight from the file would. Every open
+// include remembers its path so that nested includes resolve against it;
+// anything else (the effect's own source) resolves against 'path'.
+#define FX_INCLUDE_MAX_OPEN     16
+
+struct FxInclude : public ID3DXInclude {
+    struct OpenFile {
+        void const *    data;
+        char            path[512];
+    };
+
+    char const *    path;
+    OpenFile        files[FX_INCLUDE_MAX_OPEN];
+    uint32_t        file_count;
+
+    STDMETHOD(Open) (D3DXINCLUDE_TYPE type, LPCSTR name, LPCVOID parent, LPCVOID * data, UINT * bytes) {
+        if (file_count == FX_INCLUDE_MAX_OPEN)
+            return E_FAIL;
+        char const * base = path;
+        for (uint32_t i = 0; i < file_count; ++i) {
+            if (files[i].data == parent)
+                base = files[i].path;
+        }
+        size_t dir_len = strlen(base);
+        while (dir_len > 0 && base[dir_len - 1] != '/' && base[dir_len - 1] != '\\')
+            --dir_len;
+        OpenFile * file = &files[file_count];
+        _snprintf_s(file->path, sizeof(file->path), _TRUNCATE, "%.*s%s", (int)dir_len, base, name);
+
+        MappedFile mapped;
+        if (false == MappedFile_Open(&mapped, file->path))
+            return E_FAIL;
+        void * copy = ::malloc(mapped.size);
+        if (copy)
+            memcpy(copy, mapped.data, mapped.size);
+        UINT size = (UINT)mapped.size;
+        MappedFile_Close(&mapped);
+        if (0 == copy)
+            return E_OUTOFMEMORY;
+
+        file->data = copy;
+        ++file_count;
+        *data = copy;
+        *bytes = size;
+        return S_OK;
+    }
+    STDMETHOD(Close) (LPCVOID data) {
+        for (uint32_t i = 0; i < file_count; ++i) {
+            if (files[i].data == data) {
+                files[i] = files[--file_count];
+                break;
+            }
+        }
+        ::free((void *)data);
+        return S_OK;
+    }
+};
 static void
-create_fx (D3D9RenderContext * render_ctx) {
-    // Create the FX from a .fx file.
-    ID3DXBuffer* errors = 0;
-    D3DXCreateEffectFromFileA(
-        render_ctx->device, ("transform.fx"),
-        0, 0, D3DXSHADER_DEBUG, 0, &render_ctx->fx, &errors
+copy_buffer (ID3DXBuffer * buffer, ShaderBlob * blob) {
+    // One extra byte keeps error logs printable as strings.
+    blob->size = buffer->GetBufferSize();
+    blob->data = ::malloc(blob->size + 1);
+    memcpy(blob->data, buffer->GetBufferPointer(), blob->size);
+    ((char *)blob->data)[blob->size] = 0;
+}
+static bool
+compile_fx (
+    void * user, char const * path, void const * source, size_t source_size,
+    ShaderMacro const * macros, uint32_t flags,
+    ShaderBlob * code, ShaderBlob * log
+) {
+    FxInclude include;
+    include.path = path;
+    include.file_count = 0;
+    ID3DXEffectCompiler * compiler = 0;
+    ID3DXBuffer * compiled = 0;
+    ID3DXBuffer * errors = 0;
+    HRESULT hr = D3DXCreateEffectCompiler(
+        (char const *)source, (UINT)source_size,
+        (D3DXMACRO const *)macros, &include, flags, &compiler, &errors
+    );
+    if (SUCCEEDED(hr)) {
+        if (errors)
+            errors->Release();
+        errors = 0;
+        hr = compiler->CompileEffect(flags, &compiled, &errors);
+        compiler->Release();
+    }
+    if (SUCCEEDED(hr))
+        copy_buffer(compiled, code);
+    else if (errors)
+        copy_buffer(errors, log);
+    if (compiled)
+        compiled->Release();
+    if (errors)
+        errors->Release();
+    return SUCCEEDED(hr);
+}
+struct CompiledFx {
+    ShaderBlob          code;
+    ShaderBlob          log;
+    ShaderCacheStatus   status;
+};
+static bool
+decode_fx (Asset * asset) {
+    // Runs on a worker: compiling the effect is the slow part and needs
+    // no device, so only D3DXCreateEffect is left for the device thread.
+    // Unchanged sources come straight out of the shader cache.
+    CompiledFx * compiled = (CompiledFx *)::calloc(1, sizeof(CompiledFx));
+    compiled->status = ShaderCache_Get(
+        g_shader_cache, asset->path, asset->file.data, asset->file.size,
+        0, D3DXSHADER_DEBUG, &compiled->code, &compiled->log
+    );
+    asset->payload = compiled;
+    return SHADER_CACHE_FAILED != compiled->status;
+}
+static void
+release_compiled_fx (CompiledFx * compiled) {
+    if (compiled) {
+        ShaderBlob_Free(&compiled->code);
+        ShaderBlob_Free(&compiled->log);
+        ::free(compiled);
+    }
+}
+static void
+set_fx_error (D3D9RenderContext * render_ctx, char const * log) {
+    strncpy(render_ctx->fx_error, log, sizeof(render_ctx->fx_error) - 1);
+    render_ctx->fx_error[sizeof(render_ctx->fx_error) - 1] = 0;
+    OutputDebugStringA(log);
+}
+static void
+complete_fx (Asset * asset) {
+    // Runs from AssetLoader_Pump at the top of a frame, so the effect and
+    // its handles are swapped together and never in the middle of a
+    // draw.  On any error the previous effect stays live and the log is
+    // shown in the UI instead of a modal box.
+    D3D9RenderContext * render_ctx = (D3D9RenderContext *)asset->user;
+    CompiledFx * compiled = (CompiledFx *)asset->payload;
+    render_ctx->fx_compiling = false;
+    if (false == asset->ok) {
+        set_fx_error(render_ctx, compiled && compiled->log.data ? (char *)compiled->log.data : asset->path);
+        release_compiled_fx(compiled);
+        return;
+    }
+
+    ID3DXEffect * fx = 0;
+    ID3DXBuffer * errors = 0;
+    D3DXCreateEffect(
+        render_ctx->device, compiled->code.data, (UINT)compiled->code.size,
+        0, 0, 0, 0, &fx, &errors
     );
+    bool cached = SHADER_CACHE_HIT == compiled->status;
+    release_compiled_fx(compiled);
+    if (0 == fx) {
+        set_fx_error(render_ctx, errors ? (char *)errors->GetBufferPointer() : asset->path);
+        if (errors)
+            errors->Release();
+        return;
+    }
     if (errors)
-        MessageBoxA(0, (char *)errors->GetBufferPointer(), 0, 0);
+        errors->Release();
+
+    // Obtain handles.  0 means top-level parameter
+    // from https://docs.microsoft.com/en-us/windows/win32/direct3d9/id3dxbaseeffect--getparameterbyname
+    D3DXHANDLE htech = fx->GetTechniqueByName("transform_tech");
+    D3DXHANDLE hwvp  = fx->GetParameterByName(0, "g_wvp");
+    if (0 == htech || 0 == hwvp) {
+        fx->Release();
+        set_fx_error(render_ctx, "transform.fx: missing technique or parameter");
+        return;
+    }
 
-    // Obtain handles.
-    render_ctx->htech = render_ctx->fx->GetTechniqueByName("transform_tech");
-    render_ctx->hwvp  = render_ctx->fx->GetParameterByName(0, "g_wvp");
+    if (render_ctx->fx)
+        render_ctx->fx->Release();
+    render_ctx->fx      = fx;
+    render_ctx->htech   = htech;
+    render_ctx->hwvp    = hwvp;
+    render_ctx->fx_cached   = cached;
+    render_ctx->fx_error[0] = 0;
+}
+static void
+create_fx (D3D9RenderContext * render_ctx) {
+    // Compiled in the background; the scene isn't drawn until it lands.
+    render_ctx->fx_compiling = true;
+    AssetLoader_Submit(g_asset_loader, "transform.fx", decode_fx, complete_fx, render_ctx);
+}
+static void
+reload_changed_fx (D3D9RenderContext * render_ctx) {
+    // One compile at a time: an edit made while one is in flight stays
+    // pending and starts another once the first lands.
+    if (g_file_watcher && false == render_ctx->fx_compiling &&
+        FileWatcher_TakeChange(g_file_watcher, render_ctx->fx_watch))
+        create_fx(render_ctx);
 }
 
 static void
@@ -99,20 +337,92 @@ check_device_caps () {
     return true;
 }
 static void
-d3d9_lost_device (D3D9RenderContext * render_ctx) {
-    //
+imgui_lost (void * user) {
+    ImGui_ImplDX9_InvalidateDeviceObjects();
 }
 static void
-d3d9_reset_device (D3D9RenderContext * render_ctx) {
-    ImGui_ImplDX9_InvalidateDeviceObjects();
-    render_ctx->device->Reset(&render_ctx->present_params);
+imgui_restore (IDirect3DDevice9 * device, void * user) {
     ImGui_ImplDX9_CreateDeviceObjects();
-
-    render_ctx->fx->OnResetDevice();
-
+}
+static void
+fx_lost (void * user) {
+    D3D9RenderContext * render_ctx = (D3D9RenderContext *)user;
+    if (render_ctx->fx)
+        render_ctx->fx->OnLostDevice();
+}
+static void
+fx_restore (IDirect3DDevice9 * device, void * user) {
+    D3D9RenderContext * render_ctx = (D3D9RenderContext *)user;
+    if (render_ctx->fx)
+        render_ctx->fx->OnResetDevice();
+}
+static void
+proj_restore (IDirect3DDevice9 * device, void * user) {
     // The aspect ratio depends on the backbuffer dimensions, which can 
     // possibly change after a reset.  So rebuild the projection matrix.
-    create_proj_mat(render_ctx);
+    create_proj_mat((D3D9RenderContext *)user);
+}
+static void
+register_device_resources (D3D9RenderContext * render_ctx) {
+    DeviceResourceDesc const descs[] = {
+        {"imgui",           imgui_lost, imgui_restore,   0},
+        {"transform.fx",    fx_lost,    fx_restore,      render_ctx},
+        {"projection",      0,          proj_restore,    render_ctx},
+    };
+    for (int i = 0; i < _countof(descs); ++i)
+        DeviceResources_Add(g_device_resources, &descs[i]);
+}
+static void
+d3d9_reset_device (D3D9RenderContext * render_ctx) {
+    DeviceResources_Reset(g_device_resources, &render_ctx->present_params);
+    FrameScheduler_MarkDirty(g_frame_scheduler);
+}
+static bool
+imgui_lock_vertices (void * user, unsigned int count, unsigned int stride, IDirect3DVertexBuffer9 ** buffer, unsigned int * first, void ** data) {
+    GeometryRing * ring = (GeometryRing *)user;
+    GeometryRingSpan span;
+    if (false == GeometryRing_LockVertices(ring, count, stride, &span))
+        return false;
+    *buffer = GeometryRing_VertexBuffer(ring);
+    *first = span.first;
+    *data = span.data;
+    return true;
+}
+static void
+imgui_unlock_vertices (void * user) {
+    GeometryRing_UnlockVertices((GeometryRing *)user);
+}
+static bool
+imgui_lock_indices (void * user, unsigned int count, unsigned int index_size, IDirect3DIndexBuffer9 ** buffer, unsigned int * first, void ** data) {
+    // The ring only holds 16-bit indices.
+    GeometryRing * ring = (GeometryRing *)user;
+    GeometryRingSpan span;
+    if (index_size != sizeof(WORD) || false == GeometryRing_LockIndices(ring, count, &span))
+        return false;
+    *buffer = GeometryRing_IndexBuffer(ring);
+    *first = span.first;
+    *data = span.data;
+    return true;
+}
+static void
+imgui_unlock_indices (void * user) {
+    GeometryRing_UnlockIndices((GeometryRing *)user);
+}
+// ImGui tessellates window draw lists and rasterizes font glyphs on the pool (io.ParallelForFn, io.Fonts->ParallelForFn).
+struct ImGuiParallelTask {
+    void    (*task) (void * task_data, int index);
+    void *  task_data;
+};
+static void
+imgui_parallel_range (void * ctx, uint32_t begin, uint32_t end) {
+    ImGuiParallelTask const * t = (ImGuiParallelTask const *)ctx;
+    for (uint32_t i = begin; i < end; ++i)
+        t->task(t->task_data, (int)i);
+}
+static void
+imgui_parallel_for (void * user, int count, void (*task) (void * task_data, int index), void * task_data) {
+    ImGuiParallelTask t = {task, task_data};
+    ThreadPool_ParallelFor((ThreadPool *)user, (uint32_t)count, 1, imgui_parallel_range, &t);
 }
 static bool is_device_lost (D3D9RenderContext * render_ctx) {
     // Get the state of the graphics device.
@@ -129,7 +439,6 @@ static bool is_device_lost (D3D9RenderContext * render_ctx) {
         return true;
     } else if (hr == D3DERR_DEVICENOTRESET) {
         // The device is lost but we can reset and restore it.
-        d3d9_lost_device(render_ctx);
         d3d9_reset_device(render_ctx);
         return false;
     } else
@@ -180,14 +489,18 @@ d3d9_enable_fullscreen_mode (D3D9RenderContext * render_ctx, bool enable) {
     }
 
     // Reset the device with the changes.
-    d3d9_lost_device(render_ctx);
     d3d9_reset_device(render_ctx);
 }
-static void
+// Returns true while the camera is moving.
+static bool
 update_scene (D3D9RenderContext * render_ctx, float dt) {
     // Get snapshot of input devices.
     DirectInput_Poll(g_dinput);
 
+    float prev_rotation_y = render_ctx->camera_rotation_y;
+    float prev_radius     = render_ctx->camera_radius;
+    float prev_height     = render_ctx->camera_height;
+
     // Check input.
     if (DirectInput_KeyDown(g_dinput, DIK_W))
         render_ctx->camera_height   += 25.0f * dt;
@@ -210,23 +523,29 @@ update_scene (D3D9RenderContext * render_ctx, float dt) {
     // change every frame based on input, so we need to rebuild the
     // view matrix every frame with the latest changes.
     create_view_mat(render_ctx);
+
+    return DirectInput_KeyDown(g_dinput, DIK_W) || DirectInput_KeyDown(g_dinput, DIK_S) ||
+           prev_rotation_y != render_ctx->camera_rotation_y ||
+           prev_radius     != render_ctx->camera_radius ||
+           prev_height     != render_ctx->camera_height;
 }
 static void
 draw_teapot (D3D9RenderContext * render_ctx) {
     D3DXMATRIX T;
     D3DXMatrixTranslation(&T, 2.0f, 2.0f, -2.0f);
-    D3DXMATRIX view_proj = T * render_ctx->view * render_ctx->proj;
+    D3DXMATRIX world_view = T * render_ctx->view;
+    D3DXMATRIX view_proj = world_view * render_ctx->proj;
     render_ctx->fx->SetMatrix(render_ctx->hwvp, &view_proj);
     render_ctx->fx->CommitChanges();
-    render_ctx->teapot_mesh->DrawSubset(0);
+
+    // Pick the coarsest LOD whose error stays under lod_pixel_error pixels.
+    float proj_scale = render_ctx->proj._22 * render_ctx->present_params.BackBufferHeight * 0.5f;
+    UINT lod = GpuMesh_SelectLod(&render_ctx->teapot_mesh, &world_view, proj_scale, render_ctx->lod_pixel_error);
+    GpuMesh_Bind(render_ctx->device, &render_ctx->teapot_mesh);
+    GpuMesh_Draw(render_ctx->device, &render_ctx->teapot_mesh, lod);
 }
 static void
-draw_scene (D3D9RenderContext * render_ctx) {
-
-    render_ctx->device->Clear(0, 0, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, D3DCOLOR_XRGB(255, 255, 255), 1.0f, 0);
-
-    render_ctx->device->BeginScene();
-
+draw_passes (D3D9RenderContext * render_ctx) {
     // setup fx
     render_ctx->fx->SetTechnique(render_ctx->htech);
 
@@ -241,9 +560,20 @@ draw_scene (D3D9RenderContext * render_ctx) {
         render_ctx->fx->EndPass();
     }
     render_ctx->fx->End();
+}
+static void
+draw_scene (D3D9RenderContext * render_ctx) {
+
+    render_ctx->device->Clear(0, 0, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, D3DCOLOR_XRGB(255, 255, 255), 1.0f, 0);
+
+    GeometryRing_BeginFrame(g_geometry_ring);
+    render_ctx->device->BeginScene();
+
+    // Nothing but the UI to draw until the effect has loaded.
+    if (render_ctx->fx)
+        draw_passes(render_ctx);
 
 #ifdef ENABLE_IMGUI
-    ImGui::Render();
     ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
 #endif // ENABLE_IMGUI
 
@@ -282,7 +612,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
             } else if (wparam == SIZE_MAXIMIZED) {
                 render_ctx->paused = false;
                 min_maxed = true;
-                d3d9_lost_device(render_ctx);
                 d3d9_reset_device(render_ctx);
             }
             // Restored is any resize that is not a minimize or maximize.
@@ -296,7 +625,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
                 // and are in windowed mode?  Do not execute this code if 
                 // we are restoring to full screen mode.
                 if (min_maxed && render_ctx->present_params.Windowed) {
-                    d3d9_lost_device(render_ctx);
                     d3d9_reset_device(render_ctx);
                 } else {
                     // No, which implies the user is resizing by dragging
@@ -321,7 +649,6 @@ msg_proc (D3D9RenderContext * render_ctx, UINT msg, WPARAM wparam, LPARAM lparam
         GetClientRect(render_ctx->wnd, &client_rect);
         render_ctx->present_params.BackBufferWidth  = client_rect.right;
         render_ctx->present_params.BackBufferHeight = client_rect.bottom;
-        d3d9_lost_device(render_ctx);
         d3d9_reset_device(render_ctx);
 
         return 0;
@@ -351,6 +678,7 @@ extern IMGUI_IMPL_API LRESULT
 ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 LRESULT CALLBACK
 wnd_proc (HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
+    FrameScheduler_OnMessage(g_frame_scheduler, msg);
     if (ImGui_ImplWin32_WndProcHandler(hwnd, msg, wparam, lparam))
         return true;
     // Don't start processing messages until the application has been created.
@@ -467,6 +795,8 @@ init_render_ctx (
         render_ctx->camera_rotation_y = 1.2 * D3DX_PI;
         render_ctx->camera_height = 5.0f;
 
+        render_ctx->lod_pixel_error = 1.0f;
+
         render_ctx->initialized = true;
 
         //d3d9_reset_device(render_ctx);
@@ -481,6 +811,9 @@ WinMain (
 
 #pragma region Initialize
 
+    // First, as the window procedure reports to it from the start.
+    g_frame_scheduler = FrameScheduler_Create(IDLE_REDRAW_MS);
+
     g_render_ctx = (D3D9RenderContext *)::malloc(sizeof(D3D9RenderContext));
     init_render_ctx(
         g_render_ctx,
@@ -502,11 +835,20 @@ WinMain (
         g_render_ctx->wnd
     );
 
-    // -- create shapes
-    D3DXCreateTeapot(g_render_ctx->device, &g_render_ctx->teapot_mesh, 0);
-
+    // -- start compiling the effect, then create shapes while it builds
+    g_thread_pool = ThreadPool_Create(0);
+    g_device_resources = DeviceResources_Create(g_render_ctx->device);
+    register_device_resources(g_render_ctx);
+    g_geometry_ring = GeometryRing_Create(g_device_resources, 1024 * 1024, 64 * 1024);
+    g_asset_loader = AssetLoader_Create(g_thread_pool);
+    g_file_watcher = FileWatcher_Create(".");
+    ShaderCompiler fx_compiler = {compile_fx, 0, D3DX_SDK_VERSION};
+    g_shader_cache = ShaderCache_Create("shader_cache", &fx_compiler);
+    g_render_ctx->fx_watch = g_file_watcher ? FileWatcher_Add(g_file_watcher, "transform.fx") : -1;
     create_fx(g_render_ctx);
 
+    create_teapot(g_render_ctx);
+
     d3d9_reset_device(g_render_ctx);
 
     InitAllVertexDeclarations(g_render_ctx->device, &g_vertex_pos);
@@ -515,6 +857,11 @@ WinMain (
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
+    io.ConfigDeferredDrawLists = true;
+    io.ParallelForFn = imgui_parallel_for;
+    io.ParallelForUserData = g_thread_pool;
+    io.Fonts->ParallelForFn = imgui_parallel_for;
+    io.Fonts->ParallelForUserData = g_thread_pool;
     //io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
     //io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
 
@@ -526,6 +873,12 @@ WinMain (
     ImGui_ImplWin32_Init(g_render_ctx->wnd);
     ImGui_ImplDX9_Init(g_render_ctx->device);
 
+    // ImGui streams its geometry through the shared ring too
+    ImGui_ImplDX9_BufferAllocator imgui_allocator = {
+        g_geometry_ring, imgui_lock_vertices, imgui_unlock_vertices, imgui_lock_indices, imgui_unlock_indices
+    };
+    ImGui_ImplDX9_SetBufferAllocator(&imgui_allocator);
+
 #pragma endregion
 #pragma region Main Loop
     MSG  msg;
@@ -550,11 +903,30 @@ WinMain (
                 Sleep(20);
                 continue;
             }
-            if (false == is_device_lost(g_render_ctx)) {
+            // Nothing changed since the last frame: block until something
+            // does or the idle redraw is due.  Time spent waiting doesn't
+            // advance the simulation.
+            if (false == FrameScheduler_ShouldDraw(g_frame_scheduler)) {
+                FrameScheduler_Wait(g_frame_scheduler);
+                QueryPerformanceCounter((LARGE_INTEGER*)&prev_time_stamp);
+                continue;
+            }
+            if (is_device_lost(g_render_ctx)) {
+                // Keep checking until the device can be reset.
+                FrameScheduler_Invalidate(g_frame_scheduler, 1);
+            } else {
                 __int64 curr_time_stamp = 0;
                 QueryPerformanceCounter((LARGE_INTEGER*)&curr_time_stamp);
                 float dt = (curr_time_stamp - prev_time_stamp) * secs_per_cnt;
 
+                // Recompile the effect if it was edited, and pick it up
+                // once the worker has compiled it.
+                reload_changed_fx(g_render_ctx);
+                if (AssetLoader_Pump(g_asset_loader) > 0)
+                    FrameScheduler_MarkDirty(g_frame_scheduler);
+                if (AssetLoader_Pending(g_asset_loader) > 0)
+                    FrameScheduler_Invalidate(g_frame_scheduler, 1);
+
                 //
                 // DearImGui
                 // 
@@ -575,14 +947,43 @@ WinMain (
                     ImGui::SameLine();
                     ImGui::Text("counter = %d", counter);
 
-                    ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+                    ImGui::SliderFloat("LOD pixel error", &g_render_ctx->lod_pixel_error, 0.0f, 16.0f);
+                    if (g_render_ctx->fx)
+                        ImGui::Text("transform.fx: %s", g_render_ctx->fx_cached ? "from shader cache" : "compiled");
+                    if (g_render_ctx->fx_error[0])
+                        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_render_ctx->fx_error);
+                    GeometryRingStats ring = GeometryRing_Stats(g_geometry_ring);
+                    ImGui::Text(
+                        "Streamed geometry: %u KB/frame, peak %u KB of %u KB, %u locks, %u discards",
+                        (ring.vertex_frame_bytes + ring.index_frame_bytes) / 1024,
+                        (ring.vertex_high_water + ring.index_high_water) / 1024,
+                        (ring.vertex_size + ring.index_size) / 1024, ring.locks, ring.discards
+                    );
+                    ImGui::Text("Last device reset: %.2f ms", DeviceResources_LastResetMs(g_device_resources));
+                    // Updated once a second: text changing every frame would
+                    // get every frame presented.
+                    FrameSchedulerStats frames = FrameScheduler_Stats(g_frame_scheduler);
+                    ImGui::Text("Frames drawn: %u/s (%u idle redraws), %u presented", frames.frames, frames.idle_frames, frames.presents);
+                    ImGui::Text("Application average %.3f ms/frame, %.0f%% of the time idle", frames.frame_ms, frames.idle_percent);
                     ImGui::End();
 
                     ImGui::EndFrame();
+
+                    // Keep drawing while a widget is held, a window is being
+                    // dragged or text is being typed (the caret blinks).
+                    ImGuiIO & io = ImGui::GetIO();
+                    if (ImGui::IsAnyItemActive() || io.WantTextInput || (io.WantCaptureMouse && ImGui::IsAnyMouseDown()))
+                        FrameScheduler_Invalidate(g_frame_scheduler, 1);
                 }
 
-                update_scene(g_render_ctx, dt);
-                draw_scene(g_render_ctx);
+                if (update_scene(g_render_ctx, dt))
+                    FrameScheduler_MarkDirty(g_frame_scheduler);
+
+                // Neither the scene nor the UI changed: what's on screen is
+                // still right, so it is neither rendered nor presented again.
+                ImGui::Render();
+                if (FrameScheduler_ShouldPresent(g_frame_scheduler, ImGui::GetDrawData()->ContentHash))
+                    draw_scene(g_render_ctx);
 
                 // Prepare for next iteration: The current time stamp becomes
                 // the previous time stamp for the next iteration.
@@ -603,9 +1004,19 @@ WinMain (
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
 
+    FileWatcher_Destroy(g_file_watcher);
+    AssetLoader_Destroy(g_asset_loader);
+    ShaderCache_Destroy(g_shader_cache);
+    GeometryRing_Destroy(g_geometry_ring);
+    DeviceResources_Destroy(g_device_resources);
+    ThreadPool_Destroy(g_thread_pool);
+
+    GpuMesh_Release(&g_render_ctx->teapot_mesh);
+
     DirectInput_Deinit(g_dinput);
 
     ::free(g_render_ctx);
+    FrameScheduler_Destroy(g_frame_scheduler);
 #pragma endregion
 }
 
@@ -54,6 +54,20 @@
 //---- Use 32-bit for ImWchar (default is 16-bit) to support unicode planes 1-16. (e.g. point beyond 0xFFFF like emoticons, dingbats, symbols, shapes, ancient languages, etc...)
 //#define IMGUI_USE_WCHAR32
 
+//---- Use another hash function for IDs (ImHashData/ImHashStr). The default is CRC32, computed 8 bytes at a time.
+// Both alternatives produce different IDs: settings that .ini files store by ID (e.g. tables) won't be found again when switching hash.
+//#define IMGUI_USE_CRC32C_HASH     // CRC32-C with the SSE4.2 'crc32' instruction. Requires SSE4.2 (-msse4.2 with GCC/Clang; MSVC x86/x64 builds can always use it, the CPU must support it).
+//#define IMGUI_USE_FAST_HASH       // Non-CRC 64-bit multiply/rotate hash, 8 bytes at a time. Portable, but IDs depend on the platform's endianness.
+
+//---- Index ImGuiStorage with an open-addressing hash table instead of keeping its pairs sorted (binary search + mid-vector insertion).
+// Lookups and insertions become O(1), which pays off with thousands of keys (e.g. many tree nodes or windows), at the cost of 5 bytes per index slot (1.33x to 2.67x the pair count).
+// ImGuiStorage::Data stays a contiguous array of pairs, but in insertion order instead of sorted by key.
+//#define IMGUI_USE_HASHED_STORAGE
+
+//---- Don't use the SIMD kernels of AddPolyline()/AddConvexPolyFilled() (AVX when compiled with it, otherwise SSE2 on x86/x64 or NEON on AArch64).
+// Their output matches the scalar code, so this is mostly useful to compare the two.
+//#define IMGUI_DISABLE_SIMD_TESSELLATION
+
 //---- Avoid multiple STB libraries implementations, or redefine path/filenames to prioritize another version
 // By default the embedded implementations are declared static and not available outside of Dear ImGui sources files.
 //#define IMGUI_STB_TRUETYPE_FILENAME   "my_folder/stb_truetype.h"
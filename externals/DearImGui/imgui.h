@@ -28,7 +28,7 @@ Index of this file:
 // [SECTION] ImGuiStyle
 // [SECTION] ImGuiIO
 // [SECTION] Misc data structures (ImGuiInputTextCallbackData, ImGuiSizeCallbackData, ImGuiPayload, ImGuiTableSortSpecs, ImGuiTableColumnSortSpecs)
-// [SECTION] Helpers (ImGuiOnceUponAFrame, ImGuiTextFilter, ImGuiTextBuffer, ImGuiStorage, ImGuiListClipper, ImColor)
+// [SECTION] Helpers (ImGuiOnceUponAFrame, ImGuiTextFilter, ImGuiTextBuffer, ImGuiStorage, ImGuiListClipper, ImGuiPlotPyramid, ImColor)
 // [SECTION] Drawing API (ImDrawCallback, ImDrawCmd, ImDrawIdx, ImDrawVert, ImDrawChannel, ImDrawListSplitter, ImDrawFlags, ImDrawListFlags, ImDrawList, ImDrawData)
 // [SECTION] Font API (ImFontConfig, ImFontGlyph, ImFontGlyphRangesBuilder, ImFontAtlasFlags, ImFontAtlas, ImFont)
 // [SECTION] Viewports (ImGuiViewportFlags, ImGuiViewport)
@@ -138,6 +138,7 @@ struct ImGuiInputTextCallbackData;  // Shared state of InputText() when using cu
 struct ImGuiListClipper;            // Helper to manually clip large list of items
 struct ImGuiOnceUponAFrame;         // Helper for running a block of code not more than once a frame, used by IMGUI_ONCE_UPON_A_FRAME macro
 struct ImGuiPayload;                // User data payload for drag and drop operations
+struct ImGuiPlotPyramid;            // Helper holding a multi-resolution summary of a large series of values, for PlotLinesLOD()/PlotHistogramLOD()
 struct ImGuiSizeCallbackData;       // Callback data when using SetNextWindowSizeConstraints() (rare/advanced use)
 struct ImGuiStorage;                // Helper for key->value storage
 struct ImGuiStyle;                  // Runtime data for styling/colors
@@ -159,6 +160,7 @@ typedef int ImGuiKey;               // -> enum ImGuiKey_             // Enum: A
 typedef int ImGuiNavInput;          // -> enum ImGuiNavInput_        // Enum: An input identifier for navigation
 typedef int ImGuiMouseButton;       // -> enum ImGuiMouseButton_     // Enum: A mouse button identifier (0=left, 1=right, 2=middle)
 typedef int ImGuiMouseCursor;       // -> enum ImGuiMouseCursor_     // Enum: A mouse cursor identifier
+typedef int ImGuiPlotDownsample;    // -> enum ImGuiPlotDownsample_  // Enum: A downsampling method for PlotLinesLOD()
 typedef int ImGuiSortDirection;     // -> enum ImGuiSortDirection_   // Enum: A sorting direction (ascending or descending)
 typedef int ImGuiStyleVar;          // -> enum ImGuiStyleVar_        // Enum: A variable identifier for styling
 typedef int ImGuiTableBgTarget;     // -> enum ImGuiTableBgTarget_   // Enum: A color target for TableSetBgColor()
@@ -345,6 +347,8 @@ namespace ImGui
     IMGUI_API void          SetWindowSize(const char* name, const ImVec2& size, ImGuiCond cond = 0);    // set named window size. set axis to 0.0f to force an auto-fit on this axis.
     IMGUI_API void          SetWindowCollapsed(const char* name, bool collapsed, ImGuiCond cond = 0);   // set named window collapsed state
     IMGUI_API void          SetWindowFocus(const char* name);                                           // set named window to be focused / top-most. use NULL to remove focus.
+    IMGUI_API void          MarkWindowDrawCacheDirty();                                                 // have the current window record its contents again next frame instead of replaying them (windows using ImGuiWindowFlags_CacheDrawList).
+    IMGUI_API void          MarkWindowDrawCacheDirty(const char* name);                                 // have the named window record its contents again the next time it is submitted, e.g. after changing the data it displays.
 
     // Content region
     // - Retrieve available space from a given point. GetContentRegionAvail() is frequently useful.
@@ -602,6 +606,10 @@ namespace ImGui
     IMGUI_API void          PlotLines(const char* label, float(*values_getter)(void* data, int idx), void* data, int values_count, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0, 0));
     IMGUI_API void          PlotHistogram(const char* label, const float* values, int values_count, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0, 0), int stride = sizeof(float));
     IMGUI_API void          PlotHistogram(const char* label, float(*values_getter)(void* data, int idx), void* data, int values_count, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0, 0));
+    // - Large series (millions of values): plot the values summarized by a ImGuiPlotPyramid, downsampled to one pixel column at a time (see ImGuiPlotDownsample_, 0 = MinMax).
+    //   Each frame costs O(graph width * log(values count)) instead of O(values count), and every spike stays visible.
+    IMGUI_API void          PlotLinesLOD(const char* label, const ImGuiPlotPyramid* pyramid, ImGuiPlotDownsample downsample = 0, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0, 0));
+    IMGUI_API void          PlotHistogramLOD(const char* label, const ImGuiPlotPyramid* pyramid, int values_offset = 0, const char* overlay_text = NULL, float scale_min = FLT_MAX, float scale_max = FLT_MAX, ImVec2 graph_size = ImVec2(0, 0)); // one bar per pixel column, from the zero line to the column's min/max
 
     // Widgets: Value() Helpers.
     // - Those are merely shortcut to calling Text() with a format string. Output single value in "name: value" format (tip: freely declare more in your code to handle your types. you can add functions to the ImGui namespace)
@@ -918,6 +926,7 @@ enum ImGuiWindowFlags_
     ImGuiWindowFlags_NoNavInputs            = 1 << 18,  // No gamepad/keyboard navigation within the window
     ImGuiWindowFlags_NoNavFocus             = 1 << 19,  // No focusing toward this window with gamepad/keyboard navigation (e.g. skipped by CTRL+TAB)
     ImGuiWindowFlags_UnsavedDocument        = 1 << 20,  // Append '*' to title without affecting the ID, as a convenience to avoid using the ### operator. When used in a tab/docking context, tab is selected on closure and closure is deferred by one frame to allow code to cancel the closure (with a confirmation popup, etc.) without flicker.
+    ImGuiWindowFlags_CacheDrawList          = 1 << 21,  // Keep the vertices output by the window contents, and replay them (translated when the window moves) instead of running them again while the mouse/keyboard leave the window alone and its size, scroll, style and font don't change. Begin() returns false when replaying: only submit contents when it returns true. Call MarkWindowDrawCacheDirty() when what the contents display changes. Not cached: windows beginning other windows (e.g. child windows, tooltips) or appended to with multiple Begin()/End().
     ImGuiWindowFlags_NoNav                  = ImGuiWindowFlags_NoNavInputs | ImGuiWindowFlags_NoNavFocus,
     ImGuiWindowFlags_NoDecoration           = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoCollapse,
     ImGuiWindowFlags_NoInputs               = ImGuiWindowFlags_NoMouseInputs | ImGuiWindowFlags_NoNavInputs | ImGuiWindowFlags_NoNavFocus,
@@ -1296,6 +1305,13 @@ enum ImGuiSortDirection_
     ImGuiSortDirection_Descending   = 2     // Descending = 9->0, Z->A etc.
 };
 
+// A downsampling method for PlotLinesLOD(), choosing which values of a large series get drawn
+enum ImGuiPlotDownsample_
+{
+    ImGuiPlotDownsample_MinMax      = 0,    // For each pixel column: its first, min, max and last values (M4). Draws the same pixels as plotting every value.
+    ImGuiPlotDownsample_LTTB        = 1     // Largest-Triangle-Three-Buckets: one value per pixel column, the one forming the largest triangle with its neighbors. Smoother, keeps the shape and most spikes.
+};
+
 // User fill ImGuiIO.KeyMap[] array with indices into the ImGuiIO.KeysDown[512] array
 enum ImGuiKey_
 {
@@ -1792,6 +1808,7 @@ struct ImGuiIO
     bool        ConfigWindowsResizeFromEdges;   // = true           // Enable resizing of windows from their edges and from the lower-left corner. This requires (io.BackendFlags & ImGuiBackendFlags_HasMouseCursors) because it needs mouse cursor feedback. (This used to be a per-window ImGuiWindowFlags_ResizeFromAnySide flag)
     bool        ConfigWindowsMoveFromTitleBarOnly; // = false       // Enable allowing to move windows only when clicking on their title bar. Does not apply to windows without a title bar.
     float       ConfigMemoryCompactTimer;       // = 60.0f          // Timer (in seconds) to free transient windows/tables memory buffers when unused. Set to -1.0f to disable.
+    bool        ConfigDeferredDrawLists;        // = false          // Window draw lists record their primitives during the frame and tessellate them in Render(), in parallel if ParallelForFn is set. Output is identical.
 
     //------------------------------------------------------------------
     // Platform Functions
@@ -1816,6 +1833,11 @@ struct ImGuiIO
     void        (*ImeSetInputScreenPosFn)(int x, int y);
     void*       ImeWindowHandle;                // = NULL           // (Windows) Set this to your HWND to get automatic IME cursor positioning.
 
+    // Optional: Run tasks on worker threads. Used by Render() to tessellate window draw lists in parallel when io.ConfigDeferredDrawLists is set.
+    // Call task(task_data, index) for each index in [0, count), in any order and on any thread, and return once all of them are done.
+    void        (*ParallelForFn)(void* user_data, int count, void (*task)(void* task_data, int index), void* task_data);
+    void*       ParallelForUserData;
+
     //------------------------------------------------------------------
     // Input - Fill before calling NewFrame()
     //------------------------------------------------------------------
@@ -1985,7 +2007,7 @@ struct ImGuiTableSortSpecs
 };
 
 //-----------------------------------------------------------------------------
-// [SECTION] Helpers (ImGuiOnceUponAFrame, ImGuiTextFilter, ImGuiTextBuffer, ImGuiStorage, ImGuiListClipper, ImColor)
+// [SECTION] Helpers (ImGuiOnceUponAFrame, ImGuiTextFilter, ImGuiTextBuffer, ImGuiStorage, ImGuiListClipper, ImGuiPlotPyramid, ImColor)
 //-----------------------------------------------------------------------------
 
 // Helper: Unicode defines
@@ -2073,11 +2095,20 @@ struct ImGuiStorage
     };
 
     ImVector<ImGuiStoragePair>      Data;
+#ifdef IMGUI_USE_HASHED_STORAGE
+    // Hash index over Data (see imconfig.h): pairs stay contiguous in insertion order and the index maps keys to them.
+    ImVector<unsigned char>         Ctrl;       // One byte per slot, plus a copy of the first 15 so a probe can read 16 bytes from any slot. 0x80 = empty, else 7 bits of the key's hash.
+    ImVector<int>                   Slots;      // Index into Data for each used slot
+#endif
 
-    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N)
+    // - Get***() functions find pair, never add/allocate. Pairs are sorted so a query is O(log N) (O(1) with IMGUI_USE_HASHED_STORAGE)
     // - Set***() functions find pair, insertion on demand if missing.
-    // - Sorted insertion is costly, paid once. A typical frame shouldn't need to insert any new pair.
+    // - Sorted insertion is costly, paid once. A typical frame shouldn't need to insert any new pair. (With IMGUI_USE_HASHED_STORAGE insertion is O(1) amortized.)
+#ifdef IMGUI_USE_HASHED_STORAGE
+    void                Clear() { Data.clear(); Ctrl.clear(); Slots.clear(); }
+#else
     void                Clear() { Data.clear(); }
+#endif
     IMGUI_API int       GetInt(ImGuiID key, int default_val = 0) const;
     IMGUI_API void      SetInt(ImGuiID key, int val);
     IMGUI_API bool      GetBool(ImGuiID key, bool default_val = false) const;
@@ -2099,7 +2130,11 @@ struct ImGuiStorage
     // Use on your own storage if you know only integer are being stored (open/close all tree nodes)
     IMGUI_API void      SetAllInt(int val);
 
+    // Remove a pair, if present. Invalidates pointers returned by Get***Ref(), like an insertion.
+    IMGUI_API void      Remove(ImGuiID key);
+
     // For quicker full rebuild of a storage (instead of an incremental one), you may add all your contents and then sort once.
+    // (With IMGUI_USE_HASHED_STORAGE this rebuilds the hash index over Data instead. Keys must be unique.)
     IMGUI_API void      BuildSortByKey();
 };
 
@@ -2146,6 +2181,47 @@ struct ImGuiListClipper
 #endif
 };
 
+// Helper: Multi-resolution summary of a large series of values, for PlotLinesLOD() and PlotHistogramLOD().
+// Level 0 summarizes the values 8 at a time (min, max, their indices, sum), each next level summarizes 8 nodes of the previous one, up to a single node.
+// - Build() reads every value once. The pyramid holds about 1 node (24 bytes) per 7 values.
+// - Query() summarizes any range of values from at most 14 nodes or values per level, which is what lets the LOD plots
+//   spend O(log(values count)) per pixel column. The values themselves are only read at the ends of ranges.
+// - Values are read through the array or getter given to Build(): keep them alive. After modifying values in place, call Update()
+//   on the modified range. After adding or removing values, call Build() again.
+// Usage:
+//   static ImGuiPlotPyramid pyramid;
+//   if (samples_changed)
+//       pyramid.Build(samples.Data, samples.Size);
+//   ImGui::PlotLinesLOD("Signal", &pyramid, ImGuiPlotDownsample_MinMax, 0, NULL, FLT_MAX, FLT_MAX, ImVec2(0, 200.0f));
+struct ImGuiPlotPyramid
+{
+    // Summary of a range of values. NaN values are ignored: when all are NaN, Count is 0 and MinIdx/MaxIdx are -1.
+    struct ImGuiPlotPyramidNode
+    {
+        float   Min, Max;
+        int     MinIdx, MaxIdx;     // Index of a value equal to Min/Max
+        float   Sum;
+        int     Count;              // Number of non-NaN values
+    };
+
+    const float*                    Values;             // Set by Build(values, ...)
+    int                             ValuesStride;
+    float                           (*ValuesGetter)(void* data, int idx); // Set by Build(values_getter, ...)
+    void*                           ValuesGetterData;
+    int                             ValuesCount;
+    ImVector<ImGuiPlotPyramidNode>  Nodes;              // All levels, finest first
+    ImVector<int>                   LevelStart;         // Index into Nodes[] of the first node of each level, followed by Nodes.Size
+
+    ImGuiPlotPyramid()              { Values = NULL; ValuesStride = 0; ValuesGetter = NULL; ValuesGetterData = NULL; ValuesCount = 0; }
+    IMGUI_API void                  Build(const float* values, int values_count, int stride = sizeof(float));
+    IMGUI_API void                  Build(float (*values_getter)(void* data, int idx), void* data, int values_count);
+    IMGUI_API void                  Update(int first, int count);                                   // Recompute the nodes covering values [first, first + count)
+    IMGUI_API void                  Query(int first, int last, ImGuiPlotPyramidNode* out) const;    // Summarize values [first, last)
+    void                            Clear()                 { Values = NULL; ValuesGetter = NULL; ValuesGetterData = NULL; ValuesCount = 0; Nodes.clear(); LevelStart.clear(); }
+    int                             GetLevelsCount() const  { return LevelStart.Size > 0 ? LevelStart.Size - 1 : 0; }
+    float                           GetValue(int idx) const { IM_ASSERT(idx >= 0 && idx < ValuesCount); return ValuesGetter ? ValuesGetter(ValuesGetterData, idx) : *(const float*)(const void*)((const unsigned char*)Values + (size_t)idx * ValuesStride); }
+};
+
 // Helpers macros to generate 32-bit encoded colors
 #ifdef IMGUI_USE_BGRA_PACKED_COLOR
 #define IM_COL32_R_SHIFT    16
@@ -2262,6 +2338,35 @@ struct ImDrawCmdHeader
     unsigned int    VtxOffset;
 };
 
+// [Internal] For use by ImDrawList: a primitive recorded with ImDrawListFlags_Deferred
+enum ImDrawDeferredOp_
+{
+    ImDrawDeferredOp_SetClipRect,           // ClipRect
+    ImDrawDeferredOp_SetTextureID,          // TextureId
+    ImDrawDeferredOp_RectFilled,            // ClipRect = p_min, p_max (x, y, z, w), Col
+    ImDrawDeferredOp_Polyline,              // _DeferredPoints[DataOffset..], Col, DrawFlags, Size = thickness
+    ImDrawDeferredOp_ConvexPolyFilled,      // _DeferredPoints[DataOffset..], Col
+    ImDrawDeferredOp_Text,                  // _DeferredText[DataOffset..], Font, Size = font size, Pos, Col, WrapWidth
+    ImDrawDeferredOp_TextClipped            // Same as Text, with ClipRect = cpu_fine_clip_rect
+};
+
+// [Internal] For use by ImDrawList
+struct ImDrawDeferredPrim
+{
+    int             Op;             // ImDrawDeferredOp_
+    ImDrawListFlags Flags;          // ImDrawList::Flags when recorded
+    ImU32           Col;
+    ImDrawFlags     DrawFlags;
+    ImVec4          ClipRect;
+    ImVec2          Pos;
+    float           Size;
+    float           WrapWidth;
+    int             DataOffset;
+    int             DataCount;
+    const ImFont*   Font;
+    ImTextureID     TextureId;
+};
+
 // [Internal] For use by ImDrawListSplitter
 struct ImDrawChannel
 {
@@ -2315,7 +2420,8 @@ enum ImDrawListFlags_
     ImDrawListFlags_AntiAliasedLines        = 1 << 0,  // Enable anti-aliased lines/borders (*2 the number of triangles for 1.0f wide line or lines thin enough to be drawn using textures, otherwise *3 the number of triangles)
     ImDrawListFlags_AntiAliasedLinesUseTex  = 1 << 1,  // Enable anti-aliased lines/borders using textures when possible. Require backend to render with bilinear filtering.
     ImDrawListFlags_AntiAliasedFill         = 1 << 2,  // Enable anti-aliased edge around filled shapes (rounded rectangles, circles).
-    ImDrawListFlags_AllowVtxOffset          = 1 << 3   // Can emit 'VtxOffset > 0' to allow large meshes. Set when 'ImGuiBackendFlags_RendererHasVtxOffset' is enabled.
+    ImDrawListFlags_AllowVtxOffset          = 1 << 3,  // Can emit 'VtxOffset > 0' to allow large meshes. Set when 'ImGuiBackendFlags_RendererHasVtxOffset' is enabled.
+    ImDrawListFlags_Deferred                = 1 << 4   // Record AddPolyline(), AddConvexPolyFilled(), AddText() and non-rounded AddRectFilled() calls and tessellate them later, when something needs the buffers (set on window draw lists by 'io.ConfigDeferredDrawLists'). Don't toggle while primitives are pending.
 };
 
 // Draw command list
@@ -2334,6 +2440,7 @@ struct ImDrawList
     ImVector<ImDrawIdx>     IdxBuffer;          // Index buffer. Each command consume ImDrawCmd::ElemCount of those
     ImVector<ImDrawVert>    VtxBuffer;          // Vertex buffer.
     ImDrawListFlags         Flags;              // Flags, you may poke into these to adjust anti-aliasing settings per-primitive.
+    ImU64                   ContentHash;        // 64-bit hash of the three buffers above, clip rectangles, texture ids and callback/data pointers included. Set by ImGui::Render() on the lists it outputs: same hash = same content as a previous frame. What a callback draws isn't seen: change its UserCallbackData when that changes.
 
     // [Internal, used while building lists]
     unsigned int            _VtxCurrentIdx;     // [Internal] generally == VtxBuffer.Size unless we are past 64K vertices, in which case this gets reset to 0.
@@ -2347,6 +2454,12 @@ struct ImDrawList
     ImDrawCmdHeader         _CmdHeader;         // [Internal] template of active commands. Fields should match those of CmdBuffer.back().
     ImDrawListSplitter      _Splitter;          // [Internal] for channels api (note: prefer using your own persistent instance of ImDrawListSplitter!)
     float                   _FringeScale;       // [Internal] anti-alias fringe is scaled by this value, this helps to keep things sharp while zooming at vertex buffer content
+    ImVector<ImDrawDeferredPrim> _Deferred;     // [Internal] primitives recorded with ImDrawListFlags_Deferred, not tessellated yet
+    ImVector<ImVec2>        _DeferredPoints;    // [Internal] copies of the points passed to AddPolyline()/AddConvexPolyFilled() while deferred
+    ImVector<char>          _DeferredText;      // [Internal] copies of the strings passed to AddText() while deferred
+    ImDrawCmdHeader         _DeferredHeader;    // [Internal] _CmdHeader when _Deferred[0] was recorded, replaying starts from it
+    int                     _DeferredVtxCount;  // [Internal] upper bound of the vertices replaying _Deferred adds
+    int                     _DeferredIdxCount;  // [Internal] upper bound of the indices replaying _Deferred adds
 
     // If you want to create ImDrawList instances, pass them ImGui::GetDrawListSharedData() or create and use your own ImDrawListSharedData (so you can use ImDrawList without ImGui)
     ImDrawList(const ImDrawListSharedData* shared_data) { memset(this, 0, sizeof(*this)); _Data = shared_data; }
@@ -2447,6 +2560,10 @@ struct ImDrawList
     IMGUI_API int   _CalcCircleAutoSegmentCount(float radius) const;
     IMGUI_API void  _PathArcToFastEx(const ImVec2& center, float radius, int a_min_sample, int a_max_sample, int a_step);
     IMGUI_API void  _PathArcToN(const ImVec2& center, float radius, float a_min, float a_max, int num_segments);
+    inline    void  _FlushDeferred()                                            { if (_Deferred.Size != 0) _ReplayDeferred(); } // Tessellate what ImDrawListFlags_Deferred recorded so far
+    IMGUI_API void  _ReplayDeferred();
+    IMGUI_API void  _ReserveDeferred();
+    IMGUI_API ImDrawDeferredPrim* _AddDeferredPrim(int op, int vtx_count, int idx_count);
 };
 
 // All draw data to render a Dear ImGui frame
@@ -2462,12 +2579,16 @@ struct ImDrawData
     ImVec2          DisplayPos;             // Top-left position of the viewport to render (== top-left of the orthogonal projection matrix to use) (== GetMainViewport()->Pos for the main viewport, == (0.0) in most single-viewport applications)
     ImVec2          DisplaySize;            // Size of the viewport to render (== GetMainViewport()->Size for the main viewport, == io.DisplaySize in most single-viewport applications)
     ImVec2          FramebufferScale;       // Amount of pixels for each unit of DisplaySize. Based on io.DisplayFramebufferScale. Generally (1,1) on normal display, (2,2) on OSX with Retina display.
+    ImU64           ContentHash;            // 64-bit hash of the ContentHash of every list in CmdLists, and of the display position/size/scale. Set by ImGui::Render(), 0 otherwise. Backends may keep what they uploaded for a previous frame with the same hash, and applications may skip presenting it again.
+    int             CmdCountBeforeMerge;    // Set by MergeCmdLists(): number of ImDrawCmd in CmdLists
+    int             CmdCountAfterMerge;     // Set by MergeCmdLists(): number of ImDrawCmd it output
 
     // Functions
     ImDrawData()    { Clear(); }
     void Clear()    { memset(this, 0, sizeof(*this)); }     // The ImDrawList are owned by ImGuiContext!
     IMGUI_API void  DeIndexAllBuffers();                    // Helper to convert all buffers from indexed to non-indexed, in case you cannot render indexed. Note: this is slow and most likely a waste of resources. Always prefer indexed rendering!
     IMGUI_API void  ScaleClipRects(const ImVec2& fb_scale); // Helper to scale the ClipRect field of each ImDrawCmd. Use if your final output buffer is at a different scale than Dear ImGui expects, or if there is a difference between your window resolution and framebuffer resolution.
+    IMGUI_API bool  MergeCmdLists(ImDrawList* out_list);    // Helper to issue fewer draw calls: concatenate CmdLists into out_list, merging consecutive commands that use the same texture (across lists too) and dropping those clipped out of the display. When it returns true render out_list instead of CmdLists (callbacks then receive out_list). Without ImGuiBackendFlags_RendererHasVtxOffset every output command has VtxOffset 0, and it returns false with 16-bit indices and 64K+ vertices.
 };
 
 //-----------------------------------------------------------------------------
@@ -2638,6 +2759,12 @@ struct ImFontAtlas
     int                         TexDesiredWidth;    // Texture width desired by user before Build(). Must be a power-of-two. If have many glyphs your graphics API have texture size restrictions you may want to increase texture width to decrease height.
     int                         TexGlyphPadding;    // Padding between glyphs within texture in pixels. Defaults to 1. If your rendering method doesn't rely on bilinear filtering you may set this to 0.
     bool                        Locked;             // Marked as Locked by ImGui::NewFrame() so attempt to modify the atlas will assert.
+    const char*                 CacheFilename;      // = NULL   // Path to a cache of the built atlas (e.g. "imgui_fonts.bin"). Build() loads it instead of rasterizing when it was written from the same fonts and settings, and writes it otherwise. The font builder in use isn't part of the check: delete the file when switching builders.
+
+    // Optional: Run tasks on worker threads, with the same contract as ImGuiIO::ParallelForFn. Used by the stb_truetype builder to rasterize glyphs in parallel.
+    // The allocator set with SetAllocatorFunctions() is then called from those threads (the default malloc/free are thread-safe).
+    void                        (*ParallelForFn)(void* user_data, int count, void (*task)(void* task_data, int index), void* task_data);
+    void*                       ParallelForUserData;
 
     // [Internal]
     // NB: Access texture data via GetTexData*() calls! Which will setup a default font for you.
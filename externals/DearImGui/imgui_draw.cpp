@@ -138,8 +138,18 @@ namespace IMGUI_STB_NAMESPACE
 #ifdef  IMGUI_ENABLE_STB_TRUETYPE
 #ifndef STB_TRUETYPE_IMPLEMENTATION                         // in case the user already have an implementation in the _same_ compilation unit (e.g. unity builds)
 #ifndef IMGUI_DISABLE_STB_TRUETYPE_IMPLEMENTATION           // in case the user already have an implementation in another compilation unit
-#define STBTT_malloc(x,u)   ((void)(u), IM_ALLOC(x))
-#define STBTT_free(x,u)     ((void)(u), IM_FREE(x))
+// Glyphs rasterized on worker threads (ImFontAtlas::ParallelForFn) set the font's user data to an ImFontBuildAllocator:
+// its functions are called directly, as MemAlloc()/MemFree() also update the current context's metrics, which isn't thread-safe.
+struct ImFontBuildAllocator
+{
+    ImGuiMemAllocFunc   AllocFunc;
+    ImGuiMemFreeFunc    FreeFunc;
+    void*               UserData;
+};
+static inline void* ImFontBuildAlloc(size_t size, void* allocator)  { if (allocator) { ImFontBuildAllocator* a = (ImFontBuildAllocator*)allocator; return a->AllocFunc(size, a->UserData); } return IM_ALLOC(size); }
+static inline void  ImFontBuildFree(void* ptr, void* allocator)     { if (allocator) { ImFontBuildAllocator* a = (ImFontBuildAllocator*)allocator; a->FreeFunc(ptr, a->UserData); } else { IM_FREE(ptr); } }
+#define STBTT_malloc(x,u)   ImFontBuildAlloc(x,u)
+#define STBTT_free(x,u)     ImFontBuildFree(x,u)
 #define STBTT_assert(x)     do { IM_ASSERT(x); } while(0)
 #define STBTT_fmod(x,y)     ImFmod(x,y)
 #define STBTT_sqrt(x)       ImSqrt(x)
@@ -415,6 +425,10 @@ void ImDrawList::_ResetForNewFrame()
     _Splitter.Clear();
     CmdBuffer.push_back(ImDrawCmd());
     _FringeScale = 1.0f;
+    _Deferred.resize(0);
+    _DeferredPoints.resize(0);
+    _DeferredText.resize(0);
+    _DeferredVtxCount = _DeferredIdxCount = 0;
 }
 
 void ImDrawList::_ClearFreeMemory()
@@ -430,10 +444,15 @@ void ImDrawList::_ClearFreeMemory()
     _TextureIdStack.clear();
     _Path.clear();
     _Splitter.ClearFreeMemory();
+    _Deferred.clear();
+    _DeferredPoints.clear();
+    _DeferredText.clear();
+    _DeferredVtxCount = _DeferredIdxCount = 0;
 }
 
 ImDrawList* ImDrawList::CloneOutput() const
 {
+    IM_ASSERT(_Deferred.Size == 0 && "Call _FlushDeferred() first, or clone after ImGui::Render().");
     ImDrawList* dst = IM_NEW(ImDrawList(_Data));
     dst->CmdBuffer = CmdBuffer;
     dst->IdxBuffer = IdxBuffer;
@@ -444,6 +463,7 @@ ImDrawList* ImDrawList::CloneOutput() const
 
 void ImDrawList::AddDrawCmd()
 {
+    _FlushDeferred();
     ImDrawCmd draw_cmd;
     draw_cmd.ClipRect = _CmdHeader.ClipRect;    // Same as calling ImDrawCmd_HeaderCopy()
     draw_cmd.TextureId = _CmdHeader.TextureId;
@@ -458,6 +478,7 @@ void ImDrawList::AddDrawCmd()
 // Note that this leaves the ImDrawList in a state unfit for further commands, as most code assume that CmdBuffer.Size > 0 && CmdBuffer.back().UserCallback == NULL
 void ImDrawList::_PopUnusedDrawCmd()
 {
+    _FlushDeferred();
     if (CmdBuffer.Size == 0)
         return;
     ImDrawCmd* curr_cmd = &CmdBuffer.Data[CmdBuffer.Size - 1];
@@ -467,6 +488,7 @@ void ImDrawList::_PopUnusedDrawCmd()
 
 void ImDrawList::AddCallback(ImDrawCallback callback, void* callback_data)
 {
+    _FlushDeferred();
     ImDrawCmd* curr_cmd = &CmdBuffer.Data[CmdBuffer.Size - 1];
     IM_ASSERT(curr_cmd->UserCallback == NULL);
     if (curr_cmd->ElemCount != 0)
@@ -489,6 +511,13 @@ void ImDrawList::AddCallback(ImDrawCallback callback, void* callback_data)
 // The cost of figuring out if a new command has to be added or if we can merge is paid in those Update** functions only.
 void ImDrawList::_OnChangedClipRect()
 {
+    // With nothing pending, state changes can be applied right away even when deferred
+    if ((Flags & ImDrawListFlags_Deferred) && _Deferred.Size != 0)
+    {
+        _AddDeferredPrim(ImDrawDeferredOp_SetClipRect, 0, 0)->ClipRect = _CmdHeader.ClipRect;
+        return;
+    }
+
     // If current command is used with different settings we need to add a new command
     ImDrawCmd* curr_cmd = &CmdBuffer.Data[CmdBuffer.Size - 1];
     if (curr_cmd->ElemCount != 0 && memcmp(&curr_cmd->ClipRect, &_CmdHeader.ClipRect, sizeof(ImVec4)) != 0)
@@ -511,6 +540,12 @@ void ImDrawList::_OnChangedClipRect()
 
 void ImDrawList::_OnChangedTextureID()
 {
+    if ((Flags & ImDrawListFlags_Deferred) && _Deferred.Size != 0)
+    {
+        _AddDeferredPrim(ImDrawDeferredOp_SetTextureID, 0, 0)->TextureId = _CmdHeader.TextureId;
+        return;
+    }
+
     // If current command is used with different settings we need to add a new command
     ImDrawCmd* curr_cmd = &CmdBuffer.Data[CmdBuffer.Size - 1];
     if (curr_cmd->ElemCount != 0 && curr_cmd->TextureId != _CmdHeader.TextureId)
@@ -556,6 +591,87 @@ int ImDrawList::_CalcCircleAutoSegmentCount(float radius) const
         return IM_DRAWLIST_CIRCLE_AUTO_SEGMENT_CALC(radius, _Data->CircleSegmentMaxError);
 }
 
+// Deferred draw lists (ImDrawListFlags_Deferred, see io.ConfigDeferredDrawLists)
+// - AddPolyline(), AddConvexPolyFilled(), AddText() and non-rounded AddRectFilled() record their arguments instead of tessellating.
+//   Every higher-level primitive that ends up in one of those (AddRect, AddLine, AddCircle, PathStroke...) is recorded with them,
+//   after building its path on the calling thread. Clip rectangle/texture changes are recorded in between.
+// - Anything that needs the buffers (PrimReserve, AddDrawCmd, AddCallback, channels...) replays the recorded primitives first,
+//   so the output is the same as without the flag.
+// - ImGui::Render() replays the remaining ones for all windows, each draw list possibly on a different thread (io.ParallelForFn).
+ImDrawDeferredPrim* ImDrawList::_AddDeferredPrim(int op, int vtx_count, int idx_count)
+{
+    if (_Deferred.Size == 0)
+        _DeferredHeader = _CmdHeader;
+    _Deferred.resize(_Deferred.Size + 1);
+    ImDrawDeferredPrim* prim = &_Deferred.Data[_Deferred.Size - 1];
+    memset(prim, 0, sizeof(*prim));
+    prim->Op = op;
+    prim->Flags = Flags & ~ImDrawListFlags_Deferred;
+    _DeferredVtxCount += vtx_count;
+    _DeferredIdxCount += idx_count;
+    return prim;
+}
+
+// Make room for everything _ReplayDeferred() can output, after which replaying doesn't allocate.
+// This is what allows replaying different draw lists on worker threads: the allocator and its counters aren't thread-safe.
+void ImDrawList::_ReserveDeferred()
+{
+    if (CmdBuffer.Size + _Deferred.Size + 1 > CmdBuffer.Capacity)      // Each recorded primitive adds at most one command
+        CmdBuffer.reserve(CmdBuffer._grow_capacity(CmdBuffer.Size + _Deferred.Size + 1));
+    if (VtxBuffer.Size + _DeferredVtxCount > VtxBuffer.Capacity)
+        VtxBuffer.reserve(VtxBuffer._grow_capacity(VtxBuffer.Size + _DeferredVtxCount));
+    if (IdxBuffer.Size + _DeferredIdxCount > IdxBuffer.Capacity)
+        IdxBuffer.reserve(IdxBuffer._grow_capacity(IdxBuffer.Size + _DeferredIdxCount));
+}
+
+void ImDrawList::_ReplayDeferred()
+{
+    // Recorded primitives are tessellated with the state they were recorded with, restored to the current one afterwards.
+    // The list is swapped out first so the functions we call don't try to flush it again.
+    const ImDrawListFlags backup_flags = Flags;
+    ImVector<ImDrawDeferredPrim> prims;
+    prims.swap(_Deferred);
+    _CmdHeader = _DeferredHeader;
+    for (const ImDrawDeferredPrim* prim = prims.Data; prim < prims.Data + prims.Size; prim++)
+    {
+        Flags = prim->Flags;
+        switch (prim->Op)
+        {
+        case ImDrawDeferredOp_SetClipRect:
+            _CmdHeader.ClipRect = prim->ClipRect;
+            _OnChangedClipRect();
+            break;
+        case ImDrawDeferredOp_SetTextureID:
+            _CmdHeader.TextureId = prim->TextureId;
+            _OnChangedTextureID();
+            break;
+        case ImDrawDeferredOp_RectFilled:
+            PrimReserve(6, 4);
+            PrimRect(ImVec2(prim->ClipRect.x, prim->ClipRect.y), ImVec2(prim->ClipRect.z, prim->ClipRect.w), prim->Col);
+            break;
+        case ImDrawDeferredOp_Polyline:
+            AddPolyline(_DeferredPoints.Data + prim->DataOffset, prim->DataCount, prim->Col, prim->DrawFlags, prim->Size);
+            break;
+        case ImDrawDeferredOp_ConvexPolyFilled:
+            AddConvexPolyFilled(_DeferredPoints.Data + prim->DataOffset, prim->DataCount, prim->Col);
+            break;
+        case ImDrawDeferredOp_Text:
+        case ImDrawDeferredOp_TextClipped:
+        {
+            const char* text_begin = _DeferredText.Data + prim->DataOffset;
+            AddText(prim->Font, prim->Size, prim->Pos, prim->Col, text_begin, text_begin + prim->DataCount, prim->WrapWidth, (prim->Op == ImDrawDeferredOp_TextClipped) ? &prim->ClipRect : NULL);
+            break;
+        }
+        }
+    }
+    Flags = backup_flags;
+    prims.resize(0);
+    _Deferred.swap(prims);
+    _DeferredPoints.resize(0);
+    _DeferredText.resize(0);
+    _DeferredVtxCount = _DeferredIdxCount = 0;
+}
+
 // Render-level scissoring. This is passed down to your render function but not used for CPU-side coarse clipping. Prefer using higher-level ImGui::PushClipRect() to affect logic (hit-testing and widget culling)
 void ImDrawList::PushClipRect(ImVec2 cr_min, ImVec2 cr_max, bool intersect_with_current_clip_rect)
 {
@@ -607,6 +723,9 @@ void ImDrawList::PopTextureID()
 // submit the intermediate results. PrimUnreserve() can be used to release unused allocations.
 void ImDrawList::PrimReserve(int idx_count, int vtx_count)
 {
+    // Primitives recorded before us go first
+    _FlushDeferred();
+
     // Large mesh support (when enabled)
     IM_ASSERT_PARANOID(idx_count >= 0 && vtx_count >= 0);
     if (sizeof(ImDrawIdx) == 2 && (_VtxCurrentIdx + vtx_count >= (1 << 16)) && (Flags & ImDrawListFlags_AllowVtxOffset))
@@ -691,6 +810,194 @@ void ImDrawList::PrimQuadUV(const ImVec2& a, const ImVec2& b, const ImVec2& c, c
 #define IM_NORMALIZE2F_OVER_ZERO(VX,VY)     do { float d2 = VX*VX + VY*VY; if (d2 > 0.0f) { float inv_len = 1.0f / ImSqrt(d2); VX *= inv_len; VY *= inv_len; } } while (0)
 #define IM_FIXNORMAL2F(VX,VY)               do { float d2 = VX*VX + VY*VY; if (d2 < 0.5f) d2 = 0.5f; float inv_lensq = 1.0f / d2; VX *= inv_lensq; VY *= inv_lensq; } while (0)
 
+// AddPolyline() and AddConvexPolyFilled() compute the normals and miter offsets of their points in chunks of IM_DRAWLIST_TESS_CHUNK points,
+// in fixed-size buffers on the stack (instead of alloca()-ing temporary data for the whole path, which a path with 100k points would overflow).
+// Both steps are SIMD kernels processing IM_TESS_WIDTH points at a time (AVX: 8, SSE2 and NEON: 4), with a scalar tail.
+// The kernels do the same IEEE operations as the IM_NORMALIZE2F_OVER_ZERO/IM_FIXNORMAL2F macros (no reciprocal or square root estimates),
+// so their output matches the scalar code bit for bit, unless the compiler contracts the scalar multiply-adds into FMAs (e.g. GCC on AArch64).
+#define IM_DRAWLIST_TESS_CHUNK  256
+
+#if !defined(IMGUI_DISABLE_SIMD_TESSELLATION)
+#if defined(__AVX__)
+#define IM_TESS_USE_AVX
+#include <immintrin.h>      // _mm256_*
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IM_TESS_USE_SSE2
+#include <emmintrin.h>      // _mm_*
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define IM_TESS_USE_NEON    // vdivq_f32() and vsqrtq_f32() only exist on AArch64
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(IM_TESS_USE_AVX)
+#define IM_TESS_WIDTH 8
+typedef __m256 ImTessFloats;
+static inline ImTessFloats  ImTessLoad(const float* p)                  { return _mm256_loadu_ps(p); }
+static inline void          ImTessStore(float* p, ImTessFloats v)       { _mm256_storeu_ps(p, v); }
+static inline ImTessFloats  ImTessSet1(float f)                         { return _mm256_set1_ps(f); }
+static inline ImTessFloats  ImTessAdd(ImTessFloats a, ImTessFloats b)   { return _mm256_add_ps(a, b); }
+static inline ImTessFloats  ImTessSub(ImTessFloats a, ImTessFloats b)   { return _mm256_sub_ps(a, b); }
+static inline ImTessFloats  ImTessMul(ImTessFloats a, ImTessFloats b)   { return _mm256_mul_ps(a, b); }
+static inline ImTessFloats  ImTessDiv(ImTessFloats a, ImTessFloats b)   { return _mm256_div_ps(a, b); }
+static inline ImTessFloats  ImTessSqrt(ImTessFloats a)                  { return _mm256_sqrt_ps(a); }
+static inline ImTessFloats  ImTessNeg(ImTessFloats a)                   { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+static inline ImTessFloats  ImTessMax(ImTessFloats a, ImTessFloats b)   { return _mm256_max_ps(a, b); }                                     // a > b ? a : b
+static inline ImTessFloats  ImTessSelectGT(ImTessFloats a, ImTessFloats b, ImTessFloats v_true, ImTessFloats v_false) { return _mm256_blendv_ps(v_false, v_true, _mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+static inline void          ImTessLoadXY(const ImVec2* p, ImTessFloats* out_x, ImTessFloats* out_y)
+{
+    // Shuffles work within 128-bit lanes: first gather points 0-1 and 4-5 into one register, points 2-3 and 6-7 into the other.
+    const __m256 p0123 = _mm256_loadu_ps(&p[0].x);
+    const __m256 p4567 = _mm256_loadu_ps(&p[4].x);
+    const __m256 p0145 = _mm256_permute2f128_ps(p0123, p4567, 0x20);
+    const __m256 p2367 = _mm256_permute2f128_ps(p0123, p4567, 0x31);
+    *out_x = _mm256_shuffle_ps(p0145, p2367, _MM_SHUFFLE(2, 0, 2, 0));
+    *out_y = _mm256_shuffle_ps(p0145, p2367, _MM_SHUFFLE(3, 1, 3, 1));
+}
+#elif defined(IM_TESS_USE_SSE2)
+#define IM_TESS_WIDTH 4
+typedef __m128 ImTessFloats;
+static inline ImTessFloats  ImTessLoad(const float* p)                  { return _mm_loadu_ps(p); }
+static inline void          ImTessStore(float* p, ImTessFloats v)       { _mm_storeu_ps(p, v); }
+static inline ImTessFloats  ImTessSet1(float f)                         { return _mm_set1_ps(f); }
+static inline ImTessFloats  ImTessAdd(ImTessFloats a, ImTessFloats b)   { return _mm_add_ps(a, b); }
+static inline ImTessFloats  ImTessSub(ImTessFloats a, ImTessFloats b)   { return _mm_sub_ps(a, b); }
+static inline ImTessFloats  ImTessMul(ImTessFloats a, ImTessFloats b)   { return _mm_mul_ps(a, b); }
+static inline ImTessFloats  ImTessDiv(ImTessFloats a, ImTessFloats b)   { return _mm_div_ps(a, b); }
+static inline ImTessFloats  ImTessSqrt(ImTessFloats a)                  { return _mm_sqrt_ps(a); }
+static inline ImTessFloats  ImTessNeg(ImTessFloats a)                   { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+static inline ImTessFloats  ImTessMax(ImTessFloats a, ImTessFloats b)   { return _mm_max_ps(a, b); }                                        // a > b ? a : b
+static inline ImTessFloats  ImTessSelectGT(ImTessFloats a, ImTessFloats b, ImTessFloats v_true, ImTessFloats v_false) { const __m128 m = _mm_cmpgt_ps(a, b); return _mm_or_ps(_mm_and_ps(m, v_true), _mm_andnot_ps(m, v_false)); }
+static inline void          ImTessLoadXY(const ImVec2* p, ImTessFloats* out_x, ImTessFloats* out_y)
+{
+    const __m128 p01 = _mm_loadu_ps(&p[0].x);
+    const __m128 p23 = _mm_loadu_ps(&p[2].x);
+    *out_x = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+    *out_y = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+}
+#elif defined(IM_TESS_USE_NEON)
+#define IM_TESS_WIDTH 4
+typedef float32x4_t ImTessFloats;
+static inline ImTessFloats  ImTessLoad(const float* p)                  { return vld1q_f32(p); }
+static inline void          ImTessStore(float* p, ImTessFloats v)       { vst1q_f32(p, v); }
+static inline ImTessFloats  ImTessSet1(float f)                         { return vdupq_n_f32(f); }
+static inline ImTessFloats  ImTessAdd(ImTessFloats a, ImTessFloats b)   { return vaddq_f32(a, b); }
+static inline ImTessFloats  ImTessSub(ImTessFloats a, ImTessFloats b)   { return vsubq_f32(a, b); }
+static inline ImTessFloats  ImTessMul(ImTessFloats a, ImTessFloats b)   { return vmulq_f32(a, b); }
+static inline ImTessFloats  ImTessDiv(ImTessFloats a, ImTessFloats b)   { return vdivq_f32(a, b); }
+static inline ImTessFloats  ImTessSqrt(ImTessFloats a)                  { return vsqrtq_f32(a); }
+static inline ImTessFloats  ImTessNeg(ImTessFloats a)                   { return vnegq_f32(a); }
+static inline ImTessFloats  ImTessMax(ImTessFloats a, ImTessFloats b)   { return vbslq_f32(vcgtq_f32(a, b), a, b); }                        // a > b ? a : b (vmaxq_f32() differs on NaN)
+static inline ImTessFloats  ImTessSelectGT(ImTessFloats a, ImTessFloats b, ImTessFloats v_true, ImTessFloats v_false) { return vbslq_f32(vcgtq_f32(a, b), v_true, v_false); }
+static inline void          ImTessLoadXY(const ImVec2* p, ImTessFloats* out_x, ImTessFloats* out_y)
+{
+    const float32x4x2_t xy = vld2q_f32(&p[0].x);
+    *out_x = xy.val[0];
+    *out_y = xy.val[1];
+}
+#endif
+
+// Normals of 'count' segments going from p0[i] to p1[i]: 'normalize(p1[i] - p0[i])' rotated by -90 degrees, as in IM_NORMALIZE2F_OVER_ZERO().
+static void ImDrawListTessSegmentNormals(const ImVec2* p0, const ImVec2* p1, int count, float* out_nx, float* out_ny)
+{
+    int i = 0;
+#ifdef IM_TESS_WIDTH
+    const ImTessFloats zero = ImTessSet1(0.0f);
+    const ImTessFloats one = ImTessSet1(1.0f);
+    for (; i + IM_TESS_WIDTH <= count; i += IM_TESS_WIDTH)
+    {
+        ImTessFloats x0, y0, x1, y1;
+        ImTessLoadXY(p0 + i, &x0, &y0);
+        ImTessLoadXY(p1 + i, &x1, &y1);
+        ImTessFloats dx = ImTessSub(x1, x0);
+        ImTessFloats dy = ImTessSub(y1, y0);
+        const ImTessFloats d2 = ImTessAdd(ImTessMul(dx, dx), ImTessMul(dy, dy));
+        const ImTessFloats inv_len = ImTessDiv(one, ImTessSqrt(d2));
+        dx = ImTessSelectGT(d2, zero, ImTessMul(dx, inv_len), dx);
+        dy = ImTessSelectGT(d2, zero, ImTessMul(dy, inv_len), dy);
+        ImTessStore(out_nx + i, dy);
+        ImTessStore(out_ny + i, ImTessNeg(dx));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float dx = p1[i].x - p0[i].x;
+        float dy = p1[i].y - p0[i].y;
+        IM_NORMALIZE2F_OVER_ZERO(dx, dy);
+        out_nx[i] = dy;
+        out_ny[i] = -dx;
+    }
+}
+
+// Miter offsets of 'count' points, each between two segments of normals 'n[i]' and 'n[i + 1]': their average, scaled as in IM_FIXNORMAL2F().
+static void ImDrawListTessAverageNormals(const float* nx, const float* ny, int count, float* out_dx, float* out_dy)
+{
+    int i = 0;
+#ifdef IM_TESS_WIDTH
+    const ImTessFloats half = ImTessSet1(0.5f);
+    const ImTessFloats one = ImTessSet1(1.0f);
+    for (; i + IM_TESS_WIDTH <= count; i += IM_TESS_WIDTH)
+    {
+        const ImTessFloats dm_x = ImTessMul(ImTessAdd(ImTessLoad(nx + i), ImTessLoad(nx + i + 1)), half);
+        const ImTessFloats dm_y = ImTessMul(ImTessAdd(ImTessLoad(ny + i), ImTessLoad(ny + i + 1)), half);
+        const ImTessFloats d2 = ImTessMax(half, ImTessAdd(ImTessMul(dm_x, dm_x), ImTessMul(dm_y, dm_y)));
+        const ImTessFloats inv_lensq = ImTessDiv(one, d2);
+        ImTessStore(out_dx + i, ImTessMul(dm_x, inv_lensq));
+        ImTessStore(out_dy + i, ImTessMul(dm_y, inv_lensq));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float dm_x = (nx[i] + nx[i + 1]) * 0.5f;
+        float dm_y = (ny[i] + ny[i + 1]) * 0.5f;
+        IM_FIXNORMAL2F(dm_x, dm_y);
+        out_dx[i] = dm_x;
+        out_dy[i] = dm_y;
+    }
+}
+
+// Miter offsets of points [first, first + count) of a path, count <= IM_DRAWLIST_TESS_CHUNK. Each is the average of the normals of the segment ending
+// at the point and the segment starting at it. The ends of an open path only have one segment: the first point takes its normal as is, the last point
+// averages it with itself.
+// 'normals_x/y' are scratch buffers of IM_DRAWLIST_TESS_CHUNK + 1 floats, where normals_x[k] gets the normal of segment 'first + k - 1'.
+static void ImDrawListTessMiters(const ImVec2* points, int points_count, bool closed, int first, int count, float* normals_x, float* normals_y, float* out_dx, float* out_dy)
+{
+    IM_ASSERT(count > 0 && count <= IM_DRAWLIST_TESS_CHUNK);
+    const int last_segment = points_count - 1; // Goes from the last point back to the first, only exists for closed paths
+    int k = 0;
+    if (first == 0)
+    {
+        if (closed)
+            ImDrawListTessSegmentNormals(&points[last_segment], &points[0], 1, normals_x, normals_y);
+        k = 1;
+    }
+    const int seg_end = ImMin(first + count - 1, last_segment - 1); // Last segment between two consecutive points
+    if (seg_end >= first + k - 1)
+        ImDrawListTessSegmentNormals(&points[first + k - 1], &points[first + k], seg_end - (first + k - 1) + 1, normals_x + k, normals_y + k);
+    if (first + count == points_count)
+    {
+        if (closed)
+            ImDrawListTessSegmentNormals(&points[last_segment], &points[0], 1, normals_x + count, normals_y + count);
+        else
+        {
+            normals_x[count] = normals_x[count - 1];
+            normals_y[count] = normals_y[count - 1];
+        }
+    }
+    if (first == 0 && !closed)
+    {
+        normals_x[0] = normals_x[1];
+        normals_y[0] = normals_y[1];
+    }
+
+    ImDrawListTessAverageNormals(normals_x, normals_y, count, out_dx, out_dy);
+    if (first == 0 && !closed)
+    {
+        out_dx[0] = normals_x[0];
+        out_dy[0] = normals_y[0];
+    }
+}
+
 // TODO: Thickness anti-aliased lines cap are missing their AA fringe.
 // We avoid using the ImVec2 math operators here to reduce cost to a minimum for debug/non-inlined builds.
 void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32 col, ImDrawFlags flags, float thickness)
@@ -698,11 +1005,29 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
     if (points_count < 2)
         return;
 
+    if (Flags & ImDrawListFlags_Deferred)
+    {
+        // Upper bound: thick anti-aliased lines use 4 vertices and 18 indices per point
+        ImDrawDeferredPrim* prim = _AddDeferredPrim(ImDrawDeferredOp_Polyline, points_count * 4, points_count * 18);
+        prim->Col = col;
+        prim->DrawFlags = flags;
+        prim->Size = thickness;
+        prim->DataOffset = _DeferredPoints.Size;
+        prim->DataCount = points_count;
+        _DeferredPoints.resize(_DeferredPoints.Size + points_count);
+        memcpy(_DeferredPoints.Data + prim->DataOffset, points, (size_t)points_count * sizeof(ImVec2));
+        return;
+    }
+
     const bool closed = (flags & ImDrawFlags_Closed) != 0;
     const ImVec2 opaque_uv = _Data->TexUvWhitePixel;
     const int count = closed ? points_count : points_count - 1; // The number of line segments we need to draw
     const bool thick_line = (thickness > _FringeScale);
 
+    // Scratch buffers for ImDrawListTessMiters()/ImDrawListTessSegmentNormals(), filled IM_DRAWLIST_TESS_CHUNK points at a time
+    float normals_x[IM_DRAWLIST_TESS_CHUNK + 1];
+    float normals_y[IM_DRAWLIST_TESS_CHUNK + 1];
+
     if (Flags & ImDrawListFlags_AntiAliasedLines)
     {
         // Anti-aliased stroke
@@ -726,191 +1051,111 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
         const int vtx_count = use_texture ? (points_count * 2) : (thick_line ? points_count * 4 : points_count * 3);
         PrimReserve(idx_count, vtx_count);
 
-        // Temporary buffer
-        // The first <points_count> items are normals at each line point, then after that there are either 2 or 4 temp points for each line point
-        ImVec2* temp_normals = (ImVec2*)alloca(points_count * ((use_texture || !thick_line) ? 3 : 5) * sizeof(ImVec2)); //-V630
-        ImVec2* temp_points = temp_normals + points_count;
-
-        // Calculate normals (tangents) for each line segment
-        for (int i1 = 0; i1 < count; i1++)
+        // Generate the indices to form a number of triangles for each line segment
+        // This joins the vertices of points n and n+1, with the last segment of a closed line joining the final point back to the first one (as n+1 wraps)
+        const unsigned int vtx_per_point = use_texture ? 2 : (thick_line ? 4 : 3);
+        unsigned int idx1 = _VtxCurrentIdx; // Vertex index for start of line segment
+        for (int i1 = 0; i1 < count; i1++) // i1 is the first point of the line segment
         {
-            const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1;
-            float dx = points[i2].x - points[i1].x;
-            float dy = points[i2].y - points[i1].y;
-            IM_NORMALIZE2F_OVER_ZERO(dx, dy);
-            temp_normals[i1].x = dy;
-            temp_normals[i1].y = -dx;
-        }
-        if (!closed)
-            temp_normals[points_count - 1] = temp_normals[points_count - 2];
-
-        // If we are drawing a one-pixel-wide line without a texture, or a textured line of any width, we only need 2 or 3 vertices per point
-        if (use_texture || !thick_line)
-        {
-            // [PATH 1] Texture-based lines (thick or non-thick)
-            // [PATH 2] Non texture-based lines (non-thick)
-
-            // The width of the geometry we need to draw - this is essentially <thickness> pixels for the line itself, plus "one pixel" for AA.
-            // - In the texture-based path, we don't use AA_SIZE here because the +1 is tied to the generated texture
-            //   (see ImFontAtlasBuildRenderLinesTexData() function), and so alternate values won't work without changes to that code.
-            // - In the non texture-based paths, we would allow AA_SIZE to potentially be != 1.0f with a patch (e.g. fringe_scale patch to
-            //   allow scaling geometry while preserving one-screen-pixel AA fringe).
-            const float half_draw_size = use_texture ? ((thickness * 0.5f) + 1) : AA_SIZE;
-
-            // If line is not closed, the first and last points need to be generated differently as there are no normals to blend
-            if (!closed)
+            const unsigned int idx2 = ((i1 + 1) == points_count) ? _VtxCurrentIdx : (idx1 + vtx_per_point); // Vertex index for end of segment
+            if (use_texture)
             {
-                temp_points[0] = points[0] + temp_normals[0] * half_draw_size;
-                temp_points[1] = points[0] - temp_normals[0] * half_draw_size;
-                temp_points[(points_count-1)*2+0] = points[points_count-1] + temp_normals[points_count-1] * half_draw_size;
-                temp_points[(points_count-1)*2+1] = points[points_count-1] - temp_normals[points_count-1] * half_draw_size;
+                // Add indices for two triangles
+                _IdxWritePtr[0] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[1] = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[2] = (ImDrawIdx)(idx1 + 1); // Right tri
+                _IdxWritePtr[3] = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[4] = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[5] = (ImDrawIdx)(idx2 + 0); // Left tri
+                _IdxWritePtr += 6;
             }
-
-            // Generate the indices to form a number of triangles for each line segment, and the vertices for the line edges
-            // This takes points n and n+1 and writes into n+1, with the first point in a closed line being generated from the final one (as n+1 wraps)
-            // FIXME-OPT: Merge the different loops, possibly remove the temporary buffer.
-            unsigned int idx1 = _VtxCurrentIdx; // Vertex index for start of line segment
-            for (int i1 = 0; i1 < count; i1++) // i1 is the first point of the line segment
+            else if (!thick_line)
             {
-                const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1; // i2 is the second point of the line segment
-                const unsigned int idx2 = ((i1 + 1) == points_count) ? _VtxCurrentIdx : (idx1 + (use_texture ? 2 : 3)); // Vertex index for end of segment
-
-                // Average normals
-                float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
-                float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
-                IM_FIXNORMAL2F(dm_x, dm_y);
-                dm_x *= half_draw_size; // dm_x, dm_y are offset to the outer edge of the AA area
-                dm_y *= half_draw_size;
-
-                // Add temporary vertexes for the outer edges
-                ImVec2* out_vtx = &temp_points[i2 * 2];
-                out_vtx[0].x = points[i2].x + dm_x;
-                out_vtx[0].y = points[i2].y + dm_y;
-                out_vtx[1].x = points[i2].x - dm_x;
-                out_vtx[1].y = points[i2].y - dm_y;
-
-                if (use_texture)
-                {
-                    // Add indices for two triangles
-                    _IdxWritePtr[0] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[1] = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[2] = (ImDrawIdx)(idx1 + 1); // Right tri
-                    _IdxWritePtr[3] = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[4] = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[5] = (ImDrawIdx)(idx2 + 0); // Left tri
-                    _IdxWritePtr += 6;
-                }
-                else
-                {
-                    // Add indexes for four triangles
-                    _IdxWritePtr[0] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[1] = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[2] = (ImDrawIdx)(idx1 + 2); // Right tri 1
-                    _IdxWritePtr[3] = (ImDrawIdx)(idx1 + 2); _IdxWritePtr[4] = (ImDrawIdx)(idx2 + 2); _IdxWritePtr[5] = (ImDrawIdx)(idx2 + 0); // Right tri 2
-                    _IdxWritePtr[6] = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[7] = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[8] = (ImDrawIdx)(idx1 + 0); // Left tri 1
-                    _IdxWritePtr[9] = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[10] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[11] = (ImDrawIdx)(idx2 + 1); // Left tri 2
-                    _IdxWritePtr += 12;
-                }
-
-                idx1 = idx2;
+                // Add indexes for four triangles
+                _IdxWritePtr[0] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[1] = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[2] = (ImDrawIdx)(idx1 + 2); // Right tri 1
+                _IdxWritePtr[3] = (ImDrawIdx)(idx1 + 2); _IdxWritePtr[4] = (ImDrawIdx)(idx2 + 2); _IdxWritePtr[5] = (ImDrawIdx)(idx2 + 0); // Right tri 2
+                _IdxWritePtr[6] = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[7] = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[8] = (ImDrawIdx)(idx1 + 0); // Left tri 1
+                _IdxWritePtr[9] = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[10] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[11] = (ImDrawIdx)(idx2 + 1); // Left tri 2
+                _IdxWritePtr += 12;
+            }
+            else
+            {
+                // Add indexes for six triangles
+                _IdxWritePtr[0]  = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[1]  = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[2]  = (ImDrawIdx)(idx1 + 2);
+                _IdxWritePtr[3]  = (ImDrawIdx)(idx1 + 2); _IdxWritePtr[4]  = (ImDrawIdx)(idx2 + 2); _IdxWritePtr[5]  = (ImDrawIdx)(idx2 + 1);
+                _IdxWritePtr[6]  = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[7]  = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[8]  = (ImDrawIdx)(idx1 + 0);
+                _IdxWritePtr[9]  = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[10] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[11] = (ImDrawIdx)(idx2 + 1);
+                _IdxWritePtr[12] = (ImDrawIdx)(idx2 + 2); _IdxWritePtr[13] = (ImDrawIdx)(idx1 + 2); _IdxWritePtr[14] = (ImDrawIdx)(idx1 + 3);
+                _IdxWritePtr[15] = (ImDrawIdx)(idx1 + 3); _IdxWritePtr[16] = (ImDrawIdx)(idx2 + 3); _IdxWritePtr[17] = (ImDrawIdx)(idx2 + 2);
+                _IdxWritePtr += 18;
             }
+            idx1 = idx2;
+        }
 
-            // Add vertexes for each point on the line
+        // The width of the geometry we need to draw - this is essentially <thickness> pixels for the line itself, plus "one pixel" for AA.
+        // - In the texture-based path, we don't use AA_SIZE here because the +1 is tied to the generated texture
+        //   (see ImFontAtlasBuildRenderLinesTexData() function), and so alternate values won't work without changes to that code.
+        // - In the non texture-based paths, we would allow AA_SIZE to potentially be != 1.0f with a patch (e.g. fringe_scale patch to
+        //   allow scaling geometry while preserving one-screen-pixel AA fringe).
+        const float half_draw_size = use_texture ? ((thickness * 0.5f) + 1) : AA_SIZE;
+        const float half_inner_thickness = (thickness - AA_SIZE) * 0.5f;
+        const float half_outer_thickness = half_inner_thickness + AA_SIZE;
+        ImVec4 tex_uvs = _Data->TexUvLines[use_texture ? integer_thickness : 0];
+        /*if (fractional_thickness != 0.0f) // Currently always zero when use_texture==false!
+        {
+            const ImVec4 tex_uvs_1 = _Data->TexUvLines[integer_thickness + 1];
+            tex_uvs.x = tex_uvs.x + (tex_uvs_1.x - tex_uvs.x) * fractional_thickness; // inlined ImLerp()
+            tex_uvs.y = tex_uvs.y + (tex_uvs_1.y - tex_uvs.y) * fractional_thickness;
+            tex_uvs.z = tex_uvs.z + (tex_uvs_1.z - tex_uvs.z) * fractional_thickness;
+            tex_uvs.w = tex_uvs.w + (tex_uvs_1.w - tex_uvs.w) * fractional_thickness;
+        }*/
+        const ImVec2 tex_uv0(tex_uvs.x, tex_uvs.y);
+        const ImVec2 tex_uv1(tex_uvs.z, tex_uvs.w);
+
+        // Add vertices for each point on the line, offset along its miter (dm_x, dm_y)
+        float dm_x[IM_DRAWLIST_TESS_CHUNK];
+        float dm_y[IM_DRAWLIST_TESS_CHUNK];
+        for (int first = 0; first < points_count; first += IM_DRAWLIST_TESS_CHUNK)
+        {
+            const int chunk_count = ImMin(points_count - first, IM_DRAWLIST_TESS_CHUNK);
+            ImDrawListTessMiters(points, points_count, closed, first, chunk_count, normals_x, normals_y, dm_x, dm_y);
+            const ImVec2* p = points + first;
             if (use_texture)
             {
-                // If we're using textures we only need to emit the left/right edge vertices
-                ImVec4 tex_uvs = _Data->TexUvLines[integer_thickness];
-                /*if (fractional_thickness != 0.0f) // Currently always zero when use_texture==false!
+                // [PATH 1] Texture-based lines (thick or non-thick): we only need to emit the left/right edge vertices
+                for (int i = 0; i < chunk_count; i++)
                 {
-                    const ImVec4 tex_uvs_1 = _Data->TexUvLines[integer_thickness + 1];
-                    tex_uvs.x = tex_uvs.x + (tex_uvs_1.x - tex_uvs.x) * fractional_thickness; // inlined ImLerp()
-                    tex_uvs.y = tex_uvs.y + (tex_uvs_1.y - tex_uvs.y) * fractional_thickness;
-                    tex_uvs.z = tex_uvs.z + (tex_uvs_1.z - tex_uvs.z) * fractional_thickness;
-                    tex_uvs.w = tex_uvs.w + (tex_uvs_1.w - tex_uvs.w) * fractional_thickness;
-                }*/
-                ImVec2 tex_uv0(tex_uvs.x, tex_uvs.y);
-                ImVec2 tex_uv1(tex_uvs.z, tex_uvs.w);
-                for (int i = 0; i < points_count; i++)
-                {
-                    _VtxWritePtr[0].pos = temp_points[i * 2 + 0]; _VtxWritePtr[0].uv = tex_uv0; _VtxWritePtr[0].col = col; // Left-side outer edge
-                    _VtxWritePtr[1].pos = temp_points[i * 2 + 1]; _VtxWritePtr[1].uv = tex_uv1; _VtxWritePtr[1].col = col; // Right-side outer edge
+                    const float d_x = dm_x[i] * half_draw_size;
+                    const float d_y = dm_y[i] * half_draw_size;
+                    _VtxWritePtr[0].pos.x = p[i].x + d_x; _VtxWritePtr[0].pos.y = p[i].y + d_y; _VtxWritePtr[0].uv = tex_uv0; _VtxWritePtr[0].col = col; // Left-side outer edge
+                    _VtxWritePtr[1].pos.x = p[i].x - d_x; _VtxWritePtr[1].pos.y = p[i].y - d_y; _VtxWritePtr[1].uv = tex_uv1; _VtxWritePtr[1].col = col; // Right-side outer edge
                     _VtxWritePtr += 2;
                 }
             }
-            else
+            else if (!thick_line)
             {
-                // If we're not using a texture, we need the center vertex as well
-                for (int i = 0; i < points_count; i++)
+                // [PATH 2] Non texture-based lines (non-thick): we need the center vertex as well
+                for (int i = 0; i < chunk_count; i++)
                 {
-                    _VtxWritePtr[0].pos = points[i];              _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col;       // Center of line
-                    _VtxWritePtr[1].pos = temp_points[i * 2 + 0]; _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col_trans; // Left-side outer edge
-                    _VtxWritePtr[2].pos = temp_points[i * 2 + 1]; _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col_trans; // Right-side outer edge
+                    const float d_x = dm_x[i] * half_draw_size;
+                    const float d_y = dm_y[i] * half_draw_size;
+                    _VtxWritePtr[0].pos = p[i];                                         _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col;       // Center of line
+                    _VtxWritePtr[1].pos.x = p[i].x + d_x; _VtxWritePtr[1].pos.y = p[i].y + d_y; _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col_trans; // Left-side outer edge
+                    _VtxWritePtr[2].pos.x = p[i].x - d_x; _VtxWritePtr[2].pos.y = p[i].y - d_y; _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col_trans; // Right-side outer edge
                     _VtxWritePtr += 3;
                 }
             }
-        }
-        else
-        {
-            // [PATH 2] Non texture-based lines (thick): we need to draw the solid line core and thus require four vertices per point
-            const float half_inner_thickness = (thickness - AA_SIZE) * 0.5f;
-
-            // If line is not closed, the first and last points need to be generated differently as there are no normals to blend
-            if (!closed)
-            {
-                const int points_last = points_count - 1;
-                temp_points[0] = points[0] + temp_normals[0] * (half_inner_thickness + AA_SIZE);
-                temp_points[1] = points[0] + temp_normals[0] * (half_inner_thickness);
-                temp_points[2] = points[0] - temp_normals[0] * (half_inner_thickness);
-                temp_points[3] = points[0] - temp_normals[0] * (half_inner_thickness + AA_SIZE);
-                temp_points[points_last * 4 + 0] = points[points_last] + temp_normals[points_last] * (half_inner_thickness + AA_SIZE);
-                temp_points[points_last * 4 + 1] = points[points_last] + temp_normals[points_last] * (half_inner_thickness);
-                temp_points[points_last * 4 + 2] = points[points_last] - temp_normals[points_last] * (half_inner_thickness);
-                temp_points[points_last * 4 + 3] = points[points_last] - temp_normals[points_last] * (half_inner_thickness + AA_SIZE);
-            }
-
-            // Generate the indices to form a number of triangles for each line segment, and the vertices for the line edges
-            // This takes points n and n+1 and writes into n+1, with the first point in a closed line being generated from the final one (as n+1 wraps)
-            // FIXME-OPT: Merge the different loops, possibly remove the temporary buffer.
-            unsigned int idx1 = _VtxCurrentIdx; // Vertex index for start of line segment
-            for (int i1 = 0; i1 < count; i1++) // i1 is the first point of the line segment
-            {
-                const int i2 = (i1 + 1) == points_count ? 0 : (i1 + 1); // i2 is the second point of the line segment
-                const unsigned int idx2 = (i1 + 1) == points_count ? _VtxCurrentIdx : (idx1 + 4); // Vertex index for end of segment
-
-                // Average normals
-                float dm_x = (temp_normals[i1].x + temp_normals[i2].x) * 0.5f;
-                float dm_y = (temp_normals[i1].y + temp_normals[i2].y) * 0.5f;
-                IM_FIXNORMAL2F(dm_x, dm_y);
-                float dm_out_x = dm_x * (half_inner_thickness + AA_SIZE);
-                float dm_out_y = dm_y * (half_inner_thickness + AA_SIZE);
-                float dm_in_x = dm_x * half_inner_thickness;
-                float dm_in_y = dm_y * half_inner_thickness;
-
-                // Add temporary vertices
-                ImVec2* out_vtx = &temp_points[i2 * 4];
-                out_vtx[0].x = points[i2].x + dm_out_x;
-                out_vtx[0].y = points[i2].y + dm_out_y;
-                out_vtx[1].x = points[i2].x + dm_in_x;
-                out_vtx[1].y = points[i2].y + dm_in_y;
-                out_vtx[2].x = points[i2].x - dm_in_x;
-                out_vtx[2].y = points[i2].y - dm_in_y;
-                out_vtx[3].x = points[i2].x - dm_out_x;
-                out_vtx[3].y = points[i2].y - dm_out_y;
-
-                // Add indexes
-                _IdxWritePtr[0]  = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[1]  = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[2]  = (ImDrawIdx)(idx1 + 2);
-                _IdxWritePtr[3]  = (ImDrawIdx)(idx1 + 2); _IdxWritePtr[4]  = (ImDrawIdx)(idx2 + 2); _IdxWritePtr[5]  = (ImDrawIdx)(idx2 + 1);
-                _IdxWritePtr[6]  = (ImDrawIdx)(idx2 + 1); _IdxWritePtr[7]  = (ImDrawIdx)(idx1 + 1); _IdxWritePtr[8]  = (ImDrawIdx)(idx1 + 0);
-                _IdxWritePtr[9]  = (ImDrawIdx)(idx1 + 0); _IdxWritePtr[10] = (ImDrawIdx)(idx2 + 0); _IdxWritePtr[11] = (ImDrawIdx)(idx2 + 1);
-                _IdxWritePtr[12] = (ImDrawIdx)(idx2 + 2); _IdxWritePtr[13] = (ImDrawIdx)(idx1 + 2); _IdxWritePtr[14] = (ImDrawIdx)(idx1 + 3);
-                _IdxWritePtr[15] = (ImDrawIdx)(idx1 + 3); _IdxWritePtr[16] = (ImDrawIdx)(idx2 + 3); _IdxWritePtr[17] = (ImDrawIdx)(idx2 + 2);
-                _IdxWritePtr += 18;
-
-                idx1 = idx2;
-            }
-
-            // Add vertices
-            for (int i = 0; i < points_count; i++)
+            else
             {
-                _VtxWritePtr[0].pos = temp_points[i * 4 + 0]; _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col_trans;
-                _VtxWritePtr[1].pos = temp_points[i * 4 + 1]; _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col;
-                _VtxWritePtr[2].pos = temp_points[i * 4 + 2]; _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col;
-                _VtxWritePtr[3].pos = temp_points[i * 4 + 3]; _VtxWritePtr[3].uv = opaque_uv; _VtxWritePtr[3].col = col_trans;
-                _VtxWritePtr += 4;
+                // [PATH 2] Non texture-based lines (thick): we need to draw the solid line core and thus require four vertices per point
+                for (int i = 0; i < chunk_count; i++)
+                {
+                    const float dm_out_x = dm_x[i] * half_outer_thickness;
+                    const float dm_out_y = dm_y[i] * half_outer_thickness;
+                    const float dm_in_x = dm_x[i] * half_inner_thickness;
+                    const float dm_in_y = dm_y[i] * half_inner_thickness;
+                    _VtxWritePtr[0].pos.x = p[i].x + dm_out_x; _VtxWritePtr[0].pos.y = p[i].y + dm_out_y; _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col_trans;
+                    _VtxWritePtr[1].pos.x = p[i].x + dm_in_x;  _VtxWritePtr[1].pos.y = p[i].y + dm_in_y;  _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col;
+                    _VtxWritePtr[2].pos.x = p[i].x - dm_in_x;  _VtxWritePtr[2].pos.y = p[i].y - dm_in_y;  _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col;
+                    _VtxWritePtr[3].pos.x = p[i].x - dm_out_x; _VtxWritePtr[3].pos.y = p[i].y - dm_out_y; _VtxWritePtr[3].uv = opaque_uv; _VtxWritePtr[3].col = col_trans;
+                    _VtxWritePtr += 4;
+                }
             }
         }
         _VtxCurrentIdx += (ImDrawIdx)vtx_count;
@@ -922,28 +1167,36 @@ void ImDrawList::AddPolyline(const ImVec2* points, const int points_count, ImU32
         const int vtx_count = count * 4;    // FIXME-OPT: Not sharing edges
         PrimReserve(idx_count, vtx_count);
 
-        for (int i1 = 0; i1 < count; i1++)
+        const float half_thickness = thickness * 0.5f;
+        for (int first = 0; first < count; first += IM_DRAWLIST_TESS_CHUNK)
         {
-            const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1;
-            const ImVec2& p1 = points[i1];
-            const ImVec2& p2 = points[i2];
-
-            float dx = p2.x - p1.x;
-            float dy = p2.y - p1.y;
-            IM_NORMALIZE2F_OVER_ZERO(dx, dy);
-            dx *= (thickness * 0.5f);
-            dy *= (thickness * 0.5f);
-
-            _VtxWritePtr[0].pos.x = p1.x + dy; _VtxWritePtr[0].pos.y = p1.y - dx; _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col;
-            _VtxWritePtr[1].pos.x = p2.x + dy; _VtxWritePtr[1].pos.y = p2.y - dx; _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col;
-            _VtxWritePtr[2].pos.x = p2.x - dy; _VtxWritePtr[2].pos.y = p2.y + dx; _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col;
-            _VtxWritePtr[3].pos.x = p1.x - dy; _VtxWritePtr[3].pos.y = p1.y + dx; _VtxWritePtr[3].uv = opaque_uv; _VtxWritePtr[3].col = col;
-            _VtxWritePtr += 4;
-
-            _IdxWritePtr[0] = (ImDrawIdx)(_VtxCurrentIdx); _IdxWritePtr[1] = (ImDrawIdx)(_VtxCurrentIdx + 1); _IdxWritePtr[2] = (ImDrawIdx)(_VtxCurrentIdx + 2);
-            _IdxWritePtr[3] = (ImDrawIdx)(_VtxCurrentIdx); _IdxWritePtr[4] = (ImDrawIdx)(_VtxCurrentIdx + 2); _IdxWritePtr[5] = (ImDrawIdx)(_VtxCurrentIdx + 3);
-            _IdxWritePtr += 6;
-            _VtxCurrentIdx += 4;
+            // Segment i1 goes from points[i1] to points[i2], i2 wrapping back to the first point for the last segment of a closed line
+            const int chunk_count = ImMin(count - first, IM_DRAWLIST_TESS_CHUNK);
+            const int linked_count = ImMin(chunk_count, points_count - 1 - first);
+            ImDrawListTessSegmentNormals(&points[first], &points[first + 1], linked_count, normals_x, normals_y);
+            if (linked_count < chunk_count)
+                ImDrawListTessSegmentNormals(&points[points_count - 1], &points[0], 1, normals_x + linked_count, normals_y + linked_count);
+
+            for (int i = 0; i < chunk_count; i++)
+            {
+                const int i1 = first + i;
+                const int i2 = (i1 + 1) == points_count ? 0 : i1 + 1;
+                const ImVec2& p1 = points[i1];
+                const ImVec2& p2 = points[i2];
+                const float dx = -normals_y[i] * half_thickness;
+                const float dy = normals_x[i] * half_thickness;
+
+                _VtxWritePtr[0].pos.x = p1.x + dy; _VtxWritePtr[0].pos.y = p1.y - dx; _VtxWritePtr[0].uv = opaque_uv; _VtxWritePtr[0].col = col;
+                _VtxWritePtr[1].pos.x = p2.x + dy; _VtxWritePtr[1].pos.y = p2.y - dx; _VtxWritePtr[1].uv = opaque_uv; _VtxWritePtr[1].col = col;
+                _VtxWritePtr[2].pos.x = p2.x - dy; _VtxWritePtr[2].pos.y = p2.y + dx; _VtxWritePtr[2].uv = opaque_uv; _VtxWritePtr[2].col = col;
+                _VtxWritePtr[3].pos.x = p1.x - dy; _VtxWritePtr[3].pos.y = p1.y + dx; _VtxWritePtr[3].uv = opaque_uv; _VtxWritePtr[3].col = col;
+                _VtxWritePtr += 4;
+
+                _IdxWritePtr[0] = (ImDrawIdx)(_VtxCurrentIdx); _IdxWritePtr[1] = (ImDrawIdx)(_VtxCurrentIdx + 1); _IdxWritePtr[2] = (ImDrawIdx)(_VtxCurrentIdx + 2);
+                _IdxWritePtr[3] = (ImDrawIdx)(_VtxCurrentIdx); _IdxWritePtr[4] = (ImDrawIdx)(_VtxCurrentIdx + 2); _IdxWritePtr[5] = (ImDrawIdx)(_VtxCurrentIdx + 3);
+                _IdxWritePtr += 6;
+                _VtxCurrentIdx += 4;
+            }
         }
     }
 }
@@ -954,6 +1207,18 @@ void ImDrawList::AddConvexPolyFilled(const ImVec2* points, const int points_coun
     if (points_count < 3)
         return;
 
+    if (Flags & ImDrawListFlags_Deferred)
+    {
+        // Upper bound: anti-aliased fill uses 2 vertices and 9 indices per point
+        ImDrawDeferredPrim* prim = _AddDeferredPrim(ImDrawDeferredOp_ConvexPolyFilled, points_count * 2, points_count * 9);
+        prim->Col = col;
+        prim->DataOffset = _DeferredPoints.Size;
+        prim->DataCount = points_count;
+        _DeferredPoints.resize(_DeferredPoints.Size + points_count);
+        memcpy(_DeferredPoints.Data + prim->DataOffset, points, (size_t)points_count * sizeof(ImVec2));
+        return;
+    }
+
     const ImVec2 uv = _Data->TexUvWhitePixel;
 
     if (Flags & ImDrawListFlags_AntiAliasedFill)
@@ -974,40 +1239,34 @@ void ImDrawList::AddConvexPolyFilled(const ImVec2* points, const int points_coun
             _IdxWritePtr += 3;
         }
 
-        // Compute normals
-        ImVec2* temp_normals = (ImVec2*)alloca(points_count * sizeof(ImVec2)); //-V630
+        // Add indexes for fringes
         for (int i0 = points_count - 1, i1 = 0; i1 < points_count; i0 = i1++)
         {
-            const ImVec2& p0 = points[i0];
-            const ImVec2& p1 = points[i1];
-            float dx = p1.x - p0.x;
-            float dy = p1.y - p0.y;
-            IM_NORMALIZE2F_OVER_ZERO(dx, dy);
-            temp_normals[i0].x = dy;
-            temp_normals[i0].y = -dx;
-        }
-
-        for (int i0 = points_count - 1, i1 = 0; i1 < points_count; i0 = i1++)
-        {
-            // Average normals
-            const ImVec2& n0 = temp_normals[i0];
-            const ImVec2& n1 = temp_normals[i1];
-            float dm_x = (n0.x + n1.x) * 0.5f;
-            float dm_y = (n0.y + n1.y) * 0.5f;
-            IM_FIXNORMAL2F(dm_x, dm_y);
-            dm_x *= AA_SIZE * 0.5f;
-            dm_y *= AA_SIZE * 0.5f;
-
-            // Add vertices
-            _VtxWritePtr[0].pos.x = (points[i1].x - dm_x); _VtxWritePtr[0].pos.y = (points[i1].y - dm_y); _VtxWritePtr[0].uv = uv; _VtxWritePtr[0].col = col;        // Inner
-            _VtxWritePtr[1].pos.x = (points[i1].x + dm_x); _VtxWritePtr[1].pos.y = (points[i1].y + dm_y); _VtxWritePtr[1].uv = uv; _VtxWritePtr[1].col = col_trans;  // Outer
-            _VtxWritePtr += 2;
-
-            // Add indexes for fringes
             _IdxWritePtr[0] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1)); _IdxWritePtr[1] = (ImDrawIdx)(vtx_inner_idx + (i0 << 1)); _IdxWritePtr[2] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1));
             _IdxWritePtr[3] = (ImDrawIdx)(vtx_outer_idx + (i0 << 1)); _IdxWritePtr[4] = (ImDrawIdx)(vtx_outer_idx + (i1 << 1)); _IdxWritePtr[5] = (ImDrawIdx)(vtx_inner_idx + (i1 << 1));
             _IdxWritePtr += 6;
         }
+
+        // Add vertices, offset along the average of the normals of each point's two edges
+        const float half_aa_size = AA_SIZE * 0.5f;
+        float normals_x[IM_DRAWLIST_TESS_CHUNK + 1];
+        float normals_y[IM_DRAWLIST_TESS_CHUNK + 1];
+        float dm_x[IM_DRAWLIST_TESS_CHUNK];
+        float dm_y[IM_DRAWLIST_TESS_CHUNK];
+        for (int first = 0; first < points_count; first += IM_DRAWLIST_TESS_CHUNK)
+        {
+            const int chunk_count = ImMin(points_count - first, IM_DRAWLIST_TESS_CHUNK);
+            ImDrawListTessMiters(points, points_count, true, first, chunk_count, normals_x, normals_y, dm_x, dm_y);
+            const ImVec2* p = points + first;
+            for (int i = 0; i < chunk_count; i++)
+            {
+                const float d_x = dm_x[i] * half_aa_size;
+                const float d_y = dm_y[i] * half_aa_size;
+                _VtxWritePtr[0].pos.x = (p[i].x - d_x); _VtxWritePtr[0].pos.y = (p[i].y - d_y); _VtxWritePtr[0].uv = uv; _VtxWritePtr[0].col = col;        // Inner
+                _VtxWritePtr[1].pos.x = (p[i].x + d_x); _VtxWritePtr[1].pos.y = (p[i].y + d_y); _VtxWritePtr[1].uv = uv; _VtxWritePtr[1].col = col_trans;  // Outer
+                _VtxWritePtr += 2;
+            }
+        }
         _VtxCurrentIdx += (ImDrawIdx)vtx_count;
     }
     else
@@ -1367,6 +1626,13 @@ void ImDrawList::AddRectFilled(const ImVec2& p_min, const ImVec2& p_max, ImU32 c
         return;
     if (rounding <= 0.0f || (flags & ImDrawFlags_RoundCornersMask_) == ImDrawFlags_RoundCornersNone)
     {
+        if (Flags & ImDrawListFlags_Deferred)
+        {
+            ImDrawDeferredPrim* prim = _AddDeferredPrim(ImDrawDeferredOp_RectFilled, 4, 6);
+            prim->ClipRect = ImVec4(p_min.x, p_min.y, p_max.x, p_max.y);
+            prim->Col = col;
+            return;
+        }
         PrimReserve(6, 4);
         PrimRect(p_min, p_max, col);
     }
@@ -1555,6 +1821,25 @@ void ImDrawList::AddText(const ImFont* font, float font_size, const ImVec2& pos,
 
     IM_ASSERT(font->ContainerAtlas->TexID == _CmdHeader.TextureId);  // Use high-level ImGui::PushFont() or low-level ImDrawList::PushTextureId() to change font.
 
+    if (Flags & ImDrawListFlags_Deferred)
+    {
+        // Same upper bound as ImFont::RenderText() reserves
+        const int text_len = (int)(text_end - text_begin);
+        ImDrawDeferredPrim* prim = _AddDeferredPrim(cpu_fine_clip_rect ? ImDrawDeferredOp_TextClipped : ImDrawDeferredOp_Text, text_len * 4, text_len * 6);
+        prim->Col = col;
+        prim->Pos = pos;
+        prim->Size = font_size;
+        prim->WrapWidth = wrap_width;
+        prim->Font = font;
+        if (cpu_fine_clip_rect)
+            prim->ClipRect = *cpu_fine_clip_rect;
+        prim->DataOffset = _DeferredText.Size;
+        prim->DataCount = text_len;
+        _DeferredText.resize(_DeferredText.Size + text_len);
+        memcpy(_DeferredText.Data + prim->DataOffset, text_begin, (size_t)text_len);
+        return;
+    }
+
     ImVec4 clip_rect = _CmdHeader.ClipRect;
     if (cpu_fine_clip_rect)
     {
@@ -1619,10 +1904,15 @@ void ImDrawList::AddImageRounded(ImTextureID user_texture_id, const ImVec2& p_mi
     if (push_texture_id)
         PushTextureID(user_texture_id);
 
+    // The vertices are shaded right away, so they can't be deferred
+    const ImDrawListFlags backup_flags = Flags;
+    _FlushDeferred();
+    Flags &= ~ImDrawListFlags_Deferred;
     int vert_start_idx = VtxBuffer.Size;
     PathRect(p_min, p_max, rounding, flags);
     PathFillConvex(col);
     int vert_end_idx = VtxBuffer.Size;
+    Flags = backup_flags;
     ImGui::ShadeVertsLinearUV(this, vert_start_idx, vert_end_idx, p_min, p_max, uv_min, uv_max, true);
 
     if (push_texture_id)
@@ -1686,6 +1976,7 @@ void ImDrawListSplitter::Merge(ImDrawList* draw_list)
     if (_Count <= 1)
         return;
 
+    draw_list->_FlushDeferred();
     SetCurrentChannel(draw_list, 0);
     draw_list->_PopUnusedDrawCmd();
 
@@ -1756,6 +2047,7 @@ void ImDrawListSplitter::SetCurrentChannel(ImDrawList* draw_list, int idx)
     IM_ASSERT(idx >= 0 && idx < _Count);
     if (_Current == idx)
         return;
+    draw_list->_FlushDeferred();
 
     // Overwrite ImVector (12/16 bytes), four times. This is merely a silly optimization instead of doing .swap()
     memcpy(&_Channels.Data[_Current]._CmdBuffer, &draw_list->CmdBuffer, sizeof(draw_list->CmdBuffer));
@@ -1814,6 +2106,162 @@ void ImDrawData::ScaleClipRects(const ImVec2& fb_scale)
     }
 }
 
+// Range of the vertices referenced by 'count' indices (count > 0). Independent accumulators keep the loop from waiting on each comparison.
+static void ImDrawIdxRange(const ImDrawIdx* idx, unsigned int count, unsigned int* out_min, unsigned int* out_max)
+{
+    ImDrawIdx min0 = idx[0], min1 = idx[0], min2 = idx[0], min3 = idx[0];
+    ImDrawIdx max0 = idx[0], max1 = idx[0], max2 = idx[0], max3 = idx[0];
+    unsigned int n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        min0 = ImMin(min0, idx[n + 0]); max0 = ImMax(max0, idx[n + 0]);
+        min1 = ImMin(min1, idx[n + 1]); max1 = ImMax(max1, idx[n + 1]);
+        min2 = ImMin(min2, idx[n + 2]); max2 = ImMax(max2, idx[n + 2]);
+        min3 = ImMin(min3, idx[n + 3]); max3 = ImMax(max3, idx[n + 3]);
+    }
+    for (; n < count; n++)
+    {
+        min0 = ImMin(min0, idx[n]);
+        max0 = ImMax(max0, idx[n]);
+    }
+    *out_min = ImMin(ImMin(min0, min1), ImMin(min2, min3));
+    *out_max = ImMax(ImMax(max0, max1), ImMax(max2, max3));
+}
+
+// Bounding box of 'count' vertices (count > 0)
+static void ImDrawVertBounds(const ImDrawVert* vtx, unsigned int count, ImVec2* out_min, ImVec2* out_max)
+{
+    ImVec2 min0 = vtx[0].pos, min1 = min0, max0 = min0, max1 = min0;
+    unsigned int n = 0;
+    for (; n + 2 <= count; n += 2)
+    {
+        min0 = ImMin(min0, vtx[n + 0].pos); max0 = ImMax(max0, vtx[n + 0].pos);
+        min1 = ImMin(min1, vtx[n + 1].pos); max1 = ImMax(max1, vtx[n + 1].pos);
+    }
+    if (n < count)
+    {
+        min0 = ImMin(min0, vtx[n].pos);
+        max0 = ImMax(max0, vtx[n].pos);
+    }
+    *out_min = ImMin(min0, min1);
+    *out_max = ImMax(max0, max1);
+}
+
+// Helper to cut the number of draw calls, called after Render(): concatenate all lists into 'out_list' and merge consecutive commands.
+// - Vertices are copied in list order. Each output command draws from its own VtxOffset: the indices of the commands merged into it are
+//   rebased onto it, which with 16-bit indices limits a command to 64K vertices (a new command is started past that).
+// - Without ImDrawListFlags_AllowVtxOffset (the renderer doesn't handle VtxOffset) every output command has VtxOffset 0 and indices
+//   relative to the start of out_list. With 16-bit indices that requires fewer than 64K vertices in total, else false is returned.
+// - Two commands merge when they use the same texture and either the same clip rectangle, or both of them have all their visible vertices
+//   within their clip rectangle (rounded inward to whole pixels): then the union of the two rectangles doesn't clip anything either.
+// - Commands without indices, or whose clip rectangle doesn't intersect the display, are dropped. The others are clipped to the display.
+// - Callbacks are copied as they are, and end the command being merged.
+// - Lists with the same ContentHash as the last ones merged into 'out_list' are not merged again.
+bool ImDrawData::MergeCmdLists(ImDrawList* out_list)
+{
+    int cmd_count = 0;
+    for (int n = 0; n < CmdListsCount; n++)
+        cmd_count += CmdLists[n]->CmdBuffer.Size;
+    CmdCountBeforeMerge = CmdCountAfterMerge = cmd_count;
+    if (CmdListsCount == 0)
+        return false;
+    const bool allow_vtx_offset = (CmdLists[0]->Flags & ImDrawListFlags_AllowVtxOffset) != 0;
+    const bool large_mesh = (sizeof(ImDrawIdx) == 2 && TotalVtxCount > 0xFFFF);
+    if (large_mesh && !allow_vtx_offset)
+        return false;
+    if (ContentHash != 0 && out_list->ContentHash == ContentHash)
+    {
+        CmdCountAfterMerge = out_list->CmdBuffer.Size;
+        return true;
+    }
+
+    out_list->CmdBuffer.resize(0);
+    out_list->IdxBuffer.resize(0);
+    out_list->VtxBuffer.resize(TotalVtxCount);
+    out_list->IdxBuffer.reserve(TotalIdxCount);
+    out_list->Flags = CmdLists[0]->Flags;
+    out_list->ContentHash = ContentHash;
+
+    const ImVec4 display_rect(DisplayPos.x, DisplayPos.y, DisplayPos.x + DisplaySize.x, DisplayPos.y + DisplaySize.y);
+    const unsigned int max_vtx_span = (sizeof(ImDrawIdx) == 2) ? 0xFFFF : 0xFFFFFFFF;
+    ImDrawCmd* merged_cmd = NULL;           // Last command of out_list, when following commands may be merged into it
+    bool merged_cmd_unclipped = false;      // Its vertices are all within its clip rectangle
+    unsigned int vtx_base = 0;              // Start of the current list vertices in out_list->VtxBuffer
+    for (int list_n = 0; list_n < CmdListsCount; list_n++)
+    {
+        const ImDrawList* cmd_list = CmdLists[list_n];
+        memcpy(out_list->VtxBuffer.Data + vtx_base, cmd_list->VtxBuffer.Data, (size_t)cmd_list->VtxBuffer.size_in_bytes());
+        for (int cmd_n = 0; cmd_n < cmd_list->CmdBuffer.Size; cmd_n++)
+        {
+            const ImDrawCmd* cmd = &cmd_list->CmdBuffer.Data[cmd_n];
+            if (cmd->UserCallback != NULL)
+            {
+                ImDrawCmd callback_cmd = *cmd;
+                callback_cmd.VtxOffset = allow_vtx_offset ? callback_cmd.VtxOffset + vtx_base : 0;
+                callback_cmd.IdxOffset = (unsigned int)out_list->IdxBuffer.Size;
+                out_list->CmdBuffer.push_back(callback_cmd);
+                merged_cmd = NULL;
+                continue;
+            }
+            const ImVec4 clip_rect(ImMax(cmd->ClipRect.x, display_rect.x), ImMax(cmd->ClipRect.y, display_rect.y), ImMin(cmd->ClipRect.z, display_rect.z), ImMin(cmd->ClipRect.w, display_rect.w));
+            if (cmd->ElemCount == 0 || clip_rect.x >= clip_rect.z || clip_rect.y >= clip_rect.w)
+                continue;
+
+            // Range and bounds of the vertices used by the command (what lies outside the display is never visible)
+            const ImDrawIdx* src_idx = cmd_list->IdxBuffer.Data + cmd->IdxOffset;
+            unsigned int vtx_min, vtx_max;
+            ImDrawIdxRange(src_idx, cmd->ElemCount, &vtx_min, &vtx_max);
+            const unsigned int cmd_vtx_offset = vtx_base + cmd->VtxOffset;
+            bool unclipped = (memcmp(&clip_rect, &display_rect, sizeof(ImVec4)) == 0);
+            if (!unclipped)
+            {
+                ImVec2 bb_min, bb_max;
+                ImDrawVertBounds(cmd_list->VtxBuffer.Data + cmd->VtxOffset + vtx_min, vtx_max - vtx_min + 1, &bb_min, &bb_max);
+                bb_min = ImMax(bb_min, ImVec2(display_rect.x, display_rect.y));
+                bb_max = ImMin(bb_max, ImVec2(display_rect.z, display_rect.w));
+                unclipped = bb_min.x >= ImCeil(clip_rect.x) && bb_min.y >= ImCeil(clip_rect.y) && bb_max.x <= ImFloor(clip_rect.z) && bb_max.y <= ImFloor(clip_rect.w);
+            }
+
+            bool merge = false;
+            if (merged_cmd != NULL && merged_cmd->TextureId == cmd->TextureId && cmd_vtx_offset + vtx_min >= merged_cmd->VtxOffset && cmd_vtx_offset + vtx_max - merged_cmd->VtxOffset <= max_vtx_span)
+            {
+                if (memcmp(&merged_cmd->ClipRect, &clip_rect, sizeof(ImVec4)) == 0)
+                    merge = true;
+                else if (merged_cmd_unclipped && unclipped)
+                    merge = true;
+            }
+            if (merge)
+            {
+                merged_cmd->ClipRect = ImVec4(ImMin(merged_cmd->ClipRect.x, clip_rect.x), ImMin(merged_cmd->ClipRect.y, clip_rect.y), ImMax(merged_cmd->ClipRect.z, clip_rect.z), ImMax(merged_cmd->ClipRect.w, clip_rect.w));
+                merged_cmd_unclipped &= unclipped;
+            }
+            else
+            {
+                ImDrawCmd new_cmd;
+                new_cmd.ClipRect = clip_rect;
+                new_cmd.TextureId = cmd->TextureId;
+                new_cmd.VtxOffset = allow_vtx_offset ? cmd_vtx_offset + vtx_min : 0;
+                new_cmd.IdxOffset = (unsigned int)out_list->IdxBuffer.Size;
+                out_list->CmdBuffer.push_back(new_cmd);
+                merged_cmd = &out_list->CmdBuffer.back();
+                merged_cmd_unclipped = unclipped;
+            }
+
+            // Rebase the indices onto the output command VtxOffset
+            const unsigned int idx_rebase = cmd_vtx_offset - merged_cmd->VtxOffset;
+            const int idx_write = out_list->IdxBuffer.Size;
+            out_list->IdxBuffer.resize(idx_write + (int)cmd->ElemCount);
+            ImDrawIdx* dst_idx = out_list->IdxBuffer.Data + idx_write;
+            for (unsigned int n = 0; n < cmd->ElemCount; n++)
+                dst_idx[n] = (ImDrawIdx)(src_idx[n] + idx_rebase);
+            merged_cmd->ElemCount += cmd->ElemCount;
+        }
+        vtx_base += (unsigned int)cmd_list->VtxBuffer.Size;
+    }
+    CmdCountAfterMerge = out_list->CmdBuffer.Size;
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 // [SECTION] Helpers ShadeVertsXXX functions
 //-----------------------------------------------------------------------------
@@ -2243,7 +2691,18 @@ bool    ImFontAtlas::Build()
     }
 
     // Build
-    return builder_io->FontBuilder_Build(this);
+    if (CacheFilename == NULL)
+        return builder_io->FontBuilder_Build(this);
+
+    // Load from the cache, or build and (re)write it
+    ImFontAtlasBuildInit(this); // Register the default custom rectangles before hashing them, as the builder would
+    const ImU64 cache_key = ImFontAtlasBuildCalcCacheKey(this);
+    if (ImFontAtlasBuildLoadCache(this, CacheFilename, cache_key))
+        return true;
+    if (!builder_io->FontBuilder_Build(this))
+        return false;
+    ImFontAtlasBuildSaveCache(this, CacheFilename, cache_key);
+    return true;
 }
 
 void    ImFontAtlasBuildMultiplyCalcLookupTable(unsigned char out_table[256], float in_brighten_factor)
@@ -2289,6 +2748,50 @@ struct ImFontBuildDstData
     ImBitVector         GlyphsSet;          // This is used to resolve collision when multiple sources are merged into a same destination font.
 };
 
+// Rasterization of a run of glyphs of one source font (see ImFontAtlasBuildWithStbTruetype() step 8)
+struct ImFontBuildRasterTask
+{
+    int                 SrcIndex;
+    int                 GlyphStart;
+    int                 GlyphCount;
+};
+
+struct ImFontBuildRasterJob
+{
+    ImFontAtlas*                    Atlas;
+    ImFontBuildSrcData*             SrcTmpArray;
+    const stbtt_pack_context*       PackContext;
+    ImVector<ImFontBuildRasterTask> Tasks;
+};
+
+// Glyph rectangles don't overlap, so tasks write to disjoint parts of the texture and can run on any thread.
+static void ImFontAtlasBuildRasterizeTask(void* task_data, int index)
+{
+    ImFontBuildRasterJob* job = (ImFontBuildRasterJob*)task_data;
+    const ImFontBuildRasterTask& task = job->Tasks[index];
+    const ImFontConfig& cfg = job->Atlas->ConfigData[task.SrcIndex];
+    ImFontBuildSrcData& src_tmp = job->SrcTmpArray[task.SrcIndex];
+
+    stbtt_pack_context spc = *job->PackContext; // stbtt_PackFontRangesRenderIntoRects() temporarily writes to the context
+    stbtt_pack_range range = src_tmp.PackRange;
+    range.array_of_unicode_codepoints += task.GlyphStart;
+    range.chardata_for_range += task.GlyphStart;
+    range.num_chars = task.GlyphCount;
+    stbrp_rect* rects = src_tmp.Rects + task.GlyphStart;
+    stbtt_PackFontRangesRenderIntoRects(&spc, &src_tmp.FontInfo, &range, 1, rects);
+
+    // Apply multiply operator
+    if (cfg.RasterizerMultiply != 1.0f)
+    {
+        unsigned char multiply_table[256];
+        ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table, cfg.RasterizerMultiply);
+        stbrp_rect* r = rects;
+        for (int glyph_i = 0; glyph_i < task.GlyphCount; glyph_i++, r++)
+            if (r->was_packed)
+                ImFontAtlasBuildMultiplyRectAlpha8(multiply_table, job->Atlas->TexPixelsAlpha8, r->x, r->y, r->w, r->h, job->Atlas->TexWidth * 1);
+    }
+}
+
 static void UnpackBitVectorToFlatIndexList(const ImBitVector* in, ImVector<int>* out)
 {
     IM_ASSERT(sizeof(in->Storage.Data[0]) == sizeof(int));
@@ -2485,26 +2988,39 @@ static bool ImFontAtlasBuildWithStbTruetype(ImFontAtlas* atlas)
     spc.height = atlas->TexHeight;
 
     // 8. Render/rasterize font characters into the texture
+    // With atlas->ParallelForFn, each source font is split into runs of glyphs rasterized on worker threads. Output is identical.
+    const int GLYPHS_PER_TASK = 64;
+    const bool parallel = (atlas->ParallelForFn != NULL && total_glyphs_count > GLYPHS_PER_TASK);
+    ImFontBuildAllocator allocator;
+    ImGui::GetAllocatorFunctions(&allocator.AllocFunc, &allocator.FreeFunc, &allocator.UserData);
+    ImFontBuildRasterJob raster_job;
+    raster_job.Atlas = atlas;
+    raster_job.SrcTmpArray = src_tmp_array.Data;
+    raster_job.PackContext = &spc;
     for (int src_i = 0; src_i < src_tmp_array.Size; src_i++)
     {
-        ImFontConfig& cfg = atlas->ConfigData[src_i];
         ImFontBuildSrcData& src_tmp = src_tmp_array[src_i];
-        if (src_tmp.GlyphsCount == 0)
-            continue;
-
-        stbtt_PackFontRangesRenderIntoRects(&spc, &src_tmp.FontInfo, &src_tmp.PackRange, 1, src_tmp.Rects);
-
-        // Apply multiply operator
-        if (cfg.RasterizerMultiply != 1.0f)
+        if (parallel)
+            src_tmp.FontInfo.userdata = &allocator;
+        const int glyphs_per_task = parallel ? GLYPHS_PER_TASK : src_tmp.GlyphsCount;
+        for (int glyph_i = 0; glyph_i < src_tmp.GlyphsCount; glyph_i += glyphs_per_task)
         {
-            unsigned char multiply_table[256];
-            ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table, cfg.RasterizerMultiply);
-            stbrp_rect* r = &src_tmp.Rects[0];
-            for (int glyph_i = 0; glyph_i < src_tmp.GlyphsCount; glyph_i++, r++)
-                if (r->was_packed)
-                    ImFontAtlasBuildMultiplyRectAlpha8(multiply_table, atlas->TexPixelsAlpha8, r->x, r->y, r->w, r->h, atlas->TexWidth * 1);
+            ImFontBuildRasterTask task;
+            task.SrcIndex = src_i;
+            task.GlyphStart = glyph_i;
+            task.GlyphCount = ImMin(glyphs_per_task, src_tmp.GlyphsCount - glyph_i);
+            raster_job.Tasks.push_back(task);
         }
-        src_tmp.Rects = NULL;
+    }
+    if (parallel)
+        atlas->ParallelForFn(atlas->ParallelForUserData, raster_job.Tasks.Size, ImFontAtlasBuildRasterizeTask, &raster_job);
+    else
+        for (int task_n = 0; task_n < raster_job.Tasks.Size; task_n++)
+            ImFontAtlasBuildRasterizeTask(&raster_job, task_n);
+    for (int src_i = 0; src_i < src_tmp_array.Size; src_i++)
+    {
+        src_tmp_array[src_i].FontInfo.userdata = NULL;
+        src_tmp_array[src_i].Rects = NULL;
     }
 
     // End packing
@@ -2782,6 +3298,245 @@ void ImFontAtlasBuildFinish(ImFontAtlas* atlas)
     }
 }
 
+// Cache of a built atlas (ImFontAtlas::CacheFilename)
+// - Layout: ImFontAtlasCacheHeader, texture pixels, X/Y of each custom rectangle, then for each font an ImFontAtlasCacheFont followed by its glyphs.
+// - Structures are stored as they are in memory, so a file is only valid for the build which wrote it: the key covers the layout of ImFontGlyph.
+// - The key hashes everything the builders read: font data, ImFontConfig, glyph ranges, custom rectangles and atlas settings.
+// - The header also stores a checksum of the whole file, so a corrupted file is rejected like a stale one.
+#define IM_FONT_ATLAS_CACHE_VERSION     2
+
+struct ImFontAtlasCacheHeader
+{
+    char        Magic[4];               // "ImFA"
+    ImU32       Version;                // IM_FONT_ATLAS_CACHE_VERSION
+    ImU64       Key;                    // ImFontAtlasBuildCalcCacheKey()
+    ImU64       Checksum;               // ImFontAtlasCacheChecksum()
+    int         TexWidth, TexHeight;
+    int         TexBytesPerPixel;       // 1 (TexPixelsAlpha8) or 4 (TexPixelsRGBA32)
+    int         TexPixelsUseColors;
+    ImVec2      TexUvWhitePixel;
+    ImVec4      TexUvLines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    int         CustomRectsCount;
+    int         FontsCount;
+};
+
+struct ImFontAtlasCacheFont
+{
+    float       FontSize;
+    float       Ascent, Descent;
+    int         MetricsTotalSurface;
+    int         EllipsisChar;
+    int         GlyphsCount;
+};
+
+// Hash of the header, with Checksum cleared, followed by the rest of the file
+static ImU64 ImFontAtlasCacheChecksum(const ImFontAtlasCacheHeader& header, const void* payload, size_t payload_size)
+{
+    ImFontAtlasCacheHeader header_copy = header;
+    header_copy.Checksum = 0;
+    return ImHashData64(payload, payload_size, ImHashData64(&header_copy, sizeof(header_copy)));
+}
+
+static int ImFontAtlasFindFontIndex(ImFontAtlas* atlas, const ImFont* font)
+{
+    for (int i = 0; i < atlas->Fonts.Size; i++)
+        if (atlas->Fonts[i] == font)
+            return i;
+    return -1;
+}
+
+// Fields are hashed one by one: the structures also hold pointers and padding.
+ImU64 ImFontAtlasBuildCalcCacheKey(ImFontAtlas* atlas)
+{
+    const int atlas_ints[] = { IM_FONT_ATLAS_CACHE_VERSION, (int)sizeof(ImFontGlyph), (int)sizeof(ImWchar), atlas->Flags, atlas->TexDesiredWidth, atlas->TexGlyphPadding, (int)atlas->FontBuilderFlags, atlas->Fonts.Size, atlas->ConfigData.Size, atlas->CustomRects.Size };
+    ImU64 key = ImHashData64(atlas_ints, sizeof(atlas_ints));
+    for (int i = 0; i < atlas->ConfigData.Size; i++)
+    {
+        const ImFontConfig& cfg = atlas->ConfigData[i];
+        const int cfg_ints[] = { cfg.FontDataSize, cfg.FontNo, cfg.OversampleH, cfg.OversampleV, cfg.PixelSnapH, cfg.MergeMode, (int)cfg.FontBuilderFlags, (int)cfg.EllipsisChar, ImFontAtlasFindFontIndex(atlas, cfg.DstFont) };
+        const float cfg_floats[] = { cfg.SizePixels, cfg.GlyphExtraSpacing.x, cfg.GlyphExtraSpacing.y, cfg.GlyphOffset.x, cfg.GlyphOffset.y, cfg.GlyphMinAdvanceX, cfg.GlyphMaxAdvanceX, cfg.RasterizerMultiply };
+        key = ImHashData64(cfg_ints, sizeof(cfg_ints), key);
+        key = ImHashData64(cfg_floats, sizeof(cfg_floats), key);
+        key = ImHashData64(cfg.FontData, (size_t)cfg.FontDataSize, key);
+        const ImWchar* ranges = cfg.GlyphRanges ? cfg.GlyphRanges : atlas->GetGlyphRangesDefault();
+        int ranges_size = 0;
+        while (ranges[ranges_size] && ranges[ranges_size + 1])
+            ranges_size += 2;
+        key = ImHashData64(ranges, ranges_size * sizeof(ImWchar), key);
+    }
+    for (int i = 0; i < atlas->CustomRects.Size; i++)
+    {
+        const ImFontAtlasCustomRect& r = atlas->CustomRects[i];
+        const int rect_ints[] = { r.Width, r.Height, (int)r.GlyphID, ImFontAtlasFindFontIndex(atlas, r.Font) };
+        const float rect_floats[] = { r.GlyphAdvanceX, r.GlyphOffset.x, r.GlyphOffset.y };
+        key = ImHashData64(rect_ints, sizeof(rect_ints), key);
+        key = ImHashData64(rect_floats, sizeof(rect_floats), key);
+    }
+    return key;
+}
+
+// The whole file is validated before the atlas is touched: a stale, truncated or foreign file leaves it as it was.
+static bool ImFontAtlasBuildLoadCacheFromMemory(ImFontAtlas* atlas, const char* data, size_t data_size, ImU64 key)
+{
+    ImFontAtlasCacheHeader header;
+    if (data_size < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.Magic, "ImFA", 4) != 0 || header.Version != IM_FONT_ATLAS_CACHE_VERSION || header.Key != key)
+        return false;
+    if (header.TexWidth <= 0 || header.TexHeight <= 0 || (header.TexBytesPerPixel != 1 && header.TexBytesPerPixel != 4))
+        return false;
+    if (header.CustomRectsCount != atlas->CustomRects.Size || header.FontsCount != atlas->Fonts.Size)
+        return false;
+
+    const size_t pixels_size = (size_t)header.TexWidth * (size_t)header.TexHeight * (size_t)header.TexBytesPerPixel;
+    const size_t pixels_offset = sizeof(header);
+    const size_t rects_offset = pixels_offset + pixels_size;
+    const size_t fonts_offset = rects_offset + (size_t)header.CustomRectsCount * sizeof(unsigned short) * 2;
+    size_t offset = fonts_offset;
+    for (int i = 0; i < header.FontsCount; i++)
+    {
+        ImFontAtlasCacheFont font_header;
+        if (offset + sizeof(font_header) > data_size)
+            return false;
+        memcpy(&font_header, data + offset, sizeof(font_header));
+        if (font_header.GlyphsCount < 0 || font_header.GlyphsCount >= 0xFFFF)
+            return false;
+        offset += sizeof(font_header) + (size_t)font_header.GlyphsCount * sizeof(ImFontGlyph);
+    }
+    if (offset != data_size)
+        return false;
+    if (ImFontAtlasCacheChecksum(header, data + sizeof(header), data_size - sizeof(header)) != header.Checksum)
+        return false;
+
+    // Texture
+    atlas->ClearTexData();
+    atlas->TexID = (ImTextureID)NULL;
+    atlas->TexWidth = header.TexWidth;
+    atlas->TexHeight = header.TexHeight;
+    atlas->TexUvScale = ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+    atlas->TexUvWhitePixel = header.TexUvWhitePixel;
+    memcpy(atlas->TexUvLines, header.TexUvLines, sizeof(atlas->TexUvLines));
+    void* pixels = IM_ALLOC(pixels_size);
+    memcpy(pixels, data + pixels_offset, pixels_size);
+    if (header.TexBytesPerPixel == 1)
+        atlas->TexPixelsAlpha8 = (unsigned char*)pixels;
+    else
+        atlas->TexPixelsRGBA32 = (unsigned int*)pixels;
+    atlas->TexPixelsUseColors = header.TexPixelsUseColors != 0;
+
+    // Custom rectangles
+    const char* rects_data = data + rects_offset;
+    for (int i = 0; i < atlas->CustomRects.Size; i++, rects_data += sizeof(unsigned short) * 2)
+    {
+        memcpy(&atlas->CustomRects[i].X, rects_data, sizeof(unsigned short));
+        memcpy(&atlas->CustomRects[i].Y, rects_data + sizeof(unsigned short), sizeof(unsigned short));
+    }
+
+    // Fonts (same ConfigData/ConfigDataCount setup as ImFontAtlasBuildSetupFont())
+    offset = fonts_offset;
+    for (int i = 0; i < atlas->Fonts.Size; i++)
+    {
+        ImFontAtlasCacheFont font_header;
+        memcpy(&font_header, data + offset, sizeof(font_header));
+        offset += sizeof(font_header);
+
+        ImFont* font = atlas->Fonts[i];
+        font->ClearOutputData();
+        font->ContainerAtlas = atlas;
+        font->FontSize = font_header.FontSize;
+        font->Ascent = font_header.Ascent;
+        font->Descent = font_header.Descent;
+        font->MetricsTotalSurface = font_header.MetricsTotalSurface;
+        font->EllipsisChar = (ImWchar)font_header.EllipsisChar;
+        font->ConfigDataCount = 0;
+        font->Glyphs.resize(font_header.GlyphsCount);
+        if (font_header.GlyphsCount > 0)
+            memcpy(font->Glyphs.Data, data + offset, (size_t)font->Glyphs.size_in_bytes());
+        offset += (size_t)font->Glyphs.size_in_bytes();
+    }
+    for (int i = 0; i < atlas->ConfigData.Size; i++)
+    {
+        ImFontConfig* cfg = &atlas->ConfigData[i];
+        if (!cfg->MergeMode)
+            cfg->DstFont->ConfigData = cfg;
+        cfg->DstFont->ConfigDataCount++;
+    }
+    for (int i = 0; i < atlas->Fonts.Size; i++)
+        atlas->Fonts[i]->BuildLookupTable();
+    return true;
+}
+
+bool ImFontAtlasBuildLoadCache(ImFontAtlas* atlas, const char* filename, ImU64 key)
+{
+    size_t file_size = 0;
+    char* file_data = (char*)ImFileLoadToMemory(filename, "rb", &file_size);
+    if (file_data == NULL)
+        return false;
+    const bool ret = ImFontAtlasBuildLoadCacheFromMemory(atlas, file_data, file_size, key);
+    IM_FREE(file_data);
+    return ret;
+}
+
+static void ImFontAtlasCacheAppend(ImVector<char>* buf, const void* data, size_t data_size)
+{
+    if (data_size == 0)
+        return;
+    const int offset = buf->Size;
+    buf->resize(offset + (int)data_size);
+    memcpy(buf->Data + offset, data, data_size);
+}
+
+bool ImFontAtlasBuildSaveCache(ImFontAtlas* atlas, const char* filename, ImU64 key)
+{
+    IM_ASSERT(atlas->IsBuilt());
+    ImFontAtlasCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, "ImFA", 4);
+    header.Version = IM_FONT_ATLAS_CACHE_VERSION;
+    header.Key = key;
+    header.TexWidth = atlas->TexWidth;
+    header.TexHeight = atlas->TexHeight;
+    header.TexBytesPerPixel = atlas->TexPixelsAlpha8 ? 1 : 4; // Store the format the builder produced
+    header.TexPixelsUseColors = atlas->TexPixelsUseColors ? 1 : 0;
+    header.TexUvWhitePixel = atlas->TexUvWhitePixel;
+    memcpy(header.TexUvLines, atlas->TexUvLines, sizeof(header.TexUvLines));
+    header.CustomRectsCount = atlas->CustomRects.Size;
+    header.FontsCount = atlas->Fonts.Size;
+
+    // Gather the rest of the file first: the header holds its checksum
+    ImVector<char> payload;
+    const void* pixels = atlas->TexPixelsAlpha8 ? (const void*)atlas->TexPixelsAlpha8 : (const void*)atlas->TexPixelsRGBA32;
+    ImFontAtlasCacheAppend(&payload, pixels, (size_t)atlas->TexWidth * atlas->TexHeight * header.TexBytesPerPixel);
+    for (int i = 0; i < atlas->CustomRects.Size; i++)
+    {
+        const unsigned short rect_pos[2] = { atlas->CustomRects[i].X, atlas->CustomRects[i].Y };
+        ImFontAtlasCacheAppend(&payload, rect_pos, sizeof(rect_pos));
+    }
+    for (int i = 0; i < atlas->Fonts.Size; i++)
+    {
+        const ImFont* font = atlas->Fonts[i];
+        ImFontAtlasCacheFont font_header;
+        font_header.FontSize = font->FontSize;
+        font_header.Ascent = font->Ascent;
+        font_header.Descent = font->Descent;
+        font_header.MetricsTotalSurface = font->MetricsTotalSurface;
+        font_header.EllipsisChar = (int)font->EllipsisChar;
+        font_header.GlyphsCount = font->Glyphs.Size;
+        ImFontAtlasCacheAppend(&payload, &font_header, sizeof(font_header));
+        ImFontAtlasCacheAppend(&payload, font->Glyphs.Data, (size_t)font->Glyphs.size_in_bytes());
+    }
+    header.Checksum = ImFontAtlasCacheChecksum(header, payload.Data, (size_t)payload.Size);
+
+    ImFileHandle f = ImFileOpen(filename, "wb");
+    if (f == NULL)
+        return false;
+    bool ret = ImFileWrite(&header, sizeof(header), 1, f) == 1;
+    ret &= ImFileWrite(payload.Data, (ImU64)payload.Size, 1, f) == 1;
+    ImFileClose(f);
+    return ret;
+}
+
 // Retrieve list of range (2 int per range, values are inclusive)
 const ImWchar*   ImFontAtlas::GetGlyphRangesDefault()
 {
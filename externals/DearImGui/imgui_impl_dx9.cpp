@@ -11,6 +11,11 @@
 
 // CHANGELOG
 // (minor and older changes stripped away, please see git history for details)
+//  2026-10-18: DirectX9: Draw from a single list where consecutive commands are merged across windows (ImDrawData::MergeCmdLists()). Callbacks receive that list.
+//  2026-10-18: DirectX9: Reuse the vertex/index buffers uploaded for a previous frame when ImDrawData::ContentHash hasn't changed.
+//  2026-10-18: DirectX9: SSE2 vertex conversion. With IMGUI_USE_BGRA_PACKED_COLOR, vertices are copied as-is and read through a vertex declaration.
+//  2026-10-18: DirectX9: Record fixed render state and the state to back up into state blocks once per device instead of a D3DSBT_ALL block every frame.
+//  2026-10-18: DirectX9: Added ImGui_ImplDX9_SetBufferAllocator() to draw from vertex/index memory supplied by the application.
 //  2021-03-18: DirectX9: Calling IDirect3DStateBlock9::Capture() after CreateStateBlock() as a workaround for state restoring issues (see #3857).
 //  2021-03-03: DirectX9: Added support for IMGUI_USE_BGRA_PACKED_COLOR in user's imconfig file.
 //  2021-02-18: DirectX9: Change blending equation to preserve alpha in output buffer.
@@ -31,12 +36,35 @@
 // DirectX
 #include <d3d9.h>
 
+// SSE2 is always there on x64, and with /arch:SSE2 (the default since VS2012) on x86
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define IMGUI_IMPL_DX9_SSE2
+#include <emmintrin.h>
+#endif
+
+// With colors already in DX9 order and the default ImDrawVert layout, vertices are copied as-is and read through a vertex declaration
+#if defined(IMGUI_USE_BGRA_PACKED_COLOR) && !defined(IMGUI_OVERRIDE_DRAWVERT_STRUCT_LAYOUT)
+#define IMGUI_IMPL_DX9_DIRECT_VERTICES  1
+#else
+#define IMGUI_IMPL_DX9_DIRECT_VERTICES  0
+#endif
+
 // DirectX data
 static LPDIRECT3DDEVICE9        g_pd3dDevice = NULL;
 static LPDIRECT3DVERTEXBUFFER9  g_pVB = NULL;
 static LPDIRECT3DINDEXBUFFER9   g_pIB = NULL;
 static LPDIRECT3DTEXTURE9       g_FontTexture = NULL;
+static LPDIRECT3DSTATEBLOCK9    g_pFixedStateBlock = NULL;     // Our render state that never changes, applied with one call
+static LPDIRECT3DSTATEBLOCK9    g_pBackupStateBlock = NULL;    // Every state we touch, captured before rendering and applied after
+#if IMGUI_IMPL_DX9_DIRECT_VERTICES
+static LPDIRECT3DVERTEXDECLARATION9 g_pDrawVertDecl = NULL;
+static LPDIRECT3DVERTEXSHADER9  g_pDrawVertShader = NULL;      // NULL when the device can't run it: we fall back to converting vertices
+#endif
 static int                      g_VertexBufferSize = 5000, g_IndexBufferSize = 10000;
+static ImGui_ImplDX9_BufferAllocator g_Allocator = {};
+static ImU64                    g_UploadedHash = 0;            // ContentHash of what g_pVB/g_pIB hold, 0 if nothing reusable
+static ImU64                    g_LastHash = 0;                // ContentHash of the previous frame
+static ImDrawList*              g_MergedDrawList = NULL;       // Output of ImDrawData::MergeCmdLists(), what we draw from
 
 struct CUSTOMVERTEX
 {
@@ -52,17 +80,81 @@ struct CUSTOMVERTEX
 #define IMGUI_COL_TO_DX9_ARGB(_COL)     (((_COL) & 0xFF00FF00) | (((_COL) & 0xFF0000) >> 16) | (((_COL) & 0xFF) << 16))
 #endif
 
-static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data)
+#if IMGUI_IMPL_DX9_DIRECT_VERTICES
+// ImDrawVert as it is: float2 position (z=0, w=1 filled in by the declaration), float2 uv, D3DCOLOR
+static const D3DVERTEXELEMENT9 g_DrawVertElements[] =
 {
-    // Setup viewport
-    D3DVIEWPORT9 vp;
-    vp.X = vp.Y = 0;
-    vp.Width = (DWORD)draw_data->DisplaySize.x;
-    vp.Height = (DWORD)draw_data->DisplaySize.y;
-    vp.MinZ = 0.0f;
-    vp.MaxZ = 1.0f;
-    g_pd3dDevice->SetViewport(&vp);
+    { 0, (WORD)IM_OFFSETOF(ImDrawVert, pos), D3DDECLTYPE_FLOAT2,   D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
+    { 0, (WORD)IM_OFFSETOF(ImDrawVert, uv),  D3DDECLTYPE_FLOAT2,   D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0 },
+    { 0, (WORD)IM_OFFSETOF(ImDrawVert, col), D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR,    0 },
+    D3DDECL_END()
+};
 
+// The fixed pipeline needs a float3 position, so a float2 one goes through this vs_1_1 shader (c0-c3: transposed projection)
+static const DWORD g_DrawVertShaderCode[] =
+{
+    0xFFFE0101,                                     // vs_1_1
+    0x0000001F, 0x80000000, 0x900F0000,             // dcl_position v0
+    0x0000001F, 0x80000005, 0x900F0001,             // dcl_texcoord v1
+    0x0000001F, 0x8000000A, 0x900F0002,             // dcl_color v2
+    0x00000014, 0xC00F0000, 0x90E40000, 0xA0E40000, // m4x4 oPos, v0, c0
+    0x00000001, 0xD00F0000, 0x90E40002,             // mov oD0, v2
+    0x00000001, 0xE00F0000, 0x90E40001,             // mov oT0, v1
+    0x0000FFFF
+};
+#endif
+
+static bool ImGui_ImplDX9_UseDirectVertices()
+{
+#if IMGUI_IMPL_DX9_DIRECT_VERTICES
+    return g_pDrawVertShader != NULL;
+#else
+    return false;
+#endif
+}
+
+// Convert ImDrawVert to CUSTOMVERTEX: add a zero z, swizzle the color to D3DCOLOR order, move the uv behind it.
+static void ImGui_ImplDX9_ConvertVertices(CUSTOMVERTEX* dst, const ImDrawVert* src, int count)
+{
+    int i = 0;
+#if defined(IMGUI_IMPL_DX9_SSE2) && !defined(IMGUI_OVERRIDE_DRAWVERT_STRUCT_LAYOUT)
+    // 4 vertices at a time: colors are swizzled together, then each vertex is one 16-byte load of pos+uv and two stores.
+    // Colors travel through float registers, but shuffles and moves never alter the bits.
+    const __m128i zero = _mm_setzero_si128();
+#ifndef IMGUI_USE_BGRA_PACKED_COLOR
+    const __m128i mask_ag = _mm_set1_epi32((int)0xFF00FF00);
+    const __m128i mask_b = _mm_set1_epi32(0xFF);
+#endif
+    for (; i + 4 <= count; i += 4, src += 4, dst += 4)
+    {
+        __m128i col = _mm_setr_epi32((int)src[0].col, (int)src[1].col, (int)src[2].col, (int)src[3].col);
+#ifndef IMGUI_USE_BGRA_PACKED_COLOR
+        col = _mm_or_si128(_mm_and_si128(col, mask_ag), _mm_or_si128(_mm_and_si128(_mm_srli_epi32(col, 16), mask_b), _mm_slli_epi32(_mm_and_si128(col, mask_b), 16)));
+#endif
+        const __m128 z_col01 = _mm_castsi128_ps(_mm_unpacklo_epi32(zero, col));  // 0 c0 0 c1
+        const __m128 z_col23 = _mm_castsi128_ps(_mm_unpackhi_epi32(zero, col));  // 0 c2 0 c3
+        const __m128 z_col[4] = { z_col01, _mm_movehl_ps(z_col01, z_col01), z_col23, _mm_movehl_ps(z_col23, z_col23) };
+        for (int k = 0; k < 4; k++)
+        {
+            const __m128 pos_uv = _mm_loadu_ps(&src[k].pos.x);                  // x y u v
+            _mm_storeu_ps(dst[k].pos, _mm_movelh_ps(pos_uv, z_col[k]));         // x y 0 col
+            _mm_storeh_pi((__m64*)dst[k].uv, pos_uv);                           // u v
+        }
+    }
+#endif
+    for (; i < count; i++, src++, dst++)
+    {
+        dst->pos[0] = src->pos.x;
+        dst->pos[1] = src->pos.y;
+        dst->pos[2] = 0.0f;
+        dst->col = IMGUI_COL_TO_DX9_ARGB(src->col);
+        dst->uv[0] = src->uv.x;
+        dst->uv[1] = src->uv.y;
+    }
+}
+
+static void ImGui_ImplDX9_SetupFixedRenderState()
+{
     // Setup render state: fixed-pipeline, alpha-blending, no face culling, no depth testing, shade mode (for gradient)
     g_pd3dDevice->SetPixelShader(NULL);
     g_pd3dDevice->SetVertexShader(NULL);
@@ -88,6 +180,52 @@ static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data)
     g_pd3dDevice->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
     g_pd3dDevice->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
     g_pd3dDevice->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+    g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
+}
+
+// Record the state blocks. While recording, Set calls only go into the block and leave the device untouched.
+static bool ImGui_ImplDX9_CreateStateBlocks()
+{
+    if (g_pd3dDevice->BeginStateBlock() < 0)
+        return false;
+    ImGui_ImplDX9_SetupFixedRenderState();
+    if (g_pd3dDevice->EndStateBlock(&g_pFixedStateBlock) < 0)
+        return false;
+
+    // Capture() on a recorded block only reads back the states recorded in it, so backing up the application's state
+    // costs the same however much state the device has. The values here don't matter.
+    if (g_pd3dDevice->BeginStateBlock() < 0)
+        return false;
+    ImGui_ImplDX9_SetupFixedRenderState();
+    D3DVIEWPORT9 vp = { 0, 0, 1, 1, 0.0f, 1.0f };
+    const RECT r = { 0, 0, 1, 1 };
+    g_pd3dDevice->SetViewport(&vp);
+    g_pd3dDevice->SetScissorRect(&r);
+    g_pd3dDevice->SetTexture(0, NULL);
+    g_pd3dDevice->SetStreamSource(0, NULL, 0, 0);
+    g_pd3dDevice->SetIndices(NULL);
+#if IMGUI_IMPL_DX9_DIRECT_VERTICES
+    const float zero[16] = {};
+    g_pd3dDevice->SetVertexShaderConstantF(0, zero, 4);
+#endif
+    if (g_pd3dDevice->EndStateBlock(&g_pBackupStateBlock) < 0)
+        return false;
+    return true;
+}
+
+static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data)
+{
+    // Setup viewport
+    D3DVIEWPORT9 vp;
+    vp.X = vp.Y = 0;
+    vp.Width = (DWORD)draw_data->DisplaySize.x;
+    vp.Height = (DWORD)draw_data->DisplaySize.y;
+    vp.MinZ = 0.0f;
+    vp.MaxZ = 1.0f;
+    g_pd3dDevice->SetViewport(&vp);
+
+    // Setup render state (recorded by ImGui_ImplDX9_CreateStateBlocks)
+    g_pFixedStateBlock->Apply();
 
     // Setup orthographic projection matrix
     // Our visible imgui space lies from draw_data->DisplayPos (top left) to draw_data->DisplayPos+data_data->DisplaySize (bottom right). DisplayPos is (0,0) for single viewport apps.
@@ -108,41 +246,90 @@ static void ImGui_ImplDX9_SetupRenderState(ImDrawData* draw_data)
         g_pd3dDevice->SetTransform(D3DTS_WORLD, &mat_identity);
         g_pd3dDevice->SetTransform(D3DTS_VIEW, &mat_identity);
         g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &mat_projection);
+#if IMGUI_IMPL_DX9_DIRECT_VERTICES
+        if (g_pDrawVertShader)
+        {
+            float constants[4][4];
+            for (int i = 0; i < 4; i++)
+                for (int j = 0; j < 4; j++)
+                    constants[i][j] = mat_projection.m[j][i];
+            g_pd3dDevice->SetVertexDeclaration(g_pDrawVertDecl);
+            g_pd3dDevice->SetVertexShader(g_pDrawVertShader);
+            g_pd3dDevice->SetVertexShaderConstantF(0, &constants[0][0], 4);
+        }
+#endif
     }
 }
 
-// Render function.
-void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
+// Lock room for all vertices and indices of the frame, from the application's allocator when there is one, else from our own buffers.
+// Only our own buffers keep their content from one frame to the next, so 'keep' asks for them.
+static bool ImGui_ImplDX9_LockBuffers(ImDrawData* draw_data, unsigned int vtx_stride, bool keep, LPDIRECT3DVERTEXBUFFER9* vb, LPDIRECT3DINDEXBUFFER9* ib, unsigned int* vtx_first, unsigned int* idx_first, void** vtx_dst, void** idx_dst)
 {
-    // Avoid rendering when minimized
-    if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f)
-        return;
+    if (g_Allocator.LockVertices && !keep && draw_data->TotalVtxCount > 0 && draw_data->TotalIdxCount > 0)
+    {
+        if (g_Allocator.LockVertices(g_Allocator.UserData, (unsigned int)draw_data->TotalVtxCount, vtx_stride, vb, vtx_first, vtx_dst))
+        {
+            if (g_Allocator.LockIndices(g_Allocator.UserData, (unsigned int)draw_data->TotalIdxCount, sizeof(ImDrawIdx), ib, idx_first, idx_dst))
+                return true;
+            g_Allocator.UnlockVertices(g_Allocator.UserData);
+        }
+    }
+
+    // Whatever our buffers held is about to be replaced
+    g_UploadedHash = 0;
 
     // Create and grow buffers if needed
     if (!g_pVB || g_VertexBufferSize < draw_data->TotalVtxCount)
     {
         if (g_pVB) { g_pVB->Release(); g_pVB = NULL; }
         g_VertexBufferSize = draw_data->TotalVtxCount + 5000;
-        if (g_pd3dDevice->CreateVertexBuffer(g_VertexBufferSize * sizeof(CUSTOMVERTEX), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFVF_CUSTOMVERTEX, D3DPOOL_DEFAULT, &g_pVB, NULL) < 0)
-            return;
+        if (g_pd3dDevice->CreateVertexBuffer(g_VertexBufferSize * vtx_stride, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, vtx_stride == sizeof(CUSTOMVERTEX) ? D3DFVF_CUSTOMVERTEX : 0, D3DPOOL_DEFAULT, &g_pVB, NULL) < 0)
+            return false;
     }
     if (!g_pIB || g_IndexBufferSize < draw_data->TotalIdxCount)
     {
         if (g_pIB) { g_pIB->Release(); g_pIB = NULL; }
         g_IndexBufferSize = draw_data->TotalIdxCount + 10000;
         if (g_pd3dDevice->CreateIndexBuffer(g_IndexBufferSize * sizeof(ImDrawIdx), D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, sizeof(ImDrawIdx) == 2 ? D3DFMT_INDEX16 : D3DFMT_INDEX32, D3DPOOL_DEFAULT, &g_pIB, NULL) < 0)
-            return;
+            return false;
+    }
+    if (g_pVB->Lock(0, (UINT)(draw_data->TotalVtxCount * vtx_stride), vtx_dst, D3DLOCK_DISCARD) < 0)
+        return false;
+    if (g_pIB->Lock(0, (UINT)(draw_data->TotalIdxCount * sizeof(ImDrawIdx)), idx_dst, D3DLOCK_DISCARD) < 0)
+    {
+        g_pVB->Unlock();
+        return false;
     }
+    *vb = g_pVB;
+    *ib = g_pIB;
+    *vtx_first = *idx_first = 0;
+    return true;
+}
 
-    // Backup the DX9 state
-    IDirect3DStateBlock9* d3d9_state_block = NULL;
-    if (g_pd3dDevice->CreateStateBlock(D3DSBT_ALL, &d3d9_state_block) < 0)
-        return;
-    if (d3d9_state_block->Capture() < 0)
+static void ImGui_ImplDX9_UnlockBuffers(LPDIRECT3DVERTEXBUFFER9 vb, LPDIRECT3DINDEXBUFFER9 ib)
+{
+    if (vb == g_pVB)
     {
-        d3d9_state_block->Release();
-        return;
+        g_pVB->Unlock();
+        g_pIB->Unlock();
+    }
+    else
+    {
+        g_Allocator.UnlockVertices(g_Allocator.UserData);
+        g_Allocator.UnlockIndices(g_Allocator.UserData);
     }
+}
+
+// Render function.
+void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
+{
+    // Avoid rendering when minimized
+    if (draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f)
+        return;
+
+    // Backup the DX9 state
+    if (!g_pBackupStateBlock || g_pBackupStateBlock->Capture() < 0)
+        return;
 
     // Backup the DX9 transform (DX9 documentation suggests that it is included in the StateBlock but it doesn't appear to)
     D3DMATRIX last_world, last_view, last_projection;
@@ -150,51 +337,69 @@ void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
     g_pd3dDevice->GetTransform(D3DTS_VIEW, &last_view);
     g_pd3dDevice->GetTransform(D3DTS_PROJECTION, &last_projection);
 
+    // Merge consecutive draw commands, across lists too, to issue fewer draw calls
+    ImDrawList* const* cmd_lists = draw_data->CmdLists;
+    int cmd_lists_count = draw_data->CmdListsCount;
+    if (g_MergedDrawList && draw_data->MergeCmdLists(g_MergedDrawList))
+    {
+        cmd_lists = &g_MergedDrawList;
+        cmd_lists_count = 1;
+    }
+
     // Copy and convert all vertices into a single contiguous buffer, convert colors to DX9 default format.
-    // FIXME-OPT: This is a minor waste of resource, the ideal is to use imconfig.h and
-    //  1) to avoid repacking colors:   #define IMGUI_USE_BGRA_PACKED_COLOR
-    //  2) to avoid repacking vertices: #define IMGUI_OVERRIDE_DRAWVERT_STRUCT_LAYOUT struct ImDrawVert { ImVec2 pos; float z; ImU32 col; ImVec2 uv; }
-    CUSTOMVERTEX* vtx_dst;
-    ImDrawIdx* idx_dst;
-    if (g_pVB->Lock(0, (UINT)(draw_data->TotalVtxCount * sizeof(CUSTOMVERTEX)), (void**)&vtx_dst, D3DLOCK_DISCARD) < 0)
-        return;
-    if (g_pIB->Lock(0, (UINT)(draw_data->TotalIdxCount * sizeof(ImDrawIdx)), (void**)&idx_dst, D3DLOCK_DISCARD) < 0)
-        return;
-    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    // (With IMGUI_USE_BGRA_PACKED_COLOR and a vertex shader available, ImDrawVert is copied unchanged instead)
+    // Nothing is uploaded when our buffers already hold this frame's content (see ImDrawData::ContentHash).
+    const bool direct_vertices = ImGui_ImplDX9_UseDirectVertices();
+    const unsigned int vtx_stride = direct_vertices ? sizeof(ImDrawVert) : sizeof(CUSTOMVERTEX);
+    const ImU64 hash = draw_data->ContentHash;
+    LPDIRECT3DVERTEXBUFFER9 vb;
+    LPDIRECT3DINDEXBUFFER9 ib;
+    unsigned int vtx_first, idx_first;
+    if (hash != 0 && hash == g_UploadedHash && g_pVB && g_pIB)
+    {
+        vb = g_pVB;
+        ib = g_pIB;
+        vtx_first = idx_first = 0;
+    }
+    else
     {
-        const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        const ImDrawVert* vtx_src = cmd_list->VtxBuffer.Data;
-        for (int i = 0; i < cmd_list->VtxBuffer.Size; i++)
+        // Content that stayed the same for two frames is likely to stay: it goes into our own buffers, where the next frames can reuse it.
+        char* vtx_dst;
+        ImDrawIdx* idx_dst;
+        const bool keep = (hash != 0 && hash == g_LastHash);
+        if (!ImGui_ImplDX9_LockBuffers(draw_data, vtx_stride, keep, &vb, &ib, &vtx_first, &idx_first, (void**)&vtx_dst, (void**)&idx_dst))
+            return;
+        for (int n = 0; n < cmd_lists_count; n++)
         {
-            vtx_dst->pos[0] = vtx_src->pos.x;
-            vtx_dst->pos[1] = vtx_src->pos.y;
-            vtx_dst->pos[2] = 0.0f;
-            vtx_dst->col = IMGUI_COL_TO_DX9_ARGB(vtx_src->col);
-            vtx_dst->uv[0] = vtx_src->uv.x;
-            vtx_dst->uv[1] = vtx_src->uv.y;
-            vtx_dst++;
-            vtx_src++;
+            const ImDrawList* cmd_list = cmd_lists[n];
+            if (direct_vertices)
+                memcpy(vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+            else
+                ImGui_ImplDX9_ConvertVertices((CUSTOMVERTEX*)vtx_dst, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size);
+            vtx_dst += cmd_list->VtxBuffer.Size * vtx_stride;
+            memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+            idx_dst += cmd_list->IdxBuffer.Size;
         }
-        memcpy(idx_dst, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
-        idx_dst += cmd_list->IdxBuffer.Size;
+        ImGui_ImplDX9_UnlockBuffers(vb, ib);
+        if (vb == g_pVB)
+            g_UploadedHash = hash;
     }
-    g_pVB->Unlock();
-    g_pIB->Unlock();
-    g_pd3dDevice->SetStreamSource(0, g_pVB, 0, sizeof(CUSTOMVERTEX));
-    g_pd3dDevice->SetIndices(g_pIB);
-    g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
+    g_LastHash = hash;
+    g_pd3dDevice->SetStreamSource(0, vb, 0, vtx_stride);
+    g_pd3dDevice->SetIndices(ib);
 
     // Setup desired DX state
     ImGui_ImplDX9_SetupRenderState(draw_data);
 
     // Render command lists
     // (Because we merged all buffers into a single one, we maintain our own offset into them)
-    int global_vtx_offset = 0;
-    int global_idx_offset = 0;
+    // (With an allocator our part of the buffers starts at vtx_first/idx_first)
+    int global_vtx_offset = (int)vtx_first;
+    int global_idx_offset = (int)idx_first;
     ImVec2 clip_off = draw_data->DisplayPos;
-    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    for (int n = 0; n < cmd_lists_count; n++)
     {
-        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        const ImDrawList* cmd_list = cmd_lists[n];
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
             const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
@@ -226,8 +431,7 @@ void ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data)
     g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &last_projection);
 
     // Restore the DX9 state
-    d3d9_state_block->Apply();
-    d3d9_state_block->Release();
+    g_pBackupStateBlock->Apply();
 }
 
 bool ImGui_ImplDX9_Init(IDirect3DDevice9* device)
@@ -239,12 +443,15 @@ bool ImGui_ImplDX9_Init(IDirect3DDevice9* device)
 
     g_pd3dDevice = device;
     g_pd3dDevice->AddRef();
+    g_MergedDrawList = IM_NEW(ImDrawList)(NULL);
     return true;
 }
 
 void ImGui_ImplDX9_Shutdown()
 {
     ImGui_ImplDX9_InvalidateDeviceObjects();
+    g_Allocator = ImGui_ImplDX9_BufferAllocator();
+    if (g_MergedDrawList) { IM_DELETE(g_MergedDrawList); g_MergedDrawList = NULL; }
     if (g_pd3dDevice) { g_pd3dDevice->Release(); g_pd3dDevice = NULL; }
 }
 
@@ -289,12 +496,30 @@ static bool ImGui_ImplDX9_CreateFontsTexture()
     return true;
 }
 
+void ImGui_ImplDX9_SetBufferAllocator(const ImGui_ImplDX9_BufferAllocator* allocator)
+{
+    if (allocator)
+        g_Allocator = *allocator;
+    else
+        g_Allocator = ImGui_ImplDX9_BufferAllocator();
+}
+
 bool ImGui_ImplDX9_CreateDeviceObjects()
 {
     if (!g_pd3dDevice)
         return false;
     if (!ImGui_ImplDX9_CreateFontsTexture())
         return false;
+    if (!ImGui_ImplDX9_CreateStateBlocks())
+        return false;
+#if IMGUI_IMPL_DX9_DIRECT_VERTICES
+    // Optional: without vertex shader support we keep converting vertices
+    if (g_pd3dDevice->CreateVertexDeclaration(g_DrawVertElements, &g_pDrawVertDecl) < 0 || g_pd3dDevice->CreateVertexShader(g_DrawVertShaderCode, &g_pDrawVertShader) < 0)
+    {
+        if (g_pDrawVertDecl) { g_pDrawVertDecl->Release(); g_pDrawVertDecl = NULL; }
+        g_pDrawVertShader = NULL;
+    }
+#endif
     return true;
 }
 
@@ -304,6 +529,13 @@ void ImGui_ImplDX9_InvalidateDeviceObjects()
         return;
     if (g_pVB) { g_pVB->Release(); g_pVB = NULL; }
     if (g_pIB) { g_pIB->Release(); g_pIB = NULL; }
+    g_UploadedHash = g_LastHash = 0;
+    if (g_pFixedStateBlock) { g_pFixedStateBlock->Release(); g_pFixedStateBlock = NULL; }
+    if (g_pBackupStateBlock) { g_pBackupStateBlock->Release(); g_pBackupStateBlock = NULL; }
+#if IMGUI_IMPL_DX9_DIRECT_VERTICES
+    if (g_pDrawVertDecl) { g_pDrawVertDecl->Release(); g_pDrawVertDecl = NULL; }
+    if (g_pDrawVertShader) { g_pDrawVertShader->Release(); g_pDrawVertShader = NULL; }
+#endif
     if (g_FontTexture) { g_FontTexture->Release(); g_FontTexture = NULL; ImGui::GetIO().Fonts->SetTexID(NULL); } // We copied g_pFontTextureView to io.Fonts->TexID so let's clear that as well.
 }
 
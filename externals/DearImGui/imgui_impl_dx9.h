@@ -13,6 +13,8 @@
 #include "imgui.h"      // IMGUI_IMPL_API
 
 struct IDirect3DDevice9;
+struct IDirect3DVertexBuffer9;
+struct IDirect3DIndexBuffer9;
 
 IMGUI_IMPL_API bool     ImGui_ImplDX9_Init(IDirect3DDevice9* device);
 IMGUI_IMPL_API void     ImGui_ImplDX9_Shutdown();
@@ -22,3 +24,16 @@ IMGUI_IMPL_API void     ImGui_ImplDX9_RenderDrawData(ImDrawData* draw_data);
 // Use if you want to reset your rendering device without losing Dear ImGui state.
 IMGUI_IMPL_API bool     ImGui_ImplDX9_CreateDeviceObjects();
 IMGUI_IMPL_API void     ImGui_ImplDX9_InvalidateDeviceObjects();
+
+// Optional: draw from vertex/index memory supplied by the application, e.g. dynamic buffers shared with its other renderers.
+// Each frame locks room for all vertices and all indices at once; a Lock function returning false falls back to the backend's own buffers.
+// The returned buffers are bound as-is, so the vertex buffer must accept 'stride' and the index buffer must match 'index_size'.
+struct ImGui_ImplDX9_BufferAllocator
+{
+    void*   UserData;
+    bool    (*LockVertices)(void* user_data, unsigned int count, unsigned int stride, IDirect3DVertexBuffer9** out_buffer, unsigned int* out_first, void** out_data);
+    void    (*UnlockVertices)(void* user_data);
+    bool    (*LockIndices)(void* user_data, unsigned int count, unsigned int index_size, IDirect3DIndexBuffer9** out_buffer, unsigned int* out_first, void** out_data);
+    void    (*UnlockIndices)(void* user_data);
+};
+IMGUI_IMPL_API void     ImGui_ImplDX9_SetBufferAllocator(const ImGui_ImplDX9_BufferAllocator* allocator);    // NULL to go back to the backend's own buffers
@@ -124,6 +124,7 @@ struct ImGuiTableSettings;          // Storage for a table .ini settings
 struct ImGuiTableColumnsSettings;   // Storage for a column .ini settings
 struct ImGuiWindow;                 // Storage for one window
 struct ImGuiWindowTempData;         // Temporary storage for one window (that's the data which in theory we could ditch at the end of the frame)
+struct ImGuiWindowDrawCache;        // Retained contents of a window using ImGuiWindowFlags_CacheDrawList
 struct ImGuiWindowSettings;         // Storage for a window .ini settings (we keep one of those even if the actual window wasn't instanced during this session)
 
 // Use your programming IDE "Go to definition" facility on the names of the center columns to find the actual flags/enum lists.
@@ -258,6 +259,7 @@ namespace ImStb
 // - Helper: ImBitArray
 // - Helper: ImBitVector
 // - Helper: ImSpan<>, ImSpanAllocator<>
+// - Helper: ImGuiIDIndex
 // - Helper: ImPool<>
 // - Helper: ImChunkStream<>
 //-----------------------------------------------------------------------------
@@ -265,6 +267,7 @@ namespace ImStb
 // Helpers: Hashing
 IMGUI_API ImGuiID       ImHashData(const void* data, size_t data_size, ImU32 seed = 0);
 IMGUI_API ImGuiID       ImHashStr(const char* data, size_t data_size = 0, ImU32 seed = 0);
+IMGUI_API ImU64         ImHashData64(const void* data, size_t data_size, ImU64 seed = 0);
 #ifndef IMGUI_DISABLE_OBSOLETE_FUNCTIONS
 static inline ImGuiID   ImHash(const void* data, int size, ImU32 seed = 0) { return size ? ImHashData(data, (size_t)size, seed) : ImHashStr((const char*)data, 0, seed); } // [moved to ImHashStr/ImHashData in 1.68]
 #endif
@@ -566,6 +569,25 @@ struct ImSpanAllocator
     inline void  GetSpan(int n, ImSpan<T>* span)    { span->set((T*)GetSpanPtrBegin(n), (T*)GetSpanPtrEnd(n)); }
 };
 
+// Helper: ImGuiIDIndex
+// Hash map from ImGuiID to an int or a pointer. Lookups, insertions and removals are O(1) however many entries it holds, where ImGuiStorage
+// is O(Log N) to look up and O(N) to insert. Use where every entry gets looked up every frame, e.g. Begin() finding its window by ID.
+// Same hash table scheme as ImGuiStorage with IMGUI_USE_HASHED_STORAGE (see imgui.cpp).
+struct IMGUI_API ImGuiIDIndex
+{
+    ImVector<ImGuiStorage::ImGuiStoragePair>    Slots;      // Key and value of each slot. Size is a power of two, or 0.
+    ImVector<unsigned char>                     Ctrl;       // One byte per slot, plus a copy of the first 15. 0x80 = empty, else 7 bits of the key's hash.
+    int                                         Count;      // Number of used slots
+
+    ImGuiIDIndex()                                  { Count = 0; }
+    void        Clear()                             { Slots.clear(); Ctrl.clear(); Count = 0; }
+    int         GetInt(ImGuiID key, int default_val = 0) const;
+    void        SetInt(ImGuiID key, int val);
+    void*       GetVoidPtr(ImGuiID key) const;      // NULL if missing
+    void        SetVoidPtr(ImGuiID key, void* val);
+    void        Remove(ImGuiID key);
+};
+
 // Helper: ImPool<>
 // Basic keyed storage for contiguous instances, slow/amortized insertion, O(1) indexable, O(Log N) queries by ID over a dense/hot buffer,
 // Honor constructor/destructor. Add/remove invalidate all pointers. Indexes have the same lifetime as the associated object.
@@ -1321,7 +1343,7 @@ struct ImGuiContext
     ImVector<ImGuiWindow*>  WindowsFocusOrder;                  // Windows, sorted in focus order, back to front. (FIXME: We could only store root windows here! Need to sort out the Docking equivalent which is RootWindowDockStop and is unfortunately a little more dynamic)
     ImVector<ImGuiWindow*>  WindowsTempSortBuffer;              // Temporary buffer used in EndFrame() to reorder windows so parents are kept before their child
     ImVector<ImGuiWindow*>  CurrentWindowStack;
-    ImGuiStorage            WindowsById;                        // Map window's ImGuiID to ImGuiWindow*
+    ImGuiIDIndex            WindowsById;                        // Map window's ImGuiID to ImGuiWindow*
     int                     WindowsActiveCount;                 // Number of unique windows submitted by frame
     ImVec2                  WindowsHoverPadding;                // Padding around resizable windows for which hovering on counts as hovering the window == ImMax(style.TouchExtraPadding, WINDOWS_HOVER_PADDING)
     ImGuiWindow*            CurrentWindow;                      // Window being drawn into
@@ -1441,6 +1463,7 @@ struct ImGuiContext
     // Render
     float                   DimBgRatio;                         // 0.0..1.0 animation when fading in a dimming background (for modal window and CTRL+TAB list)
     ImGuiMouseCursor        MouseCursor;
+    ImVector<ImDrawList*>   DeferredDrawLists;                  // Temporary buffer used in Render() to tessellate deferred window draw lists (io.ConfigDeferredDrawLists)
 
     // Drag and Drop
     bool                    DragDropActive;
@@ -1473,6 +1496,7 @@ struct ImGuiContext
     ImPool<ImGuiTabBar>             TabBars;
     ImVector<ImGuiPtrOrIndex>       CurrentTabBarStack;
     ImVector<ImGuiShrinkWidthItem>  ShrinkWidthBuffer;
+    ImVector<ImVec2>                PlotLODPoints;      // Points of the polyline drawn by PlotLODEx()
 
     // Widget state
     ImVec2                  LastValidMousePos;
@@ -1506,6 +1530,7 @@ struct ImGuiContext
     ImGuiTextBuffer         SettingsIniData;                    // In memory .ini settings
     ImVector<ImGuiSettingsHandler>      SettingsHandlers;       // List of .ini settings handlers
     ImChunkStream<ImGuiWindowSettings>  SettingsWindows;        // ImGuiWindow .ini settings entries
+    ImGuiIDIndex                        SettingsWindowsById;    // Map window settings' ImGuiID to their offset in SettingsWindows
     ImChunkStream<ImGuiTableSettings>   SettingsTables;         // ImGuiTable .ini settings entries
     ImVector<ImGuiContextHook>          Hooks;                  // Hooks for extensions (e.g. test engine)
     ImGuiID                             HookIdNext;             // Next available HookId
@@ -1745,6 +1770,58 @@ struct IMGUI_API ImGuiWindowTempData
     ImGuiStackSizes         StackSizesOnBegin;      // Store size of various stacks for asserting
 };
 
+// One draw command of ImGuiWindowDrawCache
+struct ImGuiWindowDrawCacheCmd
+{
+    ImVec4                  ClipRect;
+    ImTextureID             TextureId;
+    ImDrawCallback          UserCallback;
+    void*                   UserCallbackData;
+    int                     VtxOffset;              // Start of the vertices in ImGuiWindowDrawCache::VtxBuffer
+    int                     VtxCount;
+    int                     IdxOffset;              // Start of the indices in ImGuiWindowDrawCache::IdxBuffer, relative to VtxOffset
+    int                     ElemCount;
+};
+
+// State the contents recorded by ImGuiWindowDrawCache depend on: replaying them requires the same one (compared with memcmp, so it is cleared first)
+struct ImGuiWindowDrawCacheKey
+{
+    ImVec2                  Size;
+    ImVec2                  Scroll;
+    ImRect                  InnerClipRect;          // Relative to window->Pos
+    ImRect                  WorkRect;               // Relative to window->Pos
+    ImGuiWindowFlags        Flags;
+    ImGuiItemFlags          ItemFlags;
+    ImGuiID                 StyleHash;
+    ImFont*                 Font;
+    float                   FontSize;
+    ImTextureID             FontTexId;
+    ImGuiID                 NavId;                  // g.NavId when the navigation highlight may be displayed in the window, otherwise 0
+};
+
+// Retained contents of a window using ImGuiWindowFlags_CacheDrawList.
+// Begin() records what the contents add to the window draw list (not the decorations). On the next frames, as long as nothing that
+// could change them happened, it replays those vertices translated by how much the window moved, and skips the contents (SkipItems).
+struct IMGUI_API ImGuiWindowDrawCache
+{
+    bool                    Valid;                  // Buffers hold a complete recording
+    bool                    Recording;              // Between Begin() and End() of a frame recording the contents
+    bool                    Dirty;                  // Set by MarkWindowDrawCacheDirty()
+    bool                    Hovered;                // Mouse was over one of the InteractRects when recording (the contents may show it)
+    int                     RecordCmdStart;         // Draw list buffer sizes when recording started
+    int                     RecordIdxStart;
+    ImVec2                  Pos;                    // window->Pos when recording. Buffers are in absolute coordinates of that time.
+    ImGuiWindowDrawCacheKey Key;
+    ImVec2                  CursorMaxPos;           // Relative to DC.CursorStartPos, restored when replaying so the content size doesn't change
+    ImVec2                  IdealMaxPos;
+    ImVector<ImGuiWindowDrawCacheCmd> CmdBuffer;
+    ImVector<ImDrawVert>    VtxBuffer;
+    ImVector<ImDrawIdx>     IdxBuffer;
+    ImVector<ImRect>        InteractRects;          // Rectangles the contents tested the mouse against (clipped, with style.TouchExtraPadding): hovering one ends replaying
+
+    ImGuiWindowDrawCache()  { memset(this, 0, sizeof(*this)); }
+};
+
 // Storage for one window
 struct IMGUI_API ImGuiWindow
 {
@@ -1836,6 +1913,7 @@ struct IMGUI_API ImGuiWindow
     int                     MemoryDrawListIdxCapacity;          // Backup of last idx/vtx count, so when waking up the window we can preallocate and avoid iterative alloc/copy
     int                     MemoryDrawListVtxCapacity;
     bool                    MemoryCompacted;                    // Set when window extraneous data have been garbage collected
+    ImGuiWindowDrawCache*   DrawCache;                          // Allocated when the window uses ImGuiWindowFlags_CacheDrawList
 
 public:
     ImGuiWindow(ImGuiContext* context, const char* name);
@@ -2519,6 +2597,7 @@ namespace ImGui
 
     // Plot
     IMGUI_API int           PlotEx(ImGuiPlotType plot_type, const char* label, float (*values_getter)(void* data, int idx), void* data, int values_count, int values_offset, const char* overlay_text, float scale_min, float scale_max, ImVec2 frame_size);
+    IMGUI_API int           PlotLODEx(ImGuiPlotType plot_type, const char* label, const ImGuiPlotPyramid* pyramid, ImGuiPlotDownsample downsample, int values_offset, const char* overlay_text, float scale_min, float scale_max, ImVec2 frame_size);
 
     // Shade functions (write over already created vertices)
     IMGUI_API void          ShadeVertsLinearColorGradientKeepAlpha(ImDrawList* draw_list, int vert_start_idx, int vert_end_idx, ImVec2 gradient_p0, ImVec2 gradient_p1, ImU32 col0, ImU32 col1);
@@ -2570,6 +2649,9 @@ IMGUI_API void      ImFontAtlasBuildRender8bppRectFromString(ImFontAtlas* atlas,
 IMGUI_API void      ImFontAtlasBuildRender32bppRectFromString(ImFontAtlas* atlas, int x, int y, int w, int h, const char* in_str, char in_marker_char, unsigned int in_marker_pixel_value);
 IMGUI_API void      ImFontAtlasBuildMultiplyCalcLookupTable(unsigned char out_table[256], float in_multiply_factor);
 IMGUI_API void      ImFontAtlasBuildMultiplyRectAlpha8(const unsigned char table[256], unsigned char* pixels, int x, int y, int w, int h, int stride);
+IMGUI_API ImU64     ImFontAtlasBuildCalcCacheKey(ImFontAtlas* atlas);
+IMGUI_API bool      ImFontAtlasBuildLoadCache(ImFontAtlas* atlas, const char* filename, ImU64 key);
+IMGUI_API bool      ImFontAtlasBuildSaveCache(ImFontAtlas* atlas, const char* filename, ImU64 key);
 
 //-----------------------------------------------------------------------------
 // [SECTION] Test Engine specific hooks (imgui_test_engine)
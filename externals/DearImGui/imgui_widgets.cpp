@@ -5228,6 +5228,9 @@ bool ImGui::ColorPicker4(const char* label, float col[4], ImGuiColorEditFlags fl
         // Render Hue Wheel
         const float aeps = 0.5f / wheel_r_outer; // Half a pixel arc length in radians (2pi cancels out).
         const int segment_per_arc = ImMax(4, (int)wheel_r_outer / 12);
+        const ImDrawListFlags backup_flags = draw_list->Flags; // Vertices are painted right after being output, they can't be deferred
+        draw_list->_FlushDeferred();
+        draw_list->Flags &= ~ImDrawListFlags_Deferred;
         for (int n = 0; n < 6; n++)
         {
             const float a0 = (n)     /6.0f * 2.0f * IM_PI - aeps;
@@ -5242,6 +5245,7 @@ bool ImGui::ColorPicker4(const char* label, float col[4], ImGuiColorEditFlags fl
             ImVec2 gradient_p1(wheel_center.x + ImCos(a1) * wheel_r_inner, wheel_center.y + ImSin(a1) * wheel_r_inner);
             ShadeVertsLinearColorGradientKeepAlpha(draw_list, vert_start_idx, vert_end_idx, gradient_p0, gradient_p1, col_hues[n], col_hues[n + 1]);
         }
+        draw_list->Flags = backup_flags;
 
         // Render Cursor + preview on Hue Wheel
         float cos_hue_angle = ImCos(H * 2.0f * IM_PI);
@@ -6286,6 +6290,10 @@ bool ImGui::ListBox(const char* label, int* current_item, bool (*items_getter)(v
 // - PlotEx() [Internal]
 // - PlotLines()
 // - PlotHistogram()
+// - ImGuiPlotPyramid
+// - PlotLODEx() [Internal]
+// - PlotLinesLOD()
+// - PlotHistogramLOD()
 //-------------------------------------------------------------------------
 // Plot/Graph widgets are not very good.
 // Consider writing your own, or using a third-party one, see:
@@ -6448,6 +6456,413 @@ void ImGui::PlotHistogram(const char* label, float (*values_getter)(void* data,
     PlotEx(ImGuiPlotType_Histogram, label, values_getter, data, values_count, values_offset, overlay_text, scale_min, scale_max, graph_size);
 }
 
+//-------------------------------------------------------------------------
+// ImGuiPlotPyramid, PlotLODEx
+//-------------------------------------------------------------------------
+
+// Number of values (level 0) or nodes (other levels) summarized by each node
+#define IM_PLOT_PYRAMID_FANOUT  8
+
+typedef ImGuiPlotPyramid::ImGuiPlotPyramidNode ImGuiPlotPyramidNode;
+
+static inline void PlotPyramidNodeClear(ImGuiPlotPyramidNode* node)
+{
+    node->Min = FLT_MAX;
+    node->Max = -FLT_MAX;
+    node->MinIdx = node->MaxIdx = -1;
+    node->Sum = 0.0f;
+    node->Count = 0;
+}
+
+static inline void PlotPyramidNodeAddValue(ImGuiPlotPyramidNode* node, float v, int idx)
+{
+    if (v != v) // Ignore NaN values
+        return;
+    if (v < node->Min) { node->Min = v; node->MinIdx = idx; }
+    if (v > node->Max) { node->Max = v; node->MaxIdx = idx; }
+    node->Sum += v;
+    node->Count++;
+}
+
+static inline void PlotPyramidNodeAddNode(ImGuiPlotPyramidNode* node, const ImGuiPlotPyramidNode& src)
+{
+    if (src.Count == 0)
+        return;
+    if (src.Min < node->Min) { node->Min = src.Min; node->MinIdx = src.MinIdx; }
+    if (src.Max > node->Max) { node->Max = src.Max; node->MaxIdx = src.MaxIdx; }
+    node->Sum += src.Sum;
+    node->Count += src.Count;
+}
+
+void ImGuiPlotPyramid::Build(const float* values, int values_count, int stride)
+{
+    Clear();
+    Values = values;
+    ValuesStride = stride;
+    ValuesCount = values_count;
+
+    // Allocate all levels, then fill them
+    int nodes_count = 0;
+    for (int level_count = values_count; level_count > 1 || (level_count == 1 && LevelStart.Size == 0); )
+    {
+        level_count = (level_count + IM_PLOT_PYRAMID_FANOUT - 1) / IM_PLOT_PYRAMID_FANOUT;
+        LevelStart.push_back(nodes_count);
+        nodes_count += level_count;
+    }
+    LevelStart.push_back(nodes_count);
+    Nodes.resize(nodes_count);
+    Update(0, values_count);
+}
+
+void ImGuiPlotPyramid::Build(float (*values_getter)(void* data, int idx), void* data, int values_count)
+{
+    Build(NULL, values_count, 0);
+    ValuesGetter = values_getter;
+    ValuesGetterData = data;
+    Update(0, values_count);
+}
+
+void ImGuiPlotPyramid::Update(int first, int count)
+{
+    IM_ASSERT(first >= 0 && count >= 0 && first + count <= ValuesCount);
+    if (count == 0 || (Values == NULL && ValuesGetter == NULL))
+        return;
+
+    // Level 0 from the values, then each level from the one below, only over the nodes covering the modified range
+    int node_first = first / IM_PLOT_PYRAMID_FANOUT;
+    int node_last = (first + count - 1) / IM_PLOT_PYRAMID_FANOUT;
+    for (int n = node_first; n <= node_last; n++)
+    {
+        ImGuiPlotPyramidNode* node = &Nodes[LevelStart[0] + n];
+        PlotPyramidNodeClear(node);
+        const int idx_end = ImMin((n + 1) * IM_PLOT_PYRAMID_FANOUT, ValuesCount);
+        for (int idx = n * IM_PLOT_PYRAMID_FANOUT; idx < idx_end; idx++)
+            PlotPyramidNodeAddValue(node, GetValue(idx), idx);
+    }
+    for (int level = 1; level < GetLevelsCount(); level++)
+    {
+        const ImGuiPlotPyramidNode* children = &Nodes[LevelStart[level - 1]];
+        const int children_count = LevelStart[level] - LevelStart[level - 1];
+        node_first /= IM_PLOT_PYRAMID_FANOUT;
+        node_last /= IM_PLOT_PYRAMID_FANOUT;
+        for (int n = node_first; n <= node_last; n++)
+        {
+            ImGuiPlotPyramidNode* node = &Nodes[LevelStart[level] + n];
+            PlotPyramidNodeClear(node);
+            const int child_end = ImMin((n + 1) * IM_PLOT_PYRAMID_FANOUT, children_count);
+            for (int child = n * IM_PLOT_PYRAMID_FANOUT; child < child_end; child++)
+                PlotPyramidNodeAddNode(node, children[child]);
+        }
+    }
+}
+
+// Walk up the levels from the values: at each level, add the units (values, then nodes) at both ends of the range until
+// it is aligned on the next level's nodes, then continue with those. The top level is added whole.
+void ImGuiPlotPyramid::Query(int first, int last, ImGuiPlotPyramidNode* out) const
+{
+    IM_ASSERT(first >= 0 && first <= last && last <= ValuesCount);
+    PlotPyramidNodeClear(out);
+    const int levels_count = GetLevelsCount();
+    int lo = first;
+    int hi = last;
+    for (int level = -1; lo < hi; level++) // Level -1 = the values
+    {
+        const bool has_next_level = (level + 1 < levels_count);
+        const int lo_end = has_next_level ? ImMin((lo + IM_PLOT_PYRAMID_FANOUT - 1) / IM_PLOT_PYRAMID_FANOUT * IM_PLOT_PYRAMID_FANOUT, hi) : hi;
+        const int hi_start = has_next_level ? ImMax(hi / IM_PLOT_PYRAMID_FANOUT * IM_PLOT_PYRAMID_FANOUT, lo_end) : hi;
+        if (level < 0)
+        {
+            for (int idx = lo; idx < lo_end; idx++)
+                PlotPyramidNodeAddValue(out, GetValue(idx), idx);
+            for (int idx = hi_start; idx < hi; idx++)
+                PlotPyramidNodeAddValue(out, GetValue(idx), idx);
+        }
+        else
+        {
+            const ImGuiPlotPyramidNode* nodes = &Nodes[LevelStart[level]];
+            for (int n = lo; n < lo_end; n++)
+                PlotPyramidNodeAddNode(out, nodes[n]);
+            for (int n = hi_start; n < hi; n++)
+                PlotPyramidNodeAddNode(out, nodes[n]);
+        }
+        lo = lo_end / IM_PLOT_PYRAMID_FANOUT;
+        hi = hi_start / IM_PLOT_PYRAMID_FANOUT;
+    }
+}
+
+// Summarize the values displayed at [first, last), the display starting at value 'values_offset' and wrapping around.
+// Indices in the summary are display indices.
+static void PlotLODQuery(const ImGuiPlotPyramid* pyramid, int values_offset, int first, int last, ImGuiPlotPyramidNode* out)
+{
+    const int values_count = pyramid->ValuesCount;
+    const int start = (first + values_offset) % values_count;
+    const int end = start + (last - first);
+    pyramid->Query(start, ImMin(end, values_count), out);
+    if (end > values_count)
+    {
+        ImGuiPlotPyramidNode wrapped;
+        pyramid->Query(0, end - values_count, &wrapped);
+        PlotPyramidNodeAddNode(out, wrapped);
+    }
+    if (out->Count > 0)
+    {
+        out->MinIdx = (out->MinIdx - values_offset + values_count) % values_count;
+        out->MaxIdx = (out->MaxIdx - values_offset + values_count) % values_count;
+    }
+}
+
+int ImGui::PlotLODEx(ImGuiPlotType plot_type, const char* label, const ImGuiPlotPyramid* pyramid, ImGuiPlotDownsample downsample, int values_offset, const char* overlay_text, float scale_min, float scale_max, ImVec2 frame_size)
+{
+    ImGuiContext& g = *GImGui;
+    ImGuiWindow* window = GetCurrentWindow();
+    if (window->SkipItems)
+        return -1;
+
+    const ImGuiStyle& style = g.Style;
+    const ImGuiID id = window->GetID(label);
+
+    const ImVec2 label_size = CalcTextSize(label, NULL, true);
+    if (frame_size.x == 0.0f)
+        frame_size.x = CalcItemWidth();
+    if (frame_size.y == 0.0f)
+        frame_size.y = label_size.y + (style.FramePadding.y * 2);
+
+    const ImRect frame_bb(window->DC.CursorPos, window->DC.CursorPos + frame_size);
+    const ImRect inner_bb(frame_bb.Min + style.FramePadding, frame_bb.Max - style.FramePadding);
+    const ImRect total_bb(frame_bb.Min, frame_bb.Max + ImVec2(label_size.x > 0.0f ? style.ItemInnerSpacing.x + label_size.x : 0.0f, 0));
+    ItemSize(total_bb, style.FramePadding.y);
+    if (!ItemAdd(total_bb, 0, &frame_bb))
+        return -1;
+    const bool hovered = ItemHoverable(frame_bb, id);
+
+    // Determine scale from the whole series if not specified, which only reads the top levels of the pyramid
+    const int values_count = pyramid->ValuesCount;
+    if (scale_min == FLT_MAX || scale_max == FLT_MAX)
+    {
+        ImGuiPlotPyramidNode all;
+        pyramid->Query(0, values_count, &all);
+        if (scale_min == FLT_MAX)
+            scale_min = all.Min;
+        if (scale_max == FLT_MAX)
+            scale_max = all.Max;
+    }
+
+    RenderFrame(frame_bb.Min, frame_bb.Max, GetColorU32(ImGuiCol_FrameBg), true, style.FrameRounding);
+
+    const int values_count_min = (plot_type == ImGuiPlotType_Lines) ? 2 : 1;
+    int idx_hovered = -1;
+    if (values_count >= values_count_min)
+    {
+        // One column per pixel, or per value when there are fewer values than pixels. Column n shows values [columns_first(n), columns_first(n + 1)).
+        const int columns = ImClamp((int)inner_bb.GetWidth(), 1, values_count);
+        #define PLOT_COLUMN_FIRST(N)    (int)((ImS64)(N) * values_count / columns)
+        values_offset = (values_offset % values_count + values_count) % values_count;
+        const float inv_scale = (scale_min == scale_max) ? 0.0f : (1.0f / (scale_max - scale_min));
+        #define PLOT_VALUE_Y(V)         ImLerp(inner_bb.Min.y, inner_bb.Max.y, 1.0f - ImSaturate(((V) - scale_min) * inv_scale))
+
+        const ImU32 col_base = GetColorU32((plot_type == ImGuiPlotType_Lines) ? ImGuiCol_PlotLines : ImGuiCol_PlotHistogram);
+        const ImU32 col_hovered = GetColorU32((plot_type == ImGuiPlotType_Lines) ? ImGuiCol_PlotLinesHovered : ImGuiCol_PlotHistogramHovered);
+
+        // Tooltip on hover
+        int column_hovered = -1;
+        if (hovered && inner_bb.Contains(g.IO.MousePos))
+        {
+            const float t = ImClamp((g.IO.MousePos.x - inner_bb.Min.x) / (inner_bb.Max.x - inner_bb.Min.x), 0.0f, 0.9999f);
+            column_hovered = (int)(t * columns);
+            const int v_first = PLOT_COLUMN_FIRST(column_hovered);
+            const int v_last = PLOT_COLUMN_FIRST(column_hovered + 1) - 1;
+            if (v_first == v_last)
+            {
+                SetTooltip("%d: %8.4g", v_first, pyramid->GetValue((v_first + values_offset) % values_count));
+            }
+            else
+            {
+                ImGuiPlotPyramidNode column;
+                PlotLODQuery(pyramid, values_offset, v_first, v_last + 1, &column);
+                if (column.Count > 0)
+                    SetTooltip("%d..%d:\nmin %8.4g (%d)\nmax %8.4g (%d)", v_first, v_last, column.Min, column.MinIdx, column.Max, column.MaxIdx);
+                else
+                    SetTooltip("%d..%d: NaN", v_first, v_last);
+            }
+            idx_hovered = v_first;
+        }
+
+        if (plot_type == ImGuiPlotType_Lines)
+        {
+            // Value 'idx' is drawn at x = idx / (values_count - 1), as PlotEx() does
+            const float x_scale = inner_bb.GetWidth() / (float)(values_count - 1);
+            ImVector<ImVec2>& points = g.PlotLODPoints;
+            points.resize(0);
+            int points_hovered_first = 0, points_hovered_end = 0;
+            #define PLOT_ADD_POINT(IDX, V)  do { const float v = (V); if (v == v) points.push_back(ImVec2(inner_bb.Min.x + (float)(IDX) * x_scale, PLOT_VALUE_Y(v))); } while (0)
+
+            if (downsample == ImGuiPlotDownsample_LTTB && values_count > columns + 2)
+            {
+                // Largest-Triangle-Three-Buckets: keep the first and last values, and from each bucket of values in between the one forming the
+                // largest triangle with the previous value kept and the average of the next bucket.
+                // Candidates are the min and max of each quarter of the bucket (or every value of small buckets), so the cost doesn't depend on the bucket size.
+                // As values within a bucket are within a pixel or so of each other horizontally, the largest triangle is almost always at one of those.
+                const int buckets = columns;
+                #define PLOT_BUCKET_FIRST(N)    (1 + (int)((ImS64)(N) * (values_count - 2) / buckets))
+                int a_idx = 0;
+                float a_v = pyramid->GetValue(values_offset);
+                PLOT_ADD_POINT(0, a_v);
+                for (int bucket = 0; bucket < buckets; bucket++)
+                {
+                    const int b_first = PLOT_BUCKET_FIRST(bucket);
+                    const int b_end = PLOT_BUCKET_FIRST(bucket + 1);
+                    if (b_first == b_end)
+                        continue;
+
+                    // Average of the next bucket, or the last value
+                    float c_idx = (float)(values_count - 1);
+                    float c_v = pyramid->GetValue((values_count - 1 + values_offset) % values_count);
+                    if (bucket + 1 < buckets)
+                    {
+                        const int c_first = b_end;
+                        const int c_end = PLOT_BUCKET_FIRST(bucket + 2);
+                        ImGuiPlotPyramidNode next;
+                        PlotLODQuery(pyramid, values_offset, c_first, c_end, &next);
+                        if (next.Count > 0)
+                        {
+                            c_idx = (float)(c_first + c_end - 1) * 0.5f;
+                            c_v = next.Sum / (float)next.Count;
+                        }
+                    }
+
+                    // Candidates
+                    int candidates[8];
+                    int candidates_count = 0;
+                    if (b_end - b_first <= IM_ARRAYSIZE(candidates))
+                    {
+                        for (int idx = b_first; idx < b_end; idx++)
+                            candidates[candidates_count++] = idx;
+                    }
+                    else
+                    {
+                        for (int quarter = 0; quarter < 4; quarter++)
+                        {
+                            ImGuiPlotPyramidNode q;
+                            PlotLODQuery(pyramid, values_offset, b_first + (b_end - b_first) * quarter / 4, b_first + (b_end - b_first) * (quarter + 1) / 4, &q);
+                            if (q.Count == 0)
+                                continue;
+                            candidates[candidates_count++] = q.MinIdx;
+                            if (q.MaxIdx != q.MinIdx)
+                                candidates[candidates_count++] = q.MaxIdx;
+                        }
+                    }
+
+                    int best_idx = -1;
+                    float best_v = 0.0f;
+                    float best_area = -1.0f;
+                    for (int n = 0; n < candidates_count; n++)
+                    {
+                        const float v = pyramid->GetValue((candidates[n] + values_offset) % values_count);
+                        if (v != v)
+                            continue;
+                        const float area = ImFabs(((float)a_idx - c_idx) * (v - a_v) - ((float)a_idx - (float)candidates[n]) * (c_v - a_v)); // Twice the area
+                        if (area > best_area)
+                        {
+                            best_area = area;
+                            best_idx = candidates[n];
+                            best_v = v;
+                        }
+                    }
+                    if (best_idx < 0)
+                        continue;
+                    if (PLOT_COLUMN_FIRST(column_hovered) <= best_idx && best_idx < PLOT_COLUMN_FIRST(column_hovered + 1))
+                    {
+                        if (points_hovered_end == 0)
+                            points_hovered_first = ImMax(points.Size - 1, 0);
+                        points_hovered_end = points.Size + 2;
+                    }
+                    PLOT_ADD_POINT(best_idx, best_v);
+                    a_idx = best_idx;
+                    a_v = best_v;
+                }
+                PLOT_ADD_POINT(values_count - 1, pyramid->GetValue((values_count - 1 + values_offset) % values_count));
+                #undef PLOT_BUCKET_FIRST
+            }
+            else
+            {
+                // Min/max: the first, min, max and last values of each column, in order. Connecting each column's last value to the next column's first one,
+                // this covers the same pixels as drawing every value.
+                for (int column = 0; column < columns; column++)
+                {
+                    const int v_first = PLOT_COLUMN_FIRST(column);
+                    const int v_last = PLOT_COLUMN_FIRST(column + 1) - 1;
+                    if (column == column_hovered)
+                        points_hovered_first = ImMax(points.Size - 1, 0);
+                    PLOT_ADD_POINT(v_first, pyramid->GetValue((v_first + values_offset) % values_count));
+                    if (v_last - v_first >= 2)
+                    {
+                        ImGuiPlotPyramidNode column_values;
+                        PlotLODQuery(pyramid, values_offset, v_first + 1, v_last, &column_values);
+                        if (column_values.Count > 0)
+                        {
+                            const bool min_first = column_values.MinIdx < column_values.MaxIdx;
+                            PLOT_ADD_POINT(min_first ? column_values.MinIdx : column_values.MaxIdx, min_first ? column_values.Min : column_values.Max);
+                            if (column_values.MinIdx != column_values.MaxIdx)
+                                PLOT_ADD_POINT(min_first ? column_values.MaxIdx : column_values.MinIdx, min_first ? column_values.Max : column_values.Min);
+                        }
+                    }
+                    if (v_last != v_first)
+                        PLOT_ADD_POINT(v_last, pyramid->GetValue((v_last + values_offset) % values_count));
+                    if (column == column_hovered)
+                        points_hovered_end = points.Size;
+                }
+            }
+            #undef PLOT_ADD_POINT
+
+            // NB: One polyline instead of PlotEx()'s line per value: the point count is bounded by the width, not by the series.
+            window->DrawList->AddPolyline(points.Data, points.Size, col_base, ImDrawFlags_None, 1.0f);
+            points_hovered_end = ImMin(points_hovered_end, points.Size);
+            if (points_hovered_end - points_hovered_first >= 2)
+                window->DrawList->AddPolyline(points.Data + points_hovered_first, points_hovered_end - points_hovered_first, col_hovered, ImDrawFlags_None, 1.0f);
+        }
+        else if (plot_type == ImGuiPlotType_Histogram)
+        {
+            // One bar per column, from the zero line to the column's max (or min, below the zero line)
+            const float histogram_zero_line_t = (scale_min * scale_max < 0.0f) ? (-scale_min * inv_scale) : (scale_min < 0.0f ? 0.0f : 1.0f);
+            const float zero_line_y = ImLerp(inner_bb.Min.y, inner_bb.Max.y, histogram_zero_line_t);
+            for (int column = 0; column < columns; column++)
+            {
+                ImGuiPlotPyramidNode column_values;
+                PlotLODQuery(pyramid, values_offset, PLOT_COLUMN_FIRST(column), PLOT_COLUMN_FIRST(column + 1), &column_values);
+                if (column_values.Count == 0)
+                    continue;
+                ImVec2 pos0(ImLerp(inner_bb.Min.x, inner_bb.Max.x, (float)column / columns), ImMin(PLOT_VALUE_Y(column_values.Max), zero_line_y));
+                ImVec2 pos1(ImLerp(inner_bb.Min.x, inner_bb.Max.x, (float)(column + 1) / columns), ImMax(PLOT_VALUE_Y(column_values.Min), zero_line_y));
+                if (pos1.x >= pos0.x + 2.0f)
+                    pos1.x -= 1.0f;
+                window->DrawList->AddRectFilled(pos0, pos1, column == column_hovered ? col_hovered : col_base);
+            }
+        }
+        #undef PLOT_COLUMN_FIRST
+        #undef PLOT_VALUE_Y
+    }
+
+    // Text overlay
+    if (overlay_text)
+        RenderTextClipped(ImVec2(frame_bb.Min.x, frame_bb.Min.y + style.FramePadding.y), frame_bb.Max, overlay_text, NULL, NULL, ImVec2(0.5f, 0.0f));
+
+    if (label_size.x > 0.0f)
+        RenderText(ImVec2(frame_bb.Max.x + style.ItemInnerSpacing.x, inner_bb.Min.y), label);
+
+    // Return the first value of the hovered column, or -1 if none is hovered.
+    return idx_hovered;
+}
+
+void ImGui::PlotLinesLOD(const char* label, const ImGuiPlotPyramid* pyramid, ImGuiPlotDownsample downsample, int values_offset, const char* overlay_text, float scale_min, float scale_max, ImVec2 graph_size)
+{
+    PlotLODEx(ImGuiPlotType_Lines, label, pyramid, downsample, values_offset, overlay_text, scale_min, scale_max, graph_size);
+}
+
+void ImGui::PlotHistogramLOD(const char* label, const ImGuiPlotPyramid* pyramid, int values_offset, const char* overlay_text, float scale_min, float scale_max, ImVec2 graph_size)
+{
+    PlotLODEx(ImGuiPlotType_Histogram, label, pyramid, ImGuiPlotDownsample_MinMax, values_offset, overlay_text, scale_min, scale_max, graph_size);
+}
+
 //-------------------------------------------------------------------------
 // [SECTION] Widgets: Value helpers
 // Those is not very useful, legacy API.